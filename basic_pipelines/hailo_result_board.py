@@ -0,0 +1,79 @@
+import mmap
+import os
+import struct
+
+
+# ---------------------------------------------------------
+# Lock-free reader for the per-stream result boards that
+# `inception_v3_hailo --shm-ring` publishes (inception_v3_result_board.hpp)
+# ---------------------------------------------------------
+
+BOARD_MAGIC = 0x49563342
+BOARD_VERSION = 1
+BOARD_SIZE = 256
+SEQUENCE_OFFSET = 64
+PAYLOAD_OFFSET = 72
+PAYLOAD_FORMAT = struct.Struct('<QQQII5i5f64s')
+
+
+def stream_board_name(prefix, stream_id):
+    return f"{prefix}.board.{stream_id}"
+
+
+class ResultBoardReader:
+    """
+    Read-only view of one stream's latest result.
+
+    Reads follow the seqlock protocol: the payload is copied and the copy is retried
+    if the writer was mid-update, so readers never block the inference service.
+
+    The service removes the boards of streams that went idle (or the least recently
+    used ones past its cap). A reader of a removed board keeps seeing its last
+    result; open the board again to follow the stream once it publishes again.
+    """
+
+    def __init__(self, board_name):
+        fd = os.open('/dev/shm/' + board_name.lstrip('/'), os.O_RDONLY)
+        try:
+            self.map = mmap.mmap(fd, BOARD_SIZE, prot=mmap.PROT_READ)
+        finally:
+            os.close(fd)
+
+        magic, version, payload_size = struct.unpack_from('<III', self.map, 0)
+        if magic != BOARD_MAGIC or version != BOARD_VERSION or payload_size != PAYLOAD_FORMAT.size:
+            raise RuntimeError(f"Result board {board_name} has an unexpected layout")
+
+    def _sequence(self):
+        return struct.unpack_from('<I', self.map, SEQUENCE_OFFSET)[0]
+
+    def read(self):
+        """
+        Returns:
+            dict with frame_seq, capture_time_ns, publish_time_ns, stream_id, label and
+            top_k as [(class_id, confidence), ...], or None if nothing was published yet.
+        """
+        while True:
+            before = self._sequence()
+            if before == 0:
+                return None
+            if before & 1:
+                continue
+            payload = self.map[PAYLOAD_OFFSET:PAYLOAD_OFFSET + PAYLOAD_FORMAT.size]
+            if self._sequence() == before:
+                break
+
+        fields = PAYLOAD_FORMAT.unpack(payload)
+        frame_seq, capture_ns, publish_ns, stream_id, count = fields[:5]
+        ids = fields[5:10]
+        confidences = fields[10:15]
+        return {
+            'frame_seq': frame_seq,
+            'capture_time_ns': capture_ns,
+            'publish_time_ns': publish_ns,
+            'stream_id': stream_id,
+            'label': fields[15].split(b'\0', 1)[0].decode(),
+            'top_k': list(zip(ids[:count], confidences[:count])),
+        }
+
+    def close(self):
+        self.map.close()
@@ -0,0 +1,125 @@
+import ctypes
+import os
+import numpy as np
+import gi
+gi.require_version('Gst', '1.0')
+from gi.repository import Gst
+
+
+# ---------------------------------------------------------
+# Producer side of the shared-memory frame ring served by
+# `inception_v3_hailo --shm-ring <ring_name> <hef_path>`
+# ---------------------------------------------------------
+
+SHM_WANT_RESULT = 1 << 0
+
+DEFAULT_LIB_PATH = os.path.join(os.path.dirname(os.path.abspath(__file__)), '../build.Release/libinception_v3_shm.so')
+
+
+def _load_library(lib_path):
+    lib = ctypes.CDLL(lib_path)
+    lib.inception_v3_shm_open.restype = ctypes.c_void_p
+    lib.inception_v3_shm_open.argtypes = [ctypes.c_char_p]
+    lib.inception_v3_shm_close.argtypes = [ctypes.c_void_p]
+    lib.inception_v3_shm_slot_size.restype = ctypes.c_uint32
+    lib.inception_v3_shm_slot_size.argtypes = [ctypes.c_void_p]
+    lib.inception_v3_shm_acquire.restype = ctypes.c_int
+    lib.inception_v3_shm_acquire.argtypes = [ctypes.c_void_p, ctypes.c_int]
+    lib.inception_v3_shm_slot_data.restype = ctypes.POINTER(ctypes.c_uint8)
+    lib.inception_v3_shm_slot_data.argtypes = [ctypes.c_void_p, ctypes.c_int]
+    lib.inception_v3_shm_submit.restype = ctypes.c_int
+    lib.inception_v3_shm_submit.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_uint32, ctypes.c_uint32, ctypes.c_uint32]
+    lib.inception_v3_shm_wait_result.restype = ctypes.c_int
+    lib.inception_v3_shm_wait_result.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_int,
+                                                 ctypes.POINTER(ctypes.c_float), ctypes.c_char_p, ctypes.c_size_t]
+    return lib
+
+
+class ShmRingProducer:
+    """
+    Writes frames straight into slots of the inference service's shared-memory ring.
+
+    Frames are never pickled or sent through a socket: either decode/resize into the
+    numpy view returned by slot_array(), or use submit_buffer() to move a mapped
+    GstBuffer into a slot with a single memmove.
+    """
+
+    def __init__(self, ring_name, lib_path=None):
+        self.lib = _load_library(lib_path or os.environ.get('INCEPTION_V3_SHM_LIB', DEFAULT_LIB_PATH))
+        self.ring = self.lib.inception_v3_shm_open(ring_name.encode())
+        if not self.ring:
+            raise RuntimeError(f"Cannot attach to shm ring {ring_name}")
+        self.slot_size = self.lib.inception_v3_shm_slot_size(self.ring)
+
+    def close(self):
+        if self.ring:
+            self.lib.inception_v3_shm_close(self.ring)
+            self.ring = None
+
+    def acquire(self, timeout_ms=1000):
+        """Returns a free slot index, or None if the ring stayed full for timeout_ms."""
+        slot = self.lib.inception_v3_shm_acquire(self.ring, timeout_ms)
+        return None if slot < 0 else slot
+
+    def slot_array(self, slot, shape=None):
+        """Numpy view over the slot memory; writes into it land directly in shared memory."""
+        data = self.lib.inception_v3_shm_slot_data(self.ring, slot)
+        view = np.ctypeslib.as_array(data, shape=(self.slot_size,))
+        return view if shape is None else view.reshape(shape)
+
+    def submit(self, slot, frame_size=None, stream_id=0, want_result=False):
+        flags = SHM_WANT_RESULT if want_result else 0
+        if self.lib.inception_v3_shm_submit(self.ring, slot, stream_id, frame_size or self.slot_size, flags) < 0:
+            raise RuntimeError(f"Shared-memory slot {slot} was reclaimed by the service before it was submitted")
+
+    def wait_result(self, slot, timeout_ms=1000):
+        """
+        Waits for a slot submitted with want_result=True and releases it.
+
+        Returns:
+            (label, confidence), (None, 0.0) below threshold, or None on timeout.
+
+        Raises:
+            RuntimeError: if the service could not classify the frame.
+        """
+        confidence = ctypes.c_float()
+        label = ctypes.create_string_buffer(64)
+        status = self.lib.inception_v3_shm_wait_result(self.ring, slot, timeout_ms, ctypes.byref(confidence), label, len(label))
+        if status == -2:
+            raise RuntimeError(f"Inference service failed the frame: {label.value.decode(errors='replace')}")
+        if status < 0:
+            return None
+        if status == 0:
+            return None, 0.0
+        return label.value.decode(), confidence.value
+
+    def submit_buffer(self, buffer, stream_id=0, want_result=False, timeout_ms=1000):
+        """
+        Moves a network-resolution GstBuffer into a slot with a single copy into shared memory.
+
+        Returns:
+            The slot index (pass it to wait_result when want_result is set), or None if no slot was free.
+        """
+        success, map_info = buffer.map(Gst.MapFlags.READ)
+        if not success:
+            raise ValueError("Buffer mapping failed")
+
+        try:
+            size = len(map_info.data)
+            if size > self.slot_size:
+                raise ValueError(f"Frame of {size} bytes does not fit a {self.slot_size} byte slot")
+            slot = self.acquire(timeout_ms)
+            if slot is None:
+                return None
+            np.copyto(self.slot_array(slot)[:size], np.frombuffer(map_info.data, dtype=np.uint8))
+        finally:
+            buffer.unmap(map_info)
+
+        self.submit(slot, size, stream_id, want_result)
+        return slot
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
@@ -1,6 +1,7 @@
 import gi
 gi.require_version('Gst', '1.0')
-from gi.repository import Gst
+gi.require_version('GstVideo', '1.0')
+from gi.repository import Gst, GstVideo
 
 import setproctitle
 import hailo
@@ -8,10 +9,18 @@ from hailo_common_funcs import get_numpy_from_buffer, disable_qos
 from hailo_rpi_common import get_default_parser, QUEUE, get_caps_from_pad, GStreamerApp, app_callback_class, display_user_data_frame
 
 import os
+import sys
 import hailo
 import numpy as np
 import cv2
 
+# Native label overlay from the pybind module (built with -DINCEPTION_V3_PYTHON=ON),
+# used with --native-overlay; by default the display branch uses hailooverlay.
+try:
+    import inception_v3 as inception_v3_native
+except ImportError:
+    inception_v3_native = None
+
 class user_app_callback_class(app_callback_class):
     def __init__(self):
         super().__init__()
@@ -21,6 +30,8 @@ class user_app_callback_class(app_callback_class):
         self.last_label = None 
         self.prev_roi = None
         self.orb = cv2.ORB_create()
+        self.overlay = None
+        self.metadata = None
 
 user_data = user_app_callback_class()
 
@@ -42,30 +53,162 @@ def app_callback(pad, info, user_data):
     print(f"\r frame {i}", flush=True, end="")
     i+=1
 
+    if user_data.metadata is not None:
+        draw_matched_result(pad, buffer, format, width, height, user_data)
+    elif user_data.overlay is not None:
+        draw_classification(pad, buffer, format, width, height, user_data.overlay)
+
     # current_frame = get_numpy_from_buffer(buffer, format, width, height)
     return Gst.PadProbeReturn.OK
 
+def get_plane_layout(pad, buffer):
+    """
+    Per-plane (offsets, strides) of a video buffer: from its GstVideoMeta when the
+    producer attached one (padded rows, chroma plane not right after the luma),
+    otherwise the defaults for the pad's caps.
+    """
+    meta = GstVideo.buffer_get_video_meta(buffer)
+    if meta is not None:
+        return list(meta.offset)[:meta.n_planes], list(meta.stride)[:meta.n_planes]
+    info = GstVideo.VideoInfo.new_from_caps(pad.get_current_caps())
+    planes = info.finfo.n_planes
+    return list(info.offset)[:planes], list(info.stride)[:planes]
+
+
+map_failures = 0
+def map_for_drawing(buffer):
+    """Maps buffer writable for the overlay; logs (rate-limited) and returns None when it cannot."""
+    global map_failures
+    success, map_info = buffer.map(Gst.MapFlags.READ | Gst.MapFlags.WRITE)
+    if success:
+        return map_info
+    # A shared or read-only buffer (e.g. a tee that kept a reference) cannot be
+    # drawn in place; the frame is shown without its label.
+    map_failures += 1
+    if map_failures == 1 or map_failures % 300 == 0:
+        print(f"\nnative overlay: could not map frame writable, {map_failures} frame(s) shown without a label",
+              file=sys.stderr, flush=True)
+    return None
+
+
+def draw_classification(pad, buffer, format, width, height, overlay):
+    roi = hailo.get_roi_from_buffer(buffer)
+    classifications = roi.get_objects_typed(hailo.HAILO_CLASSIFICATION)
+    if not classifications:
+        return
+    classification = classifications[0]
+
+    offsets, strides = get_plane_layout(pad, buffer)
+    map_info = map_for_drawing(buffer)
+    if map_info is None:
+        return
+    try:
+        overlay.draw(map_info.data, format, width, height,
+                     classification.get_label(), classification.get_confidence(),
+                     offsets=offsets, strides=strides)
+    finally:
+        buffer.unmap(map_info)
+
+
+# Full-resolution mode: the inference branch publishes each result keyed by the
+# PTS of the frame it came from ...
+def results_callback(pad, info, user_data):
+    buffer = info.get_buffer()
+    if buffer is None:
+        return Gst.PadProbeReturn.OK
+    classifications = hailo.get_roi_from_buffer(buffer).get_objects_typed(hailo.HAILO_CLASSIFICATION)
+    if classifications:
+        user_data.metadata.publish(buffer.pts, classifications[0].get_label(), classifications[0].get_confidence())
+    else:
+        # Below threshold: clear the label instead of leaving the previous one up.
+        user_data.metadata.publish(buffer.pts, "", 0.0)
+    return Gst.PadProbeReturn.OK
+
+# ... and the display branch draws the result of its own frame when inference has
+# already finished it, otherwise the latest one, never waiting for the network.
+def draw_matched_result(pad, buffer, format, width, height, user_data):
+    result = user_data.metadata.lookup(buffer.pts, max_lag=Gst.SECOND)
+    if result is None or not result[1]:
+        return
+
+    offsets, strides = get_plane_layout(pad, buffer)
+    map_info = map_for_drawing(buffer)
+    if map_info is None:
+        return
+    try:
+        user_data.overlay.draw(map_info.data, format, width, height, result[1], result[2],
+                               offsets=offsets, strides=strides)
+    finally:
+        buffer.unmap(map_info)
+
+
 class GStreamerInstanceSegmentationApp(GStreamerApp):
     def __init__(self, args, user_data):
         super().__init__(args, user_data)
 
+        # This graph classifies the camera. Recorded footage goes through the native
+        # tool, which decodes only the sampled frames instead of every frame.
+        if self.source_type == "file":
+            raise RuntimeError(f"{self.video_source} is a file: classify recorded video with "
+                               "inception_v3_video --sample keyframes|every=<N> (built with -DINCEPTION_V3_VIDEO=ON)")
+
         self.batch_size = 1
         self.network_width = 299
         self.network_height = 299
         self.network_format = "RGB"
     
+        # Built by this repo's CMake (inception_v3_filter.cpp); the copy next to the repo root still wins.
         self.default_postprocess_so = os.path.join(self.current_path, '../libinception_v3_inference.so')
+        if not os.path.exists(self.default_postprocess_so):
+            self.default_postprocess_so = os.path.join(self.current_path, '../build.Release/libinception_v3_inference.so')
+        # Labels and thresholds from this file are hot-reloaded by the post-process when it changes.
+        self.postprocess_config = os.environ.get('INCEPTION_V3_CONFIG')
 
         self.default_network_name = "inception_v3"
         self.hef_path = os.path.join(self.current_path, '../inception_v3.hef')
 
         self.app_callback = app_callback
+
+        # The native overlay draws in the identity probe, in the frame's own format,
+        # and glimagesink takes RGB and NV12 as they are, so the display branch needs
+        # neither hailooverlay nor the videoconvert that followed it.
+        self.native_overlay = args.native_overlay
+        if self.native_overlay:
+            if inception_v3_native is None:
+                raise RuntimeError("--native-overlay needs the inception_v3 Python module (-DINCEPTION_V3_PYTHON=ON)")
+            user_data.overlay = inception_v3_native.Overlay(os.path.join(self.current_path, '../imagenet_classes.txt'))
+            self.video_sink = "glimagesink"
+
+        # Full-resolution display: only a downscaled copy goes to the network, and
+        # results reach the camera frames through a PTS-keyed metadata map instead
+        # of hailomuxer pairing the two branches.
+        self.full_res = args.full_res
+        self.display_width = 1536
+        self.display_height = 864
+        self.display_format = "NV12"
+        if self.full_res:
+            if not self.native_overlay:
+                raise RuntimeError("--full-res needs --native-overlay")
+            user_data.metadata = inception_v3_native.MetadataMap(64)
         self.source_type = "rpi"
         setproctitle.setproctitle(" detection and tracking app")
 
         self.create_pipeline()
 
+        if self.full_res:
+            results = self.pipeline.get_by_name("identity_results")
+            results.get_static_pad("src").add_probe(Gst.PadProbeType.BUFFER, results_callback, user_data)
+
+    def get_postprocess_string(self):
+        postprocess = f"hailofilter function-name=infer so-path={self.default_postprocess_so} "
+        if self.postprocess_config:
+            postprocess += f"config-path={self.postprocess_config} "
+        return postprocess + "qos=false ! "
+
     def get_pipeline_string(self):
+        if self.full_res:
+            return self.get_full_res_pipeline_string()
+
         source_element = f"libcamerasrc name=src_0 auto-focus-mode=AfModeManual ! "
         source_element += f"video/x-raw, format={self.network_format}, width=1536, height=864 ! "
         source_element += QUEUE("queue_src_scale")
@@ -86,26 +229,55 @@ class GStreamerInstanceSegmentationApp(GStreamerApp):
         pipeline_string += "videoconvert n-threads=3 ! "
         
         pipeline_string += f"hailonet hef-path={self.hef_path} batch-size={self.batch_size} force-writable=true ! "
-        pipeline_string += f'hailofilter function-name=infer so-path={self.default_postprocess_so} qos=false ! '
+        pipeline_string += self.get_postprocess_string()
         
         pipeline_string += QUEUE("queue_hmuc") + " hmux.sink_1 "
         pipeline_string += "hmux. ! "
         
         pipeline_string += QUEUE("queue_user_callback")
         pipeline_string += f"identity name=identity_callback ! "
-        pipeline_string += QUEUE("queue_hailooverlay")
-        pipeline_string += f"hailooverlay ! "
-        
-        pipeline_string += QUEUE("queue_videoconvert")
-        pipeline_string += f"videoconvert n-threads=3 qos=false ! "
+        if not self.native_overlay:
+            pipeline_string += QUEUE("queue_hailooverlay")
+            pipeline_string += f"hailooverlay ! "
+
+            pipeline_string += QUEUE("queue_videoconvert")
+            pipeline_string += f"videoconvert n-threads=3 qos=false ! "
         pipeline_string += QUEUE("queue_hailo_display")
         pipeline_string += f"fpsdisplaysink video-sink={self.video_sink} name=hailo_display sync={self.sync} text-overlay={self.options_menu.show_fps} signal-fps-measurements=true "
         
         return pipeline_string
-    
+
+    def get_full_res_pipeline_string(self):
+        pipeline_string = f"libcamerasrc name=src_0 auto-focus-mode=AfModeManual ! "
+        pipeline_string += f"video/x-raw, format={self.display_format}, width={self.display_width}, height={self.display_height}, framerate=30/1 ! "
+        pipeline_string += "tee name=t ! "
+
+        # Inference branch first: the tee pushes to it before the display branch, and
+        # the scale in the camera thread releases the full-resolution buffer at once,
+        # so the display probe gets it unshared and can draw in place. The leaky
+        # queue sheds frames when the device falls behind; the display never waits.
+        pipeline_string += f"videoscale n-threads=2 ! videoconvert n-threads=2 ! "
+        pipeline_string += f"video/x-raw, format={self.network_format}, width={self.network_width}, height={self.network_height}, pixel-aspect-ratio=1/1 ! "
+        pipeline_string += "queue name=queue_hailonet leaky=downstream max-size-buffers=2 max-size-bytes=0 max-size-time=0 ! "
+        pipeline_string += f"hailonet hef-path={self.hef_path} batch-size={self.batch_size} force-writable=true ! "
+        pipeline_string += self.get_postprocess_string()
+        pipeline_string += "identity name=identity_results ! fakesink sync=false async=false "
+
+        pipeline_string += "t. ! " + QUEUE("queue_user_callback")
+        pipeline_string += f"identity name=identity_callback ! "
+        pipeline_string += QUEUE("queue_hailo_display")
+        pipeline_string += f"fpsdisplaysink video-sink={self.video_sink} name=hailo_display sync={self.sync} text-overlay={self.options_menu.show_fps} signal-fps-measurements=true "
+
+        return pipeline_string
+
 
 if __name__ == "__main__":
     parser = get_default_parser()
+    parser.add_argument("--native-overlay", action="store_true",
+                        help="Draw labels in place with the inception_v3 module and display on glimagesink, "
+                             "instead of hailooverlay + videoconvert")
+    parser.add_argument("--full-res", action="store_true",
+                        help="Display full-resolution camera frames; only a downscaled copy is classified")
     args = parser.parse_args()
     app = GStreamerInstanceSegmentationApp(args, user_data)
     app.run()
\ No newline at end of file
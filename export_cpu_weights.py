@@ -0,0 +1,139 @@
+"""Exports the Keras ImageNet Inception-v3 weights for the CPU engine
+(InceptionV3CpuBackend, see inception_v3_cpu_backend.hpp for the file layout).
+
+Usage: python3 export_cpu_weights.py [inception_v3.iv3w]
+       python3 export_cpu_weights.py --small <model.keras> [small.iv3w]
+
+Needs tensorflow; Keras downloads the weights on first use. Batch norm is folded
+into each convolution and every output channel is quantized to int8.
+
+--small exports a cascade first stage instead: a Keras model of Conv2D layers
+(each optionally followed by BatchNormalization, all with ReLU), then
+GlobalAveragePooling2D and Dense, taking square RGB input already scaled to
+[-1, 1]. The first convolution must use "valid" padding.
+"""
+import struct
+import sys
+from typing import List
+
+import numpy as np
+import tensorflow as tf
+
+MAGIC = 0x49563357  # "IV3W"
+VERSION = 1
+SMALL_VERSION = 2
+
+
+def creation_order(layers: List[tf.keras.layers.Layer]) -> List[tf.keras.layers.Layer]:
+    # Keras numbers unnamed layers in creation order ("conv2d", "conv2d_1", ...),
+    # which is the order the C++ graph consumes them in.
+    def index(layer: tf.keras.layers.Layer) -> int:
+        suffix = layer.name.rsplit("_", 1)
+        return int(suffix[1]) if len(suffix) == 2 and suffix[1].isdigit() else 0
+    return sorted(layers, key=index)
+
+
+def write_layer(out, weights: np.ndarray, bias: np.ndarray, stride: int = 0, same: bool = False) -> None:
+    # weights: out_channels x kernel_h x kernel_w x in_channels, float. stride > 0
+    # writes the small-model layer header, which carries stride and padding.
+    out_channels, kernel_h, kernel_w, in_channels = weights.shape
+    flat = weights.reshape(out_channels, -1)
+    scale = np.abs(flat).max(axis=1) / 127.0
+    scale[scale == 0.0] = 1.0
+    quantized = np.clip(np.round(flat / scale[:, None]), -127, 127).astype(np.int8)
+
+    out.write(struct.pack("<4I", kernel_h, kernel_w, in_channels, out_channels))
+    if stride > 0:
+        out.write(struct.pack("<2I", stride, 1 if same else 0))
+    out.write(scale.astype("<f4").tobytes())
+    out.write(bias.astype("<f4").tobytes())
+    out.write(quantized.tobytes())
+
+
+def export_small(model_path: str, path: str) -> None:
+    model = tf.keras.models.load_model(model_path)
+    _, height, width, channels = model.input_shape
+    if height != width or channels != 3:
+        raise RuntimeError(f"{model_path} takes {height}x{width}x{channels}, expected a square RGB input")
+
+    # Conv2D [BatchNormalization] ReLU ... GlobalAveragePooling2D Dense, as (conv, norm) pairs. The
+    # engine applies ReLU after every convolution, so each one must have it.
+    def is_relu(layer) -> bool:
+        return isinstance(layer, tf.keras.layers.ReLU) and layer.max_value is None and not layer.negative_slope \
+            or isinstance(layer, tf.keras.layers.Activation) and layer.activation is tf.keras.activations.relu
+
+    layers = [l for l in model.layers if not isinstance(l, tf.keras.layers.InputLayer)]
+    convs = []
+    rectified = True
+    for layer in layers[:-2]:
+        if isinstance(layer, tf.keras.layers.Conv2D) and rectified and layer.strides[0] == layer.strides[1] \
+                and layer.dilation_rate == (1, 1) and layer.groups == 1:
+            convs.append([layer, None])
+            rectified = layer.activation is tf.keras.activations.relu
+        elif isinstance(layer, tf.keras.layers.BatchNormalization) and convs and convs[-1][1] is None \
+                and convs[-1][0].activation is tf.keras.activations.linear:
+            convs[-1][1] = layer
+        elif is_relu(layer) and convs and not rectified:
+            rectified = True
+        else:
+            raise RuntimeError(f"{layer.name} ({type(layer).__name__}) has no small-model equivalent")
+    if not convs or not rectified or not isinstance(layers[-2], tf.keras.layers.GlobalAveragePooling2D) \
+            or not isinstance(layers[-1], tf.keras.layers.Dense):
+        raise RuntimeError(f"{model_path} is not a chain of Conv2D+ReLU ending in GlobalAveragePooling2D and Dense")
+    if convs[0][0].padding != "valid":
+        raise RuntimeError("the first convolution must use valid padding")
+
+    dense = layers[-1]
+    with open(path, "wb") as out:
+        classes = dense.units
+        out.write(struct.pack("<5I", MAGIC, SMALL_VERSION, len(convs) + 1, classes, height))
+
+        for conv, norm in convs:
+            kernel = conv.get_weights()[0]                    # kernel_h x kernel_w x in x out
+            bias = conv.get_weights()[1] if conv.use_bias else np.zeros(kernel.shape[3])
+            if norm is not None:
+                gamma = norm.gamma.numpy() if norm.scale else 1.0
+                beta = norm.beta.numpy() if norm.center else 0.0
+                factor = gamma / np.sqrt(norm.moving_variance.numpy() + norm.epsilon)
+                kernel = kernel * factor
+                bias = (bias - norm.moving_mean.numpy()) * factor + beta
+            write_layer(out, np.transpose(kernel, (3, 0, 1, 2)), bias, conv.strides[0], conv.padding == "same")
+
+        kernel, bias = dense.get_weights()                    # features x classes
+        write_layer(out, kernel.T.reshape(classes, 1, 1, -1), bias, 1, False)
+
+    print(f"Wrote {len(convs)} convolutions and the {classes}-class classifier ({height}x{width} input) to {path}")
+
+
+def main() -> None:
+    if len(sys.argv) > 2 and sys.argv[1] == "--small":
+        export_small(sys.argv[2], sys.argv[3] if len(sys.argv) > 3 else "small.iv3w")
+        return
+    path = sys.argv[1] if len(sys.argv) > 1 else "inception_v3.iv3w"
+    model = tf.keras.applications.InceptionV3(weights="imagenet")
+
+    convs = creation_order([l for l in model.layers if isinstance(l, tf.keras.layers.Conv2D)])
+    norms = creation_order([l for l in model.layers if isinstance(l, tf.keras.layers.BatchNormalization)])
+    dense = [l for l in model.layers if isinstance(l, tf.keras.layers.Dense)][-1]
+    if len(convs) != len(norms):
+        raise RuntimeError(f"{len(convs)} convolutions but {len(norms)} batch norms")
+
+    with open(path, "wb") as out:
+        classes = dense.units
+        out.write(struct.pack("<4I", MAGIC, VERSION, len(convs) + 1, classes))
+
+        for conv, norm in zip(convs, norms):
+            kernel = conv.get_weights()[0]                    # kernel_h x kernel_w x in x out
+            beta, mean, variance = norm.get_weights()         # scale=False: no gamma
+            inverse = 1.0 / np.sqrt(variance + norm.epsilon)
+            weights = np.transpose(kernel * inverse, (3, 0, 1, 2))
+            write_layer(out, weights, beta - mean * inverse)
+
+        kernel, bias = dense.get_weights()                    # 2048 x classes
+        write_layer(out, kernel.T.reshape(classes, 1, 1, -1), bias)
+
+    print(f"Wrote {len(convs)} convolutions and the {classes}-class classifier to {path}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,161 @@
+#include "inception_v3_affinity.hpp"
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <sstream>
+#include <stdexcept>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace
+{
+std::vector<int> parse_cpu_list(const std::string &text)
+{
+    std::vector<int> cpus;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        auto dash = item.find('-');
+        int first = std::stoi(item.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+        if (first < 0 || last < first || last >= CPU_SETSIZE) {
+            throw std::invalid_argument("bad cpu range " + item);
+        }
+        for (int cpu = first; cpu <= last; cpu++) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+std::string describe_cpus(const cpu_set_t &set)
+{
+    std::ostringstream out;
+    bool first = true;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &set)) {
+            continue;
+        }
+        int last = cpu;
+        while (last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, &set)) {
+            last++;
+        }
+        out << (first ? "" : ",") << cpu;
+        if (last > cpu) {
+            out << '-' << last;
+        }
+        first = false;
+        cpu = last;
+    }
+    return out.str();
+}
+}
+
+const char *inception_v3_stage_name(InceptionV3Stage stage)
+{
+    switch (stage) {
+    case INCEPTION_V3_STAGE_CAPTURE:
+        return "capture";
+    case INCEPTION_V3_STAGE_PREPROCESS:
+        return "preprocess";
+    case INCEPTION_V3_STAGE_DEVICE_IO:
+        return "device";
+    case INCEPTION_V3_STAGE_POSTPROCESS:
+        return "postprocess";
+    default:
+        return "unknown";
+    }
+}
+
+InceptionV3ThreadPlacement InceptionV3ThreadPlacement::parse(const std::string &spec)
+{
+    InceptionV3ThreadPlacement placement;
+    std::stringstream stream(spec);
+    std::string entry;
+    while (std::getline(stream, entry, ';')) {
+        if (entry.empty()) {
+            continue;
+        }
+        auto equals = entry.find('=');
+        if (equals == std::string::npos) {
+            throw std::invalid_argument("placement entry without '=': " + entry);
+        }
+
+        std::string name = entry.substr(0, equals);
+        int stage = 0;
+        while (stage < INCEPTION_V3_STAGE_COUNT && name != inception_v3_stage_name(static_cast<InceptionV3Stage>(stage))) {
+            stage++;
+        }
+        if (stage == INCEPTION_V3_STAGE_COUNT) {
+            throw std::invalid_argument("unknown pipeline stage " + name);
+        }
+
+        auto &target = placement.stages[stage];
+        std::stringstream options(entry.substr(equals + 1));
+        std::string option;
+        std::getline(options, option, ':');
+        target.cpus = parse_cpu_list(option);
+        while (std::getline(options, option, ':')) {
+            if (option == "spread") {
+                target.spread = true;
+            } else if (option == "fifo") {
+                target.fifo_priority = 10;
+            } else if (option.compare(0, 5, "fifo=") == 0) {
+                target.fifo_priority = std::stoi(option.substr(5));
+            } else {
+                throw std::invalid_argument("unknown placement option " + option);
+            }
+        }
+    }
+    return placement;
+}
+
+std::string apply_inception_v3_placement(const InceptionV3StagePlacement &placement, size_t thread_index,
+                                         const std::string &thread_name)
+{
+    // Kernel thread names are limited to 15 characters.
+    pthread_setname_np(pthread_self(), thread_name.substr(0, 15).c_str());
+
+    std::ostringstream report;
+    report << thread_name << " tid=" << syscall(SYS_gettid);
+
+    if (!placement.cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (placement.spread) {
+            CPU_SET(placement.cpus[thread_index % placement.cpus.size()], &set);
+        } else {
+            for (int cpu : placement.cpus) {
+                CPU_SET(cpu, &set);
+            }
+        }
+        int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (rc != 0) {
+            report << " affinity refused (" << std::strerror(rc) << ")";
+        }
+    }
+
+    if (placement.fifo_priority > 0) {
+        sched_param param = {};
+        param.sched_priority = placement.fifo_priority;
+        int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (rc != 0) {
+            report << " SCHED_FIFO refused (" << std::strerror(rc) << ")";
+        }
+    }
+
+    cpu_set_t effective;
+    CPU_ZERO(&effective);
+    pthread_getaffinity_np(pthread_self(), sizeof(effective), &effective);
+    int policy = 0;
+    sched_param param = {};
+    pthread_getschedparam(pthread_self(), &policy, &param);
+
+    report << " cpus=" << describe_cpus(effective) << " policy="
+           << (policy == SCHED_FIFO ? "fifo" : (policy == SCHED_RR ? "rr" : "other"));
+    if (policy == SCHED_FIFO || policy == SCHED_RR) {
+        report << '/' << param.sched_priority;
+    }
+    return report.str();
+}
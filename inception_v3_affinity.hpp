@@ -0,0 +1,38 @@
+#pragma once
+#include <string>
+#include <vector>
+
+enum InceptionV3Stage
+{
+    INCEPTION_V3_STAGE_CAPTURE,
+    INCEPTION_V3_STAGE_PREPROCESS,
+    INCEPTION_V3_STAGE_DEVICE_IO,
+    INCEPTION_V3_STAGE_POSTPROCESS,
+    INCEPTION_V3_STAGE_COUNT,
+};
+
+const char *inception_v3_stage_name(InceptionV3Stage stage);
+
+struct InceptionV3StagePlacement
+{
+    std::vector<int> cpus;      // empty: leave the affinity inherited from the process
+    bool spread = false;        // pin the i-th thread of the stage to cpus[i % n] instead of the whole set
+    int fifo_priority = 0;      // > 0: run under SCHED_FIFO at this priority
+};
+
+// Where each pipeline stage's threads run. Parsed from a spec such as
+//   "capture=0;preprocess=1-2:spread;device=3:fifo=50;postprocess=0"
+// Stage names are capture, preprocess, device and postprocess. CPU lists take
+// single cores and ranges separated by commas.
+struct InceptionV3ThreadPlacement
+{
+    InceptionV3StagePlacement stages[INCEPTION_V3_STAGE_COUNT];
+
+    static InceptionV3ThreadPlacement parse(const std::string &spec);
+};
+
+// Names the calling thread, applies the stage placement to it and returns a
+// one-line description of what the kernel actually granted. A refused
+// SCHED_FIFO request (usually missing CAP_SYS_NICE) is reported, not thrown.
+std::string apply_inception_v3_placement(const InceptionV3StagePlacement &placement, size_t thread_index,
+                                         const std::string &thread_name);
@@ -0,0 +1,195 @@
+#include "inception_v3_backend.hpp"
+#include "inception_v3_perf.hpp"
+#include <cstring>
+#include <pthread.h>
+#include <stdexcept>
+#include <thread>
+
+hailo_vstream_info_t inception_v3_input_info(uint32_t width, uint32_t height)
+{
+    hailo_vstream_info_t info;
+    std::memset(&info, 0, sizeof(info));
+    std::strncpy(info.name, "inception-v3/input_layer1", sizeof(info.name) - 1);
+    std::strncpy(info.network_name, "inception-v3", sizeof(info.network_name) - 1);
+    info.direction = HAILO_H2D_STREAM;
+    info.format.type = HAILO_FORMAT_TYPE_UINT8;
+    info.format.order = HAILO_FORMAT_ORDER_NHWC;
+    info.shape.height = height;
+    info.shape.width = width;
+    info.shape.features = 3;
+    info.quant_info.qp_scale = 1.0f;
+    return info;
+}
+
+hailo_vstream_info_t inception_v3_output_info(uint32_t classes)
+{
+    hailo_vstream_info_t info;
+    std::memset(&info, 0, sizeof(info));
+    std::strncpy(info.name, "inception-v3/fc1", sizeof(info.name) - 1);
+    std::strncpy(info.network_name, "inception-v3", sizeof(info.network_name) - 1);
+    info.direction = HAILO_D2H_STREAM;
+    info.format.type = HAILO_FORMAT_TYPE_UINT8;
+    info.format.order = HAILO_FORMAT_ORDER_NC;
+    info.shape.height = 1;
+    info.shape.width = 1;
+    info.shape.features = classes;
+    info.quant_info.qp_scale = 1.0f / 255.0f;
+    return info;
+}
+
+InceptionV3HailoBackend::InceptionV3HailoBackend(const std::string &hef_path, const std::string &device_id)
+{
+    m_device = device_id.empty() ? hailort::Device::create() : hailort::Device::create(device_id);
+    m_vstreams = hailort::VStreams::create(*m_device, hef_path);
+    m_input_vstream = m_vstreams->input_vstreams()[0];
+    m_output_vstream = m_vstreams->output_vstreams()[0];
+}
+
+hailo_vstream_info_t InceptionV3HailoBackend::input_info() const
+{
+    return m_input_vstream->get_info();
+}
+
+hailo_vstream_info_t InceptionV3HailoBackend::output_info() const
+{
+    return m_output_vstream->get_info();
+}
+
+size_t InceptionV3HailoBackend::input_frame_size() const
+{
+    return m_input_vstream->get_frame_size();
+}
+
+size_t InceptionV3HailoBackend::output_frame_size() const
+{
+    return m_output_vstream->get_frame_size();
+}
+
+InceptionV3HailoBackend::~InceptionV3HailoBackend()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_writer_mutex);
+        m_stopping = true;
+    }
+    m_writer_cv.notify_all();
+    if (m_writer.joinable()) {
+        m_writer.join();
+    }
+}
+
+void InceptionV3HailoBackend::write_loop()
+{
+    pthread_setname_np(pthread_self(), "iv3-dev-write");
+    std::unique_lock<std::mutex> lock(m_writer_mutex);
+    for (;;) {
+        m_writer_cv.wait(lock, [this]() { return m_stopping || (m_write_batch && !m_write_done); });
+        if (m_stopping) {
+            return;
+        }
+        const std::vector<uint8_t *> &inputs = *m_write_batch;
+        lock.unlock();
+
+        hailo_status status = HAILO_SUCCESS;
+        {
+            InceptionV3PerfScope cost(INCEPTION_V3_PERF_DEVICE_WRITE, inputs.size());
+            for (auto *frame : inputs) {
+                status = m_input_vstream->write(frame);
+                if (status != HAILO_SUCCESS) {
+                    break;
+                }
+            }
+        }
+
+        lock.lock();
+        m_write_status = status;
+        m_write_done = true;
+        m_writer_cv.notify_all();
+    }
+}
+
+void InceptionV3HailoBackend::infer(const std::vector<uint8_t *> &inputs, const std::vector<uint8_t *> &outputs)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_writer_mutex);
+        if (!m_writer.joinable()) {
+            m_writer = std::thread(&InceptionV3HailoBackend::write_loop, this);
+        }
+        m_write_batch = &inputs;
+        m_write_done = false;
+    }
+    m_writer_cv.notify_all();
+
+    hailo_status read_status = HAILO_SUCCESS;
+    {
+        InceptionV3PerfScope cost(INCEPTION_V3_PERF_DEVICE_READ, inputs.size());
+        for (size_t i = 0; i < inputs.size() && read_status == HAILO_SUCCESS; i++) {
+            read_status = m_output_vstream->read(outputs[i]);
+        }
+    }
+
+    // A writer blocked on a device that stopped producing output would never
+    // finish; aborting the input vstream makes its write return, so the batch
+    // (which it still points into) is not released under it.
+    if (read_status != HAILO_SUCCESS) {
+        m_input_vstream->abort();
+    }
+    hailo_status write_status;
+    {
+        std::unique_lock<std::mutex> lock(m_writer_mutex);
+        m_writer_cv.wait(lock, [this]() { return m_write_done; });
+        m_write_batch = nullptr;
+        write_status = m_write_status;
+    }
+    if (read_status != HAILO_SUCCESS) {
+        m_input_vstream->resume();
+    }
+
+    if (write_status != HAILO_SUCCESS || read_status != HAILO_SUCCESS) {
+        throw std::runtime_error("vstream transfer failed, status " +
+                                 std::to_string(read_status != HAILO_SUCCESS ? read_status : write_status));
+    }
+}
+
+InceptionV3SimulatedBackend::InceptionV3SimulatedBackend(std::chrono::microseconds frame_latency,
+                                                         std::chrono::microseconds batch_overhead,
+                                                         uint32_t classes)
+    : m_frame_latency(frame_latency), m_batch_overhead(batch_overhead),
+      m_input_info(inception_v3_input_info()), m_output_info(inception_v3_output_info(classes))
+{}
+
+size_t InceptionV3SimulatedBackend::input_frame_size() const
+{
+    return static_cast<size_t>(m_input_info.shape.height) * m_input_info.shape.width * m_input_info.shape.features;
+}
+
+size_t InceptionV3SimulatedBackend::output_frame_size() const
+{
+    return m_output_info.shape.features;
+}
+
+void InceptionV3SimulatedBackend::infer(const std::vector<uint8_t *> &inputs, const std::vector<uint8_t *> &outputs)
+{
+    std::lock_guard<std::mutex> device(m_device_mutex);
+    auto done = std::chrono::steady_clock::now() + m_batch_overhead + m_frame_latency * inputs.size();
+
+    const size_t input_size = input_frame_size();
+    const size_t classes = output_frame_size();
+    {
+        InceptionV3PerfScope cost(INCEPTION_V3_PERF_DEVICE_WRITE, inputs.size());
+        for (size_t i = 0; i < inputs.size(); i++) {
+            // Sparse FNV-1a over the input keeps this cheap next to the simulated latency.
+            uint32_t hash = 2166136261u;
+            for (size_t offset = 0; offset < input_size; offset += 997) {
+                hash = (hash ^ inputs[i][offset]) * 16777619u;
+            }
+
+            std::memset(outputs[i], 0, classes);
+            for (size_t k = 0; k < 5; k++) {
+                outputs[i][(hash + k * 7919u) % classes] = static_cast<uint8_t>(230 - k * 40);
+            }
+        }
+    }
+
+    InceptionV3PerfScope cost(INCEPTION_V3_PERF_DEVICE_READ, inputs.size());
+    std::this_thread::sleep_until(done);
+}
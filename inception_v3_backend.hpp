@@ -0,0 +1,100 @@
+#pragma once
+#include "hailo/hailort.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+using InceptionV3DevicePtr = decltype(hailort::Device::create());
+using InceptionV3VStreamsPtr = decltype(hailort::VStreams::create(std::declval<hailort::Device &>(), std::string()));
+using InceptionV3InputVStreamPtr = typename std::decay<decltype(std::declval<InceptionV3VStreamsPtr &>()->input_vstreams()[0])>::type;
+using InceptionV3OutputVStreamPtr = typename std::decay<decltype(std::declval<InceptionV3VStreamsPtr &>()->output_vstreams()[0])>::type;
+
+// Something that turns network-resolution input tensors into fc1 output tensors.
+// infer() must be safe to call from one thread at a time; implementations that
+// own a physical device serialize internally.
+class InceptionV3Backend
+{
+public:
+    virtual ~InceptionV3Backend() = default;
+
+    virtual hailo_vstream_info_t input_info() const = 0;
+    virtual hailo_vstream_info_t output_info() const = 0;
+    virtual size_t input_frame_size() const = 0;
+    virtual size_t output_frame_size() const = 0;
+
+    // outputs[i] receives output_frame_size() bytes for inputs[i].
+    virtual void infer(const std::vector<uint8_t *> &inputs, const std::vector<uint8_t *> &outputs) = 0;
+};
+
+class InceptionV3HailoBackend : public InceptionV3Backend
+{
+public:
+    // device_id picks one of several devices ("0000:01:00.0"); empty takes the first.
+    explicit InceptionV3HailoBackend(const std::string &hef_path, const std::string &device_id = "");
+    ~InceptionV3HailoBackend() override;
+
+    hailo_vstream_info_t input_info() const override;
+    hailo_vstream_info_t output_info() const override;
+    size_t input_frame_size() const override;
+    size_t output_frame_size() const override;
+
+    // Frames are written by the backend's writer thread while the outputs are read
+    // here, so the whole batch is in flight on the device at once. The writer is
+    // started by the first call and inherits that thread's CPU affinity and
+    // scheduling policy, so it follows the device stage's placement.
+    void infer(const std::vector<uint8_t *> &inputs, const std::vector<uint8_t *> &outputs) override;
+
+private:
+    void write_loop();
+
+    InceptionV3DevicePtr m_device;
+    InceptionV3VStreamsPtr m_vstreams;
+    InceptionV3InputVStreamPtr m_input_vstream;
+    InceptionV3OutputVStreamPtr m_output_vstream;
+
+    std::thread m_writer;
+    std::mutex m_writer_mutex;
+    std::condition_variable m_writer_cv;
+    const std::vector<uint8_t *> *m_write_batch = nullptr;   // batch waiting for or being written
+    bool m_write_done = false;
+    hailo_status m_write_status = HAILO_SUCCESS;
+    bool m_stopping = false;
+};
+
+// Stand-in for the accelerator when benchmarking without hardware. A batch takes
+// batch_overhead + frame_latency * frames of wall time, calls are serialized like
+// on a single device, and the top-1 class is derived from the input bytes so that
+// results are deterministic per frame.
+class InceptionV3SimulatedBackend : public InceptionV3Backend
+{
+public:
+    InceptionV3SimulatedBackend(std::chrono::microseconds frame_latency = std::chrono::microseconds(4000),
+                                std::chrono::microseconds batch_overhead = std::chrono::microseconds(500),
+                                uint32_t classes = 1000);
+
+    hailo_vstream_info_t input_info() const override { return m_input_info; }
+    hailo_vstream_info_t output_info() const override { return m_output_info; }
+    size_t input_frame_size() const override;
+    size_t output_frame_size() const override;
+
+    void infer(const std::vector<uint8_t *> &inputs, const std::vector<uint8_t *> &outputs) override;
+
+private:
+    std::chrono::microseconds m_frame_latency;
+    std::chrono::microseconds m_batch_overhead;
+    hailo_vstream_info_t m_input_info;
+    hailo_vstream_info_t m_output_info;
+    std::mutex m_device_mutex;
+};
+
+// Input/output vstream descriptions matching inception_v3.hef, for backends that
+// do not read them from a device.
+hailo_vstream_info_t inception_v3_input_info(uint32_t width = 299, uint32_t height = 299);
+hailo_vstream_info_t inception_v3_output_info(uint32_t classes = 1000);
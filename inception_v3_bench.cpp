@@ -0,0 +1,382 @@
+#include "inception_v3_cascade.hpp"
+#include "inception_v3_cpu_backend.hpp"
+#include "inception_v3_kernels.hpp"
+#include "inception_v3_perf.hpp"
+#include "inception_v3_pipeline.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <sys/resource.h>
+
+// Synthetic-camera scaling sweep over the native pipeline.
+//
+// Every combination of --streams, --threads, --batch and --queue runs the pipeline
+// against synthetic sources and appends one CSV row with throughput, drops,
+// capture-to-result latency percentiles and process CPU use.
+//
+// --record writes the tensors the first run hands to the device to a tensor file;
+// --replay runs those exact tensors back through the pipeline instead of the
+// synthetic cameras, at the recorded pacing or (--replay-pace max) flat out.
+//
+// --perf on adds the per-frame CPU cost of each stage after every run.
+//
+// --cpu runs the int8 CPU engine in place of the device; --overflow keeps the
+// device and offloads frames to the CPU engine whenever the device queue is at
+// --overflow-threshold. --cascade puts a cheap first-stage classifier (a small
+// model from export_cpu_weights.py --small) in front of the device and escalates
+// only the frames it is unsure of.
+//
+// --isa pins the host kernels (top-K, resize, the CPU engine's dot products) to
+// one instruction set, to compare them on the same machine.
+
+namespace
+{
+struct BenchOptions
+{
+    std::string hef_path;
+    std::string cpu_weights;
+    size_t cpu_threads = 0;
+    std::string overflow_weights;
+    size_t overflow_threads = 0;
+    size_t overflow_threshold = 0;
+    std::string cascade_stage;
+    std::string cascade_config;
+    std::chrono::microseconds sim_frame_latency{4000};
+    std::chrono::microseconds sim_batch_overhead{500};
+    uint32_t width = 1536;
+    uint32_t height = 864;
+    InceptionV3PixelFormat format = INCEPTION_V3_FORMAT_RGB;
+    double fps = 30.0;
+    uint64_t frames = 300;
+    std::vector<size_t> streams{1};
+    std::vector<size_t> threads{2};
+    std::vector<size_t> batches{1};
+    std::vector<size_t> queues{4};
+    std::string csv_path;
+    InceptionV3ThreadPlacement placement;
+    bool report_placement = false;
+    bool perf = false;
+    std::string record_path;
+    std::string replay_path;
+    bool replay_paced = true;
+    std::string isa;
+};
+
+void print_usage(const char *program)
+{
+    std::cerr << "Usage: " << program << " [--hef <hef_path> | --simulate <frame_us>[,<batch_overhead_us>] |" << std::endl
+              << "       --cpu <weights.iv3w>[,<threads>]]" << std::endl
+              << "       [--width 1536] [--height 864] [--format RGB|NV12] [--fps 30 (0 = unpaced)]" << std::endl
+              << "       [--frames 300 (per stream)] [--streams 1,2] [--threads 1,2,4] [--batch 1,4,8]" << std::endl
+              << "       [--queue 2,4,8] [--csv report.csv] [--record tensors.iv3t]" << std::endl
+              << "       [--replay tensors.iv3t [--replay-pace original|max]]" << std::endl
+              << "       [--placement \"capture=0;preprocess=1-2:spread;device=3:fifo=50;postprocess=0\"]" << std::endl
+              << "       [--perf on (per-stage CPU time and hardware counters per frame)]" << std::endl
+              << "       [--overflow <weights.iv3w>[,<threads>] [--overflow-threshold <queued frames>]]" << std::endl
+              << "       [--cascade <small.iv3w[,<threads>] | simulate[:<frame_us>]>" << std::endl
+              << "        [--cascade-config \"threshold=0.6;classes=0-397\"]]" << std::endl
+              << "       [--isa avx512|avx2|sse2|dotprod|neon|scalar (default: best supported)]" << std::endl;
+}
+
+// "<path>[,<threads>]"; threads = 0 means every core.
+void parse_weights(const std::string &text, std::string &path, size_t &threads)
+{
+    size_t comma = text.rfind(',');
+    if (comma != std::string::npos && comma + 1 < text.size() &&
+        text.find_first_not_of("0123456789", comma + 1) == std::string::npos) {
+        path = text.substr(0, comma);
+        threads = std::stoul(text.substr(comma + 1));
+    } else {
+        path = text;
+        threads = 0;
+    }
+}
+
+std::vector<size_t> parse_list(const std::string &text)
+{
+    std::vector<size_t> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        values.push_back(std::stoul(item));
+    }
+    if (values.empty()) {
+        throw std::invalid_argument("empty list: " + text);
+    }
+    return values;
+}
+
+double percentile(std::vector<double> &values, double fraction)
+{
+    if (values.empty()) {
+        return 0.0;
+    }
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(fraction * (values.size() - 1) + 0.5));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+double cpu_seconds()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    BenchOptions options;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            std::string value = argv[++i];
+            if (arg == "--hef") {
+                options.hef_path = value;
+            } else if (arg == "--simulate") {
+                auto values = parse_list(value);
+                options.sim_frame_latency = std::chrono::microseconds(values[0]);
+                if (values.size() > 1) {
+                    options.sim_batch_overhead = std::chrono::microseconds(values[1]);
+                }
+            } else if (arg == "--cpu") {
+                parse_weights(value, options.cpu_weights, options.cpu_threads);
+            } else if (arg == "--overflow") {
+                parse_weights(value, options.overflow_weights, options.overflow_threads);
+            } else if (arg == "--overflow-threshold") {
+                options.overflow_threshold = std::stoul(value);
+            } else if (arg == "--cascade") {
+                options.cascade_stage = value;
+            } else if (arg == "--cascade-config") {
+                options.cascade_config = value;
+            } else if (arg == "--width") {
+                options.width = static_cast<uint32_t>(std::stoul(value));
+            } else if (arg == "--height") {
+                options.height = static_cast<uint32_t>(std::stoul(value));
+            } else if (arg == "--format") {
+                if (!parse_inception_v3_pixel_format(value, options.format)) {
+                    throw std::invalid_argument("unsupported format " + value);
+                }
+            } else if (arg == "--fps") {
+                options.fps = std::stod(value);
+            } else if (arg == "--frames") {
+                options.frames = std::stoull(value);
+            } else if (arg == "--streams") {
+                options.streams = parse_list(value);
+            } else if (arg == "--threads") {
+                options.threads = parse_list(value);
+            } else if (arg == "--batch") {
+                options.batches = parse_list(value);
+            } else if (arg == "--queue") {
+                options.queues = parse_list(value);
+            } else if (arg == "--placement") {
+                options.placement = InceptionV3ThreadPlacement::parse(value);
+                options.report_placement = true;
+            } else if (arg == "--perf") {
+                options.perf = value == "on" || value == "1";
+            } else if (arg == "--csv") {
+                options.csv_path = value;
+            } else if (arg == "--record") {
+                options.record_path = value;
+            } else if (arg == "--replay") {
+                options.replay_path = value;
+            } else if (arg == "--replay-pace") {
+                if (value != "original" && value != "max") {
+                    throw std::invalid_argument("--replay-pace must be original or max");
+                }
+                options.replay_paced = value == "original";
+            } else if (arg == "--isa") {
+                options.isa = value;
+            } else {
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+
+        if (options.frames == 0) {
+            throw std::invalid_argument("--frames must be positive");
+        }
+        if (!options.isa.empty() && !inception_v3_use_isa(options.isa)) {
+            std::string supported;
+            for (const auto &isa : inception_v3_isas()) {
+                supported += (supported.empty() ? "" : ", ") + isa;
+            }
+            throw std::invalid_argument("--isa " + options.isa + " is not supported here (" + supported + ")");
+        }
+        std::cerr << "Host kernels: " << inception_v3_kernels().isa << std::endl;
+
+        auto params = init_inception_v3("./imagenet_classes.txt", 0.5f);
+        std::unique_ptr<InceptionV3Backend> backend;
+        const char *device = "simulated";
+        if (!options.hef_path.empty()) {
+            backend.reset(new InceptionV3HailoBackend(options.hef_path));
+            device = "hailo";
+        } else if (!options.cpu_weights.empty()) {
+            backend.reset(new InceptionV3CpuBackend(options.cpu_weights, options.cpu_threads));
+            device = "cpu";
+        } else {
+            backend.reset(new InceptionV3SimulatedBackend(options.sim_frame_latency, options.sim_batch_overhead));
+        }
+        InceptionV3CascadeBackend *cascade = nullptr;
+        if (!options.cascade_stage.empty()) {
+            cascade = new InceptionV3CascadeBackend(make_inception_v3_cascade_stage(options.cascade_stage),
+                                                    std::move(backend),
+                                                    InceptionV3CascadeConfig::parse(options.cascade_config));
+            backend.reset(cascade);
+        }
+        InceptionV3Runner runner(std::move(backend), params);
+
+        std::unique_ptr<InceptionV3CpuBackend> overflow;
+        if (!options.overflow_weights.empty()) {
+            overflow.reset(new InceptionV3CpuBackend(options.overflow_weights, options.overflow_threads,
+                                                     runner.backend().output_info()));
+        }
+
+        // A replay stands in for all the synthetic streams, with the recorded frame shape and rate.
+        std::unique_ptr<InceptionV3TensorRecording> replay;
+        if (!options.replay_path.empty()) {
+            replay.reset(new InceptionV3TensorRecording(options.replay_path));
+            if (replay->size() == 0) {
+                throw std::runtime_error(options.replay_path + " holds no frames");
+            }
+            const auto &first = replay->record(0);
+            const auto &last = replay->record(replay->size() - 1);
+            options.streams = {1};
+            options.width = replay->header().width;
+            options.height = replay->header().height;
+            options.format = INCEPTION_V3_FORMAT_RGB;
+            options.fps = options.replay_paced && last.capture_time_ns > first.capture_time_ns
+                              ? (replay->size() - 1) * 1e9 / (last.capture_time_ns - first.capture_time_ns)
+                              : 0.0;
+        }
+
+        std::unique_ptr<InceptionV3TensorRecorder> recorder;
+        if (!options.record_path.empty()) {
+            size_t capacity = replay ? replay->size()
+                                     : options.frames * *std::max_element(options.streams.begin(), options.streams.end());
+            recorder.reset(new InceptionV3TensorRecorder(options.record_path, runner.backend().input_info(),
+                                                         runner.input_frame_size(), capacity));
+        }
+        bool first_run = true;
+
+        std::ofstream csv_file;
+        if (!options.csv_path.empty()) {
+            csv_file.open(options.csv_path);
+            if (!csv_file) {
+                throw std::runtime_error("cannot write " + options.csv_path);
+            }
+        }
+        std::ostream &csv = options.csv_path.empty() ? std::cout : csv_file;
+
+        csv << "device,streams,preprocess_threads,batch_size,queue_depth,width,height,format,target_fps,"
+               "captured,completed,dropped,duration_s,throughput_fps,latency_p50_ms,latency_p95_ms,"
+               "latency_p99_ms,latency_max_ms,cpu_percent,offloaded\n";
+
+        for (size_t streams : options.streams) {
+            for (size_t threads : options.threads) {
+                for (size_t batch : options.batches) {
+                    for (size_t queue : options.queues) {
+                        InceptionV3PipelineConfig config;
+                        config.preprocess_threads = threads;
+                        config.batch_size = batch;
+                        config.queue_depth = queue;
+                        config.placement = options.placement;
+                        config.recorder = first_run ? recorder.get() : nullptr;
+                        config.overflow_backend = overflow.get();
+                        config.overflow_threshold = options.overflow_threshold;
+                        first_run = false;
+
+                        std::mutex latency_mutex;
+                        std::vector<double> latencies_ms;
+                        latencies_ms.reserve(options.frames * streams);
+
+                        InceptionV3Pipeline pipeline(runner, config, [&](const InceptionV3PipelineResult &result) {
+                            std::lock_guard<std::mutex> lock(latency_mutex);
+                            latencies_ms.push_back((result.done_time_ns - result.capture_time_ns) / 1e6);
+                        });
+                        if (replay) {
+                            pipeline.add_source(std::unique_ptr<InceptionV3FrameSource>(
+                                new InceptionV3ReplaySource(*replay, options.replay_paced)));
+                        }
+                        for (size_t s = 0; !replay && s < streams; s++) {
+                            pipeline.add_source(std::unique_ptr<InceptionV3FrameSource>(new InceptionV3SyntheticSource(
+                                static_cast<uint32_t>(s), options.width, options.height, options.format, options.fps,
+                                options.frames)));
+                        }
+
+                        if (options.perf) {
+                            inception_v3_perf_enable();
+                        }
+                        auto cascade_start = cascade ? cascade->stats() : InceptionV3CascadeStats();
+                        double cpu_start = cpu_seconds();
+                        auto start = std::chrono::steady_clock::now();
+                        pipeline.run();
+                        double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                        double cpu = cpu_seconds() - cpu_start;
+
+                        auto stats = pipeline.stats();
+                        double p50 = percentile(latencies_ms, 0.50);
+                        double p95 = percentile(latencies_ms, 0.95);
+                        double p99 = percentile(latencies_ms, 0.99);
+                        double max = latencies_ms.empty() ? 0.0 : *std::max_element(latencies_ms.begin(), latencies_ms.end());
+
+                        // Each row is formatted on its own stream so no precision or
+                        // float format leaks from one row (or field) into the next.
+                        std::ostringstream row;
+                        row << device << ',' << streams << ',' << threads
+                            << ',' << batch << ',' << queue << ',' << options.width << ',' << options.height << ','
+                            << inception_v3_pixel_format_name(options.format) << ',' << options.fps << ','
+                            << stats.captured << ',' << stats.completed << ',' << stats.dropped << ','
+                            << std::fixed << std::setprecision(3) << duration << ',' << stats.completed / duration
+                            << ',' << p50 << ',' << p95 << ',' << p99 << ',' << max << ',' << std::setprecision(1)
+                            << 100.0 * cpu / duration << ',' << stats.offloaded << '\n';
+                        csv << row.str();
+                        csv.flush();
+
+                        if (options.perf) {
+                            inception_v3_perf_disable();
+                            std::istringstream report(inception_v3_perf_report());
+                            for (std::string line; std::getline(report, line);) {
+                                std::cerr << "  " << line << std::endl;
+                            }
+                        }
+                        if (options.report_placement) {
+                            for (auto &line : pipeline.placement_report()) {
+                                std::cerr << "  " << line << std::endl;
+                            }
+                        }
+                        std::cerr << "streams=" << streams << " threads=" << threads << " batch=" << batch
+                                  << " queue=" << queue << ": " << stats.completed / duration << " fps, "
+                                  << stats.dropped << " dropped";
+                        if (overflow) {
+                            std::cerr << ", " << stats.offloaded << " offloaded";
+                        }
+                        if (cascade) {
+                            std::cerr << ", " << cascade->stats().escalated - cascade_start.escalated << " escalated";
+                        }
+                        std::cerr << std::endl;
+                    }
+                }
+            }
+        }
+        if (recorder) {
+            std::cerr << "Recorded " << recorder->size() << " tensors to " << options.record_path << std::endl;
+        }
+
+        free_resources(params);
+
+    } catch (const std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
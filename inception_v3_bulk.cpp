@@ -0,0 +1,496 @@
+#include "inception_v3_bulk_results.hpp"
+#include "inception_v3_cpu_backend.hpp"
+#include "inception_v3_jpeg.hpp"
+#include "inception_v3_runner.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+// Offline bulk classification of an image manifest (one path per line).
+//
+// The manifest is cut into shards of --shard-size consecutive entries, and
+// --workers processes claim shards from a shared counter until none are left.
+// Workers are separate processes so that a bad image or a driver fault takes down
+// one worker, not the job, and so that each can own a device: with --devices,
+// worker i opens devices[i]; without, the one worker opens the first device.
+// With --hef there are at most as many workers as devices, since two processes
+// on one device would need a VDevice with the multi-process service.
+// Each worker decodes its next batch on a helper thread while the current one is
+// on the device.
+//
+// Results go to one compact file per shard in <out_dir> (see
+// inception_v3_bulk_results.hpp), appended batch by batch and synced every
+// --checkpoint images. Rerunning the same command after a crash or a kill skips
+// finished shards and resumes partial ones after their last record. --export
+// prints the results of an output directory as CSV.
+
+namespace
+{
+struct Options
+{
+    std::string hef_path;
+    std::string cpu_weights;
+    size_t cpu_threads = 0;
+    bool simulate = false;
+    std::vector<std::string> devices;
+    size_t workers = 0;
+    uint64_t shard_size = 10000;
+    size_t batch_size = 8;
+    uint64_t checkpoint = 1024;
+    float threshold = 0.5f;
+};
+
+// Lives in a shared anonymous mapping, so it is updated by every worker.
+struct SharedProgress
+{
+    std::atomic<uint32_t> next_shard;
+    std::atomic<uint64_t> images;
+    std::atomic<uint64_t> failed;
+};
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+              "progress counters must be lock-free to be shared between processes");
+
+void print_usage(const char *program)
+{
+    std::cerr << "Usage: " << program << " (--hef <hef_path> | --simulate | --cpu <weights.iv3w>[,threads])"
+              << std::endl
+              << "       [--devices <id>,<id>...] [--workers N] [--shard-size 10000] [--batch 8]" << std::endl
+              << "       [--checkpoint 1024] [--threshold 0.5] <manifest> <out_dir>" << std::endl
+              << "       " << program << " --export <manifest> <out_dir>    (CSV to stdout)" << std::endl;
+}
+
+std::vector<std::string> split(const std::string &list, char separator)
+{
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, separator)) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+std::vector<std::string> read_manifest(const std::string &path)
+{
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("cannot open manifest " + path);
+    }
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty()) {
+            lines.push_back(line);
+        }
+    }
+    return lines;
+}
+
+uint32_t shard_count(const std::vector<std::string> &lines, uint64_t shard_size)
+{
+    return static_cast<uint32_t>((lines.size() + shard_size - 1) / shard_size);
+}
+
+// Records already in a shard file, from its size alone.
+uint64_t shard_records(const std::string &path)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) < 0 || static_cast<uint64_t>(st.st_size) < sizeof(InceptionV3BulkShardHeader)) {
+        return 0;
+    }
+    return (static_cast<uint64_t>(st.st_size) - sizeof(InceptionV3BulkShardHeader)) / sizeof(InceptionV3BulkRecord);
+}
+
+std::unique_ptr<InceptionV3Backend> make_backend(const Options &options, size_t worker)
+{
+    if (options.simulate) {
+        return std::unique_ptr<InceptionV3Backend>(new InceptionV3SimulatedBackend());
+    }
+    if (!options.cpu_weights.empty()) {
+        return std::unique_ptr<InceptionV3Backend>(new InceptionV3CpuBackend(options.cpu_weights, options.cpu_threads));
+    }
+    const std::string device = options.devices.empty() ? "" : options.devices[worker % options.devices.size()];
+    return std::unique_ptr<InceptionV3Backend>(new InceptionV3HailoBackend(options.hef_path, device));
+}
+
+class Worker
+{
+public:
+    Worker(const Options &options, const std::vector<std::string> &lines, const std::string &out_dir, size_t index,
+           SharedProgress &progress)
+        : m_options(options), m_lines(lines), m_out_dir(out_dir), m_index(index), m_progress(progress),
+          m_params(init_inception_v3("./imagenet_classes.txt", options.threshold), free_resources),
+          m_runner(make_backend(options, index), m_params.get())
+    {
+        auto input_info = m_runner.backend().input_info();
+        m_width = input_info.shape.width;
+        m_height = input_info.shape.height;
+        for (auto &batch : m_batches) {
+            batch.tensors.assign(options.batch_size, std::vector<uint8_t>(m_runner.input_frame_size()));
+            batch.loaded.resize(options.batch_size);
+        }
+        m_records.resize(options.batch_size);
+    }
+
+    void run()
+    {
+        const uint32_t shards = shard_count(m_lines, m_options.shard_size);
+        for (;;) {
+            uint32_t shard = m_progress.next_shard.fetch_add(1);
+            if (shard >= shards) {
+                return;
+            }
+            process_shard(shard);
+        }
+    }
+
+private:
+    struct Batch
+    {
+        uint64_t first_line = 0;
+        size_t size = 0;
+        std::vector<std::vector<uint8_t>> tensors;
+        std::vector<uint8_t> loaded;
+        InceptionV3Frame scratch;
+    };
+
+    void load(Batch &batch)
+    {
+        for (size_t i = 0; i < batch.size; i++) {
+            const std::string &path = m_lines[batch.first_line + i];
+            try {
+                load_image_tensor(path, m_width, m_height, batch.tensors[i].data(), batch.scratch);
+                batch.loaded[i] = 1;
+            } catch (const std::exception &e) {
+                // Whatever one image throws, it is recorded as failed rather than
+                // taking down the worker again on every resume.
+                std::cerr << path << ": " << e.what() << std::endl;
+                batch.loaded[i] = 0;
+            }
+        }
+    }
+
+    std::future<void> start_load(Batch &batch, uint64_t &line, uint64_t end)
+    {
+        batch.first_line = line;
+        batch.size = static_cast<size_t>(std::min<uint64_t>(m_options.batch_size, end - line));
+        line += batch.size;
+        return std::async(std::launch::async, &Worker::load, this, std::ref(batch));
+    }
+
+    void process_shard(uint32_t shard)
+    {
+        const uint64_t first = static_cast<uint64_t>(shard) * m_options.shard_size;
+        const uint64_t count = std::min<uint64_t>(m_options.shard_size, m_lines.size() - first);
+        InceptionV3BulkShardWriter writer(inception_v3_bulk_shard_path(m_out_dir, shard), shard, first, count,
+                                          hash_inception_v3_bulk_lines(m_lines, first, count));
+        if (writer.complete()) {
+            return;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        const uint64_t resumed = writer.done();
+        const uint64_t end = first + count;
+        uint64_t line = first + resumed;
+        uint64_t failed = 0;
+        uint64_t unsynced = 0;
+        size_t current = 0;
+        std::future<void> pending = start_load(m_batches[current], line, end);
+
+        while (pending.valid()) {
+            pending.get();
+            Batch &batch = m_batches[current];
+            current ^= 1;
+            pending = line < end ? start_load(m_batches[current], line, end) : std::future<void>();
+
+            m_frames.clear();
+            for (size_t i = 0; i < batch.size; i++) {
+                if (batch.loaded[i]) {
+                    m_frames.push_back(batch.tensors[i].data());
+                }
+            }
+            auto results = m_frames.empty() ? std::vector<InceptionV3Result>() : m_runner.classify_batch(m_frames);
+
+            size_t next_result = 0;
+            for (size_t i = 0; i < batch.size; i++) {
+                if (batch.loaded[i]) {
+                    m_records[i] = make_inception_v3_bulk_record(results[next_result++]);
+                } else {
+                    std::memset(&m_records[i], 0, sizeof(m_records[i]));
+                    m_records[i].flags = INCEPTION_V3_BULK_FAILED;
+                }
+            }
+            writer.append(m_records.data(), batch.size);
+
+            const uint64_t batch_failed = batch.size - m_frames.size();
+            failed += batch_failed;
+            m_progress.images.fetch_add(batch.size, std::memory_order_relaxed);
+            m_progress.failed.fetch_add(batch_failed, std::memory_order_relaxed);
+            unsynced += batch.size;
+            if (unsynced >= m_options.checkpoint) {
+                writer.sync();
+                unsynced = 0;
+            }
+        }
+        writer.sync();
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::ostringstream line_out;
+        line_out << "worker " << m_index << ": shard " << shard << " done, " << (count - resumed) << " images";
+        if (resumed > 0) {
+            line_out << " (resumed after " << resumed << ")";
+        }
+        line_out << ", " << failed << " unreadable, " << std::fixed << std::setprecision(1)
+                 << (seconds > 0.0 ? (count - resumed) / seconds : 0.0) << " img/s";
+        std::cerr << line_out.str() << std::endl;
+    }
+
+    const Options &m_options;
+    const std::vector<std::string> &m_lines;
+    std::string m_out_dir;
+    size_t m_index;
+    SharedProgress &m_progress;
+    std::unique_ptr<InceptionV3Params, void (*)(void *)> m_params;
+    InceptionV3Runner m_runner;
+    uint32_t m_width;
+    uint32_t m_height;
+    Batch m_batches[2];
+    std::vector<uint8_t *> m_frames;
+    std::vector<InceptionV3BulkRecord> m_records;
+};
+
+int run_worker(const Options &options, const std::vector<std::string> &lines, const std::string &out_dir,
+               size_t index, SharedProgress &progress)
+{
+    try {
+        Worker worker(options, lines, out_dir, index, progress);
+        worker.run();
+        return 0;
+    } catch (const std::exception &e) {
+        std::cerr << "worker " << index << ": " << e.what() << std::endl;
+        return 1;
+    }
+}
+
+int run_job(const Options &options, const std::string &manifest, const std::string &out_dir)
+{
+    const std::vector<std::string> lines = read_manifest(manifest);
+    const uint32_t shards = shard_count(lines, options.shard_size);
+    if (mkdir(out_dir.c_str(), 0755) < 0 && errno != EEXIST) {
+        throw std::runtime_error("mkdir " + out_dir + ": " + std::strerror(errno));
+    }
+
+    uint64_t already_done = 0;
+    for (uint32_t shard = 0; shard < shards; shard++) {
+        already_done += shard_records(inception_v3_bulk_shard_path(out_dir, shard));
+    }
+    std::cerr << lines.size() << " images in " << shards << " shards, " << already_done << " already done"
+              << std::endl;
+
+    void *shared = mmap(nullptr, sizeof(SharedProgress), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        throw std::runtime_error(std::string("mmap: ") + std::strerror(errno));
+    }
+    SharedProgress *progress = new (shared) SharedProgress();
+    progress->next_shard.store(0);
+    progress->images.store(0);
+    progress->failed.store(0);
+
+    // Fork before any worker opens a device; HailoRT state must not cross a fork.
+    const size_t workers = std::max<size_t>(options.workers, 1);
+    std::cout.flush();
+    std::cerr.flush();
+    size_t alive = 0;
+    for (size_t i = 0; i < workers; i++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            _exit(run_worker(options, lines, out_dir, i, *progress));
+        }
+        if (pid < 0) {
+            std::cerr << "fork: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        alive++;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto last_report = start;
+    size_t failed_workers = 0;
+    while (alive > 0) {
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, WNOHANG);
+        if (pid > 0) {
+            alive--;
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                failed_workers++;
+            }
+            continue;
+        }
+        if (pid < 0 && errno != EINTR) {
+            break;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_report >= std::chrono::seconds(10)) {
+            double seconds = std::chrono::duration<double>(now - start).count();
+            uint64_t images = progress->images.load(std::memory_order_relaxed);
+            std::cerr << "progress: " << (already_done + images) << "/" << lines.size() << " images, "
+                      << std::fixed << std::setprecision(1) << images / seconds << " img/s" << std::endl;
+            last_report = now;
+        }
+    }
+
+    uint64_t incomplete = 0;
+    for (uint32_t shard = 0; shard < shards; shard++) {
+        const uint64_t count = std::min<uint64_t>(options.shard_size, lines.size() - uint64_t(shard) * options.shard_size);
+        incomplete += shard_records(inception_v3_bulk_shard_path(out_dir, shard)) < count ? 1 : 0;
+    }
+    std::cerr << progress->images.load() << " images classified this run, " << progress->failed.load()
+              << " unreadable" << std::endl;
+    munmap(shared, sizeof(SharedProgress));
+
+    if (failed_workers > 0 || incomplete > 0) {
+        std::cerr << failed_workers << " workers failed, " << incomplete
+                  << " shards incomplete; rerun the same command to resume" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int export_results(const std::string &manifest, const std::string &out_dir)
+{
+    const std::vector<std::string> lines = read_manifest(manifest);
+    std::unique_ptr<InceptionV3Params, void (*)(void *)> params(init_inception_v3("./imagenet_classes.txt", 0.0f),
+                                                                free_resources);
+
+    std::vector<std::string> names;
+    DIR *dir = opendir(out_dir.c_str());
+    if (dir == nullptr) {
+        throw std::runtime_error("cannot open " + out_dir);
+    }
+    while (dirent *entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name.compare(0, 6, "shard_") == 0 && name.size() > 5 && name.compare(name.size() - 5, 5, ".iv3b") == 0) {
+            names.push_back(name);
+        }
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+
+    std::cout << "path,status,class_id,label,confidence\n";
+    uint64_t exported = 0;
+    for (auto &name : names) {
+        InceptionV3BulkShardHeader header;
+        auto records = read_inception_v3_bulk_shard(out_dir + "/" + name, header);
+        if (header.first_line + header.line_count > lines.size() ||
+            header.lines_hash != hash_inception_v3_bulk_lines(lines, header.first_line, header.line_count)) {
+            throw std::runtime_error(name + " was written for a different manifest");
+        }
+
+        for (size_t i = 0; i < records.size(); i++) {
+            const auto &record = records[i];
+            std::cout << lines[header.first_line + i] << ',';
+            if (record.flags & INCEPTION_V3_BULK_FAILED) {
+                std::cout << "failed,,,\n";
+                continue;
+            }
+            int class_id = record.top_k_count > 0 ? record.class_ids[0] : -1;
+            std::string label = class_id >= 0 && static_cast<size_t>(class_id) < params->labels.size()
+                                    ? params->labels[class_id] : "";
+            std::cout << ((record.flags & INCEPTION_V3_BULK_VALID) ? "ok" : "low") << ',' << class_id << ",\""
+                      << label << "\"," << (record.top_k_count > 0 ? record.confidences[0] / 65535.0f : 0.0f)
+                      << '\n';
+        }
+        exported += records.size();
+    }
+    std::cerr << "Exported " << exported << " of " << lines.size() << " images" << std::endl;
+    return 0;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    bool export_mode = false;
+    std::vector<std::string> positional;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            bool has_value = i + 1 < argc;
+            if (arg == "--hef" && has_value) {
+                options.hef_path = argv[++i];
+            } else if (arg == "--cpu" && has_value) {
+                auto parts = split(argv[++i], ',');
+                options.cpu_weights = parts.empty() ? "" : parts[0];
+                options.cpu_threads = parts.size() > 1 ? std::stoul(parts[1]) : 0;
+            } else if (arg == "--simulate") {
+                options.simulate = true;
+            } else if (arg == "--devices" && has_value) {
+                options.devices = split(argv[++i], ',');
+            } else if (arg == "--workers" && has_value) {
+                options.workers = std::stoul(argv[++i]);
+            } else if (arg == "--shard-size" && has_value) {
+                options.shard_size = std::max<uint64_t>(std::stoull(argv[++i]), 1);
+            } else if (arg == "--batch" && has_value) {
+                options.batch_size = std::max<size_t>(std::stoul(argv[++i]), 1);
+            } else if (arg == "--checkpoint" && has_value) {
+                options.checkpoint = std::max<uint64_t>(std::stoull(argv[++i]), 1);
+            } else if (arg == "--threshold" && has_value) {
+                options.threshold = std::stof(argv[++i]);
+            } else if (arg == "--export") {
+                export_mode = true;
+            } else if (arg.compare(0, 2, "--") == 0) {
+                print_usage(argv[0]);
+                return 1;
+            } else {
+                positional.push_back(arg);
+            }
+        }
+
+        if (positional.size() != 2) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        if (export_mode) {
+            return export_results(positional[0], positional[1]);
+        }
+        if (options.hef_path.empty() && options.cpu_weights.empty() && !options.simulate) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        if (options.workers == 0) {
+            options.workers = std::max<size_t>(options.devices.size(), 1);
+        }
+        if (!options.hef_path.empty() && options.workers > std::max<size_t>(options.devices.size(), 1)) {
+            throw std::invalid_argument("--hef with " + std::to_string(options.workers) +
+                                        " workers needs as many --devices, one device per worker");
+        }
+        return run_job(options, positional[0], positional[1]);
+
+    } catch (const std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+}
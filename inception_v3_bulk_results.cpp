@@ -0,0 +1,193 @@
+#include "inception_v3_bulk_results.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+std::runtime_error errno_error(const std::string &what)
+{
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+void write_all(int fd, const void *data, size_t size, const std::string &path)
+{
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    while (size > 0) {
+        ssize_t written = ::write(fd, bytes, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw errno_error("write " + path);
+        }
+        bytes += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
+bool read_header(int fd, InceptionV3BulkShardHeader &header)
+{
+    return pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+}
+
+bool is_shard_header(const InceptionV3BulkShardHeader &header)
+{
+    return header.magic == INCEPTION_V3_BULK_MAGIC && header.version == INCEPTION_V3_BULK_VERSION &&
+           header.record_size == sizeof(InceptionV3BulkRecord);
+}
+}
+
+InceptionV3BulkRecord make_inception_v3_bulk_record(const InceptionV3Result &result)
+{
+    InceptionV3BulkRecord record;
+    std::memset(&record, 0, sizeof(record));
+    record.top_k_count = static_cast<uint16_t>(std::min(result.top_k_count, INCEPTION_V3_BULK_TOP_K));
+    record.flags = result.valid ? INCEPTION_V3_BULK_VALID : 0;
+    for (size_t k = 0; k < record.top_k_count; k++) {
+        float confidence = std::min(std::max(result.top_k_confidences[k], 0.0f), 1.0f);
+        record.class_ids[k] = static_cast<uint16_t>(result.top_k_ids[k]);
+        record.confidences[k] = static_cast<uint16_t>(std::lround(confidence * 65535.0f));
+    }
+    return record;
+}
+
+uint64_t hash_inception_v3_bulk_lines(const std::vector<std::string> &lines, uint64_t first, uint64_t count)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (uint64_t i = first; i < first + count; i++) {
+        for (unsigned char c : lines[i]) {
+            hash = (hash ^ c) * 1099511628211ull;
+        }
+        hash = (hash ^ '\n') * 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string inception_v3_bulk_shard_path(const std::string &dir, uint32_t shard_index)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "shard_%08u.iv3b", shard_index);
+    return dir + "/" + name;
+}
+
+InceptionV3BulkShardWriter::InceptionV3BulkShardWriter(const std::string &path, uint32_t shard_index,
+                                                       uint64_t first_line, uint64_t line_count,
+                                                       uint64_t lines_hash)
+    : m_path(path), m_fd(-1), m_line_count(line_count), m_done(0)
+{
+    m_fd = open(path.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+    if (m_fd < 0) {
+        throw errno_error("open " + path);
+    }
+
+    try {
+        struct stat st;
+        if (fstat(m_fd, &st) < 0) {
+            throw errno_error("fstat " + path);
+        }
+        const uint64_t size = static_cast<uint64_t>(st.st_size);
+
+        if (size < sizeof(InceptionV3BulkShardHeader)) {
+            // New shard, or one whose header never made it to disk.
+            InceptionV3BulkShardHeader header;
+            std::memset(&header, 0, sizeof(header));
+            header.magic = INCEPTION_V3_BULK_MAGIC;
+            header.version = INCEPTION_V3_BULK_VERSION;
+            header.record_size = sizeof(InceptionV3BulkRecord);
+            header.shard_index = shard_index;
+            header.first_line = first_line;
+            header.line_count = line_count;
+            header.lines_hash = lines_hash;
+            if (ftruncate(m_fd, 0) < 0) {
+                throw errno_error("ftruncate " + path);
+            }
+            write_all(m_fd, &header, sizeof(header), path);
+            sync();
+            return;
+        }
+
+        InceptionV3BulkShardHeader header;
+        if (!read_header(m_fd, header) || !is_shard_header(header)) {
+            throw std::runtime_error(path + " is not an inception_v3 bulk shard");
+        }
+        if (header.shard_index != shard_index || header.first_line != first_line ||
+            header.line_count != line_count || header.lines_hash != lines_hash) {
+            throw std::runtime_error(path + " was written for different manifest lines; resume with the same "
+                                            "manifest and shard size, or use a new output directory");
+        }
+
+        const uint64_t records = (size - sizeof(header)) / sizeof(InceptionV3BulkRecord);
+        if (records > line_count) {
+            throw std::runtime_error(path + " holds more records than its shard has lines");
+        }
+        const uint64_t whole = sizeof(header) + records * sizeof(InceptionV3BulkRecord);
+        if (whole != size && ftruncate(m_fd, static_cast<off_t>(whole)) < 0) {
+            throw errno_error("ftruncate " + path);
+        }
+        if (lseek(m_fd, static_cast<off_t>(whole), SEEK_SET) < 0) {
+            throw errno_error("lseek " + path);
+        }
+        m_done = records;
+    } catch (...) {
+        ::close(m_fd);
+        throw;
+    }
+}
+
+InceptionV3BulkShardWriter::~InceptionV3BulkShardWriter()
+{
+    if (fdatasync(m_fd) < 0) {
+        std::perror("fdatasync bulk shard");
+    }
+    ::close(m_fd);
+}
+
+void InceptionV3BulkShardWriter::append(const InceptionV3BulkRecord *records, size_t count)
+{
+    if (m_done + count > m_line_count) {
+        throw std::logic_error("appending past the end of shard " + m_path);
+    }
+    write_all(m_fd, records, count * sizeof(InceptionV3BulkRecord), m_path);
+    m_done += count;
+}
+
+void InceptionV3BulkShardWriter::sync()
+{
+    if (fdatasync(m_fd) < 0) {
+        throw errno_error("fdatasync " + m_path);
+    }
+}
+
+std::vector<InceptionV3BulkRecord> read_inception_v3_bulk_shard(const std::string &path,
+                                                                InceptionV3BulkShardHeader &header)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw errno_error("open " + path);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || !read_header(fd, header) || !is_shard_header(header)) {
+        ::close(fd);
+        throw std::runtime_error(path + " is not an inception_v3 bulk shard");
+    }
+
+    uint64_t count = (static_cast<uint64_t>(st.st_size) - sizeof(header)) / sizeof(InceptionV3BulkRecord);
+    count = std::min(count, header.line_count);
+    std::vector<InceptionV3BulkRecord> records(count);
+    const ssize_t bytes = static_cast<ssize_t>(count * sizeof(InceptionV3BulkRecord));
+    if (count > 0 && pread(fd, records.data(), bytes, sizeof(header)) != bytes) {
+        auto error = errno_error("read " + path);
+        ::close(fd);
+        throw error;
+    }
+    ::close(fd);
+    return records;
+}
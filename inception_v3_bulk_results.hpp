@@ -0,0 +1,85 @@
+#pragma once
+#include "inception_v3_runner.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Per-shard result files of the offline bulk job (inception_v3_bulk). A shard is
+// a contiguous range of manifest lines; its file <dir>/shard_<index>.iv3b holds a
+// header that pins it to those lines, then one 24-byte record per line in
+// manifest order. Records are appended with write() and synced at checkpoints,
+// so whatever whole records a killed job left behind are exactly the lines it
+// finished, and a resumed job carries on after them.
+
+static const uint32_t INCEPTION_V3_BULK_MAGIC = 0x49563342; // "IV3B"
+static const uint32_t INCEPTION_V3_BULK_VERSION = 1;
+static const size_t INCEPTION_V3_BULK_TOP_K = 5;
+
+struct InceptionV3BulkShardHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t shard_index;
+    uint64_t first_line;        // manifest line of the first record
+    uint64_t line_count;
+    uint64_t lines_hash;        // FNV-1a of the shard's manifest lines
+    uint8_t reserved[24];
+};
+static_assert(sizeof(InceptionV3BulkShardHeader) == 64, "shard header is one cache line");
+
+struct InceptionV3BulkRecord
+{
+    uint16_t top_k_count;
+    uint16_t flags;             // INCEPTION_V3_BULK_VALID, INCEPTION_V3_BULK_FAILED
+    uint16_t class_ids[INCEPTION_V3_BULK_TOP_K];
+    uint16_t confidences[INCEPTION_V3_BULK_TOP_K];  // confidence * 65535
+};
+static_assert(sizeof(InceptionV3BulkRecord) == 24, "bulk records are 24 bytes");
+
+static const uint16_t INCEPTION_V3_BULK_VALID = 1u << 0;   // top-1 passed the confidence threshold
+static const uint16_t INCEPTION_V3_BULK_FAILED = 1u << 1;  // the image could not be read or decoded
+
+InceptionV3BulkRecord make_inception_v3_bulk_record(const InceptionV3Result &result);
+
+// Hash of lines[first, first + count), stored in the shard header so a resume
+// against an edited manifest fails instead of mixing results.
+uint64_t hash_inception_v3_bulk_lines(const std::vector<std::string> &lines, uint64_t first, uint64_t count);
+
+std::string inception_v3_bulk_shard_path(const std::string &dir, uint32_t shard_index);
+
+// Single writer per shard. Opens the shard file, creating it or, when a previous
+// run left one, checking that it covers the same lines and dropping a torn
+// trailing record.
+class InceptionV3BulkShardWriter
+{
+public:
+    InceptionV3BulkShardWriter(const std::string &path, uint32_t shard_index, uint64_t first_line,
+                               uint64_t line_count, uint64_t lines_hash);
+    ~InceptionV3BulkShardWriter();
+
+    InceptionV3BulkShardWriter(const InceptionV3BulkShardWriter &) = delete;
+    InceptionV3BulkShardWriter &operator=(const InceptionV3BulkShardWriter &) = delete;
+
+    // Records in the file, i.e. lines already done.
+    uint64_t done() const { return m_done; }
+    bool complete() const { return m_done == m_line_count; }
+
+    void append(const InceptionV3BulkRecord *records, size_t count);
+
+    // fdatasync: everything appended so far survives a machine crash, not only
+    // a killed process.
+    void sync();
+
+private:
+    std::string m_path;
+    int m_fd;
+    uint64_t m_line_count;
+    uint64_t m_done;
+};
+
+// Reads a whole shard file (including one still being written); a torn trailing
+// record is ignored.
+std::vector<InceptionV3BulkRecord> read_inception_v3_bulk_shard(const std::string &path,
+                                                                InceptionV3BulkShardHeader &header);
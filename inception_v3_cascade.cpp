@@ -0,0 +1,192 @@
+#include "inception_v3_cascade.hpp"
+#include "inception_v3_cpu_backend.hpp"
+#include "inception_v3_hailortpp.hpp"
+#include "inception_v3_image.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+// Score quantization of a vstream; outputs without quant info are read as the
+// postprocess reads them, byte / 255.
+hailo_quant_info_t score_quant(const hailo_vstream_info_t &info)
+{
+    hailo_quant_info_t quant = info.quant_info;
+    if (!(quant.qp_scale > 0.0f)) {
+        quant.qp_scale = 1.0f / 255.0f;
+        quant.qp_zp = 0.0f;
+    }
+    return quant;
+}
+} // namespace
+
+InceptionV3CascadeConfig InceptionV3CascadeConfig::parse(const std::string &spec)
+{
+    InceptionV3CascadeConfig config;
+    std::stringstream stream(spec);
+    std::string entry;
+    while (std::getline(stream, entry, ';')) {
+        if (entry.empty()) {
+            continue;
+        }
+        auto equals = entry.find('=');
+        if (equals == std::string::npos) {
+            throw std::invalid_argument("cascade entry without '=': " + entry);
+        }
+
+        std::string key = entry.substr(0, equals);
+        std::string value = entry.substr(equals + 1);
+        if (key == "threshold") {
+            config.escalate_below = std::stof(value);
+        } else if (key == "classes") {
+            std::stringstream ranges(value);
+            std::string range;
+            while (std::getline(ranges, range, ',')) {
+                if (range.empty()) {
+                    continue;
+                }
+                auto dash = range.find('-');
+                size_t first = std::stoul(range.substr(0, dash));
+                size_t last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+                if (last < first) {
+                    throw std::invalid_argument("empty cascade class range " + range);
+                }
+                if (config.escalate_classes.size() <= last) {
+                    config.escalate_classes.resize(last + 1, false);
+                }
+                std::fill(config.escalate_classes.begin() + first, config.escalate_classes.begin() + last + 1, true);
+            }
+        } else {
+            throw std::invalid_argument("unknown cascade option " + key);
+        }
+    }
+    return config;
+}
+
+InceptionV3CascadeBackend::InceptionV3CascadeBackend(std::unique_ptr<InceptionV3Backend> first,
+                                                     std::unique_ptr<InceptionV3Backend> second,
+                                                     const InceptionV3CascadeConfig &config)
+    : m_first(std::move(first)), m_second(std::move(second)), m_config(config), m_frames(0), m_escalated(0)
+{
+    m_first_input = m_first->input_info();
+    m_second_input = m_second->input_info();
+    auto first_output = m_first->output_info();
+    auto second_output = m_second->output_info();
+
+    if (m_first->output_frame_size() != m_second->output_frame_size()) {
+        throw std::invalid_argument("cascade stages score " + std::to_string(m_first->output_frame_size()) + " and " +
+                                    std::to_string(m_second->output_frame_size()) + " classes");
+    }
+    if (m_first_input.shape.features != 3 || m_second_input.shape.features != 3) {
+        throw std::invalid_argument("cascade stages must both take RGB tensors");
+    }
+    m_resize = m_first_input.shape.width != m_second_input.shape.width ||
+               m_first_input.shape.height != m_second_input.shape.height;
+
+    m_first_quant = score_quant(first_output);
+    m_second_quant = score_quant(second_output);
+    for (int q = 0; q < 256; q++) {
+        float score = (q - m_first_quant.qp_zp) * m_first_quant.qp_scale;
+        float requantized = std::round(score / m_second_quant.qp_scale + m_second_quant.qp_zp);
+        m_requantize[q] = static_cast<uint8_t>(std::min(std::max(requantized, 0.0f), 255.0f));
+    }
+}
+
+InceptionV3CascadeStats InceptionV3CascadeBackend::stats() const
+{
+    InceptionV3CascadeStats stats;
+    stats.frames = m_frames;
+    stats.escalated = m_escalated;
+    return stats;
+}
+
+void InceptionV3CascadeBackend::infer(const std::vector<uint8_t *> &inputs, const std::vector<uint8_t *> &outputs)
+{
+    const size_t batch = inputs.size();
+    const size_t classes = output_frame_size();
+    while (m_first_outputs.size() < batch) {
+        m_first_outputs.emplace_back(m_first->output_frame_size());
+        if (m_resize) {
+            m_first_inputs.emplace_back(m_first->input_frame_size());
+        }
+    }
+
+    // First stage on the whole batch.
+    m_first_input_ptrs.clear();
+    m_first_output_ptrs.clear();
+    for (size_t i = 0; i < batch; i++) {
+        if (m_resize) {
+            resize_frame_to_rgb(inputs[i], INCEPTION_V3_FORMAT_RGB, m_second_input.shape.width,
+                                m_second_input.shape.height, m_first_inputs[i].data(), m_first_input.shape.width,
+                                m_first_input.shape.height);
+            m_first_input_ptrs.push_back(m_first_inputs[i].data());
+        } else {
+            m_first_input_ptrs.push_back(inputs[i]);
+        }
+        m_first_output_ptrs.push_back(m_first_outputs[i].data());
+    }
+    m_first->infer(m_first_input_ptrs, m_first_output_ptrs);
+
+    // Gate on the first stage's top-1; settled frames take its scores.
+    m_second_input_ptrs.clear();
+    m_second_output_ptrs.clear();
+    m_escalated_flags.assign(batch, 0);
+    for (size_t i = 0; i < batch; i++) {
+        const uint8_t *scores = m_first_outputs[i].data();
+        int top1 = 0;
+        float unused;
+        top_k_inception_v3(scores, classes, 1, &top1, &unused);
+        const float confidence = (scores[top1] - m_first_quant.qp_zp) * m_first_quant.qp_scale;
+        const bool of_interest = static_cast<size_t>(top1) < m_config.escalate_classes.size() &&
+                                 m_config.escalate_classes[top1];
+
+        if (confidence < m_config.escalate_below || of_interest) {
+            m_escalated_flags[i] = 1;
+            m_second_input_ptrs.push_back(inputs[i]);
+            m_second_output_ptrs.push_back(outputs[i]);
+        } else {
+            for (size_t c = 0; c < classes; c++) {
+                outputs[i][c] = m_requantize[scores[c]];
+            }
+        }
+    }
+
+    // Second stage on the escalated frames only, still as one batch.
+    if (!m_second_input_ptrs.empty()) {
+        m_second->infer(m_second_input_ptrs, m_second_output_ptrs);
+    }
+    m_frames += batch;
+    m_escalated += m_second_input_ptrs.size();
+}
+
+std::unique_ptr<InceptionV3Backend> make_inception_v3_cascade_stage(const std::string &spec)
+{
+    if (spec.compare(0, 8, "simulate") == 0) {
+        auto frame_us = spec.size() > 9 && spec[8] == ':' ? std::stoul(spec.substr(9)) : 1000ul;
+        return std::unique_ptr<InceptionV3Backend>(new InceptionV3SimulatedBackend(
+            std::chrono::microseconds(frame_us), std::chrono::microseconds(frame_us / 4)));
+    }
+
+    size_t comma = spec.rfind(',');
+    std::string path = comma == std::string::npos ? spec : spec.substr(0, comma);
+    if (path.size() > 5 && path.compare(path.size() - 5, 5, ".iv3w") == 0) {
+        size_t threads = comma == std::string::npos ? 0 : std::stoul(spec.substr(comma + 1));
+        std::unique_ptr<InceptionV3CpuBackend> stage(new InceptionV3CpuBackend(path, threads));
+        if (!stage->small_model()) {
+            throw std::invalid_argument("cascade first stage " + path +
+                                        " is the full Inception-v3, slower than the stage it would save; "
+                                        "export a small model with export_cpu_weights.py --small");
+        }
+        return std::unique_ptr<InceptionV3Backend>(stage.release());
+    }
+    if (path.size() > 4 && path.compare(path.size() - 4, 4, ".hef") == 0) {
+        throw std::invalid_argument("cascade first stage " + spec +
+                                    ": a HEF would open the accelerator a second time; use a small CPU "
+                                    "model (<weights>.iv3w) or simulate");
+    }
+    throw std::invalid_argument("unknown cascade first stage " + spec +
+                                ", expected <small model>.iv3w[,<threads>] or simulate[:<frame_us>]");
+}
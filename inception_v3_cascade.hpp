@@ -0,0 +1,88 @@
+#pragma once
+#include "inception_v3_backend.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct InceptionV3CascadeConfig
+{
+    float escalate_below = 0.6f;            // first-stage top-1 confidence below this goes to the second stage
+    std::vector<bool> escalate_classes;     // by class id; a first-stage top-1 in the set always goes on
+
+    // "threshold=0.6;classes=0-397,409,530" (class ids, ranges inclusive).
+    static InceptionV3CascadeConfig parse(const std::string &spec);
+};
+
+struct InceptionV3CascadeStats
+{
+    uint64_t frames = 0;
+    uint64_t escalated = 0;     // frames the second stage ran on
+};
+
+// Confidence-gated two-stage backend. Every frame of a batch runs through a
+// cheap first stage (a small CPU model, see InceptionV3CpuBackend, or the
+// simulator); only frames whose top-1 confidence is below the threshold, or
+// whose top-1 is in the class set of interest, run through the second stage
+// (Inception-v3), as one batch. It only saves time when the first stage costs
+// well under a second-stage frame: a 128x128 five-convolution model runs in
+// about 3.5 ms per frame on one core, Inception-v3 on the CPU in hundreds.
+//
+// To everything above the backend interface the cascade is the second stage:
+// it takes the second stage's input tensor (resized for the first stage when
+// its input is smaller) and writes the second stage's output format. Frames the
+// first stage settles get their scores requantized into that format, so both
+// kinds go through the same postprocess into the same HailoClassification.
+// Both stages must score the same classes.
+class InceptionV3CascadeBackend : public InceptionV3Backend
+{
+public:
+    InceptionV3CascadeBackend(std::unique_ptr<InceptionV3Backend> first, std::unique_ptr<InceptionV3Backend> second,
+                              const InceptionV3CascadeConfig &config);
+
+    hailo_vstream_info_t input_info() const override { return m_second->input_info(); }
+    hailo_vstream_info_t output_info() const override { return m_second->output_info(); }
+    size_t input_frame_size() const override { return m_second->input_frame_size(); }
+    size_t output_frame_size() const override { return m_second->output_frame_size(); }
+
+    void infer(const std::vector<uint8_t *> &inputs, const std::vector<uint8_t *> &outputs) override;
+
+    InceptionV3Backend &first_stage() { return *m_first; }
+    InceptionV3Backend &second_stage() { return *m_second; }
+    InceptionV3CascadeStats stats() const;
+
+    // Whether the index-th frame of the last infer() went to the second stage.
+    bool escalated(size_t index) const { return m_escalated_flags[index] != 0; }
+
+private:
+    std::unique_ptr<InceptionV3Backend> m_first;
+    std::unique_ptr<InceptionV3Backend> m_second;
+    InceptionV3CascadeConfig m_config;
+    hailo_vstream_info_t m_first_input;
+    hailo_vstream_info_t m_second_input;
+    hailo_quant_info_t m_first_quant;
+    hailo_quant_info_t m_second_quant;
+    bool m_resize;              // the first stage takes a different input resolution
+    uint8_t m_requantize[256];  // first-stage score byte -> second-stage score byte
+
+    // Per-batch scratch, grown to the largest batch seen.
+    std::vector<std::vector<uint8_t>> m_first_inputs;
+    std::vector<std::vector<uint8_t>> m_first_outputs;
+    std::vector<uint8_t *> m_first_input_ptrs;
+    std::vector<uint8_t *> m_first_output_ptrs;
+    std::vector<uint8_t *> m_second_input_ptrs;
+    std::vector<uint8_t *> m_second_output_ptrs;
+    std::vector<uint8_t> m_escalated_flags;
+
+    std::atomic<uint64_t> m_frames;
+    std::atomic<uint64_t> m_escalated;
+};
+
+// First stage from a command-line spec: "<weights>.iv3w[,<threads>]" (a small
+// model written by export_cpu_weights.py --small) or "simulate[:<frame_us>]".
+// Full Inception-v3 weights are rejected as slower than any second stage. So is
+// a HEF: its backend would open a second Device and network group next to the
+// second stage's on the same accelerator, which needs a shared VDevice and the
+// scheduler this tree does not use.
+std::unique_ptr<InceptionV3Backend> make_inception_v3_cascade_stage(const std::string &spec);
@@ -0,0 +1,184 @@
+#include "inception_v3_classifier.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+// Hands submitted frames to the pipeline. Runs on the pipeline's capture thread.
+class InceptionV3Classifier::SubmissionSource : public InceptionV3FrameSource
+{
+public:
+    explicit SubmissionSource(InceptionV3Classifier &classifier) : m_classifier(classifier) {}
+
+    bool next(InceptionV3Frame &frame) override
+    {
+        RequestPtr request;
+        while (m_classifier.m_submissions.pop(request)) {
+            if (request->token.cancelled()) {
+                m_classifier.complete(*request, InceptionV3Result(),
+                                      std::make_exception_ptr(InceptionV3Cancelled()));
+                continue;
+            }
+
+            // Swap buffers instead of copying; the request's frame gets the pool
+            // frame's old storage, which is freed with the request.
+            std::swap(frame.data, request->frame.data);
+            frame.stream_id = request->frame.stream_id;
+            frame.seq = request->id;
+            frame.capture_time_ns = request->frame.capture_time_ns;
+            frame.pts_ns = request->frame.pts_ns;
+            frame.width = request->frame.width;
+            frame.height = request->frame.height;
+            frame.format = request->frame.format;
+
+            std::lock_guard<std::mutex> lock(m_classifier.m_mutex);
+            m_classifier.m_pending[request->id] = std::move(request);
+            return true;
+        }
+        return false;
+    }
+
+    // A failed pipeline stops reading submissions; run_pipeline() then fails
+    // whatever is still queued or pending.
+    void close() override { m_classifier.m_submissions.close(); }
+
+private:
+    InceptionV3Classifier &m_classifier;
+};
+
+InceptionV3Classifier::InceptionV3Classifier(InceptionV3Runner &runner, const InceptionV3ClassifierConfig &config)
+    : m_config(config), m_submissions(std::max<size_t>(config.max_in_flight, 1)), m_in_flight(0), m_next_id(0)
+{
+    m_config.max_in_flight = m_submissions.capacity();
+    m_pipeline.reset(new InceptionV3Pipeline(runner, m_config.pipeline,
+                                             [this](const InceptionV3PipelineResult &result) { on_result(result); }));
+    m_pipeline->add_source(std::unique_ptr<InceptionV3FrameSource>(new SubmissionSource(*this)));
+    m_thread = std::thread(&InceptionV3Classifier::run_pipeline, this);
+}
+
+InceptionV3Classifier::~InceptionV3Classifier()
+{
+    m_submissions.close();
+    m_thread.join();
+}
+
+size_t InceptionV3Classifier::in_flight() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_in_flight;
+}
+
+std::future<InceptionV3Result> InceptionV3Classifier::submit(InceptionV3Frame frame, InceptionV3CancelToken token)
+{
+    auto promise = std::make_shared<std::promise<InceptionV3Result>>();
+    auto future = promise->get_future();
+    submit(std::move(frame), [promise](const InceptionV3Result &result, std::exception_ptr error) {
+        if (error) {
+            promise->set_exception(error);
+        } else {
+            promise->set_value(result);
+        }
+    }, std::move(token));
+    return future;
+}
+
+void InceptionV3Classifier::submit(InceptionV3Frame frame, Callback callback, InceptionV3CancelToken token)
+{
+    // Preprocess reads the whole frame, so a short buffer would be read past its end.
+    if (frame.width == 0 || frame.height == 0 ||
+        frame.data.size() < inception_v3_frame_bytes(frame.format, frame.width, frame.height)) {
+        throw std::invalid_argument("frame data is smaller than its format and size require");
+    }
+
+    RequestPtr request(new Request());
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_in_flight >= m_config.max_in_flight) {
+            if (!m_config.block_when_full) {
+                throw InceptionV3Overloaded();
+            }
+            m_capacity.wait(lock, [this]() { return m_in_flight < m_config.max_in_flight; });
+        }
+        m_in_flight++;
+        request->id = m_next_id++;
+    }
+
+    if (frame.capture_time_ns == 0) {
+        frame.capture_time_ns = inception_v3_now_ns();
+    }
+    request->frame = std::move(frame);
+    request->callback = std::move(callback);
+    request->token = std::move(token);
+
+    // Capacity was reserved above, so this never blocks for long; it only fails
+    // once the classifier is shutting down.
+    if (!m_submissions.push(std::move(request))) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_in_flight--;
+        throw InceptionV3Cancelled();
+    }
+}
+
+void InceptionV3Classifier::complete(Request &request, const InceptionV3Result &result, std::exception_ptr error)
+{
+    // The slot is freed before the callback runs: a callback that resubmits (the
+    // usual streaming pattern) would otherwise wait in submit() for a slot that
+    // only this thread can free.
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_in_flight--;
+        m_capacity.notify_one();
+    }
+
+    if (request.callback) {
+        request.callback(result, error);
+    }
+}
+
+void InceptionV3Classifier::on_result(const InceptionV3PipelineResult &result)
+{
+    RequestPtr request;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_pending.find(result.seq);
+        if (it == m_pending.end()) {
+            return;
+        }
+        request = std::move(it->second);
+        m_pending.erase(it);
+    }
+
+    if (request->token.cancelled()) {
+        complete(*request, InceptionV3Result(), std::make_exception_ptr(InceptionV3Cancelled()));
+        return;
+    }
+    complete(*request, result.result, nullptr);
+}
+
+void InceptionV3Classifier::run_pipeline()
+{
+    std::exception_ptr error;
+    try {
+        m_pipeline->run();
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    // After a pipeline failure, fail whatever was accepted but never answered.
+    m_submissions.close();
+    if (!error) {
+        error = std::make_exception_ptr(InceptionV3Cancelled());
+    }
+
+    std::unordered_map<uint64_t, RequestPtr> pending;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        pending.swap(m_pending);
+    }
+    for (auto &entry : pending) {
+        complete(*entry.second, InceptionV3Result(), error);
+    }
+
+    RequestPtr request;
+    while (m_submissions.pop(request)) {
+        complete(*request, InceptionV3Result(), error);
+    }
+}
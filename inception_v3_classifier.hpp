@@ -0,0 +1,104 @@
+#pragma once
+#include "inception_v3_pipeline.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+class InceptionV3Cancelled : public std::runtime_error
+{
+public:
+    InceptionV3Cancelled() : std::runtime_error("classification cancelled") {}
+};
+
+class InceptionV3Overloaded : public std::runtime_error
+{
+public:
+    InceptionV3Overloaded() : std::runtime_error("classifier has no free in-flight capacity") {}
+};
+
+// Shared flag; copies refer to the same request(s). Cancel only drops requests
+// still in the submission queue. Once the pipeline has taken a request it runs
+// through preprocess and the device regardless, and is reported cancelled when
+// its result arrives.
+class InceptionV3CancelToken
+{
+public:
+    InceptionV3CancelToken() : m_flag(std::make_shared<std::atomic<bool>>(false)) {}
+
+    void cancel() { m_flag->store(true); }
+    bool cancelled() const { return m_flag->load(); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> m_flag;
+};
+
+struct InceptionV3ClassifierConfig
+{
+    size_t max_in_flight = 32;
+    bool block_when_full = true;    // false: submit throws InceptionV3Overloaded instead of waiting
+    InceptionV3PipelineConfig pipeline;
+};
+
+// Embeddable classifier: submit frames of any resolution from any thread and get
+// results through a future or a callback. Runs an InceptionV3Pipeline in the
+// background, whose single source is the queue of submitted frames.
+class InceptionV3Classifier
+{
+public:
+    // Callbacks run on the pipeline's postprocess thread and should return quickly.
+    // error is set (and result empty) for cancelled or failed requests. The
+    // request's slot is released before its callback runs, so a callback may
+    // submit the next frame even when the classifier is full.
+    using Callback = std::function<void(const InceptionV3Result &result, std::exception_ptr error)>;
+
+    explicit InceptionV3Classifier(InceptionV3Runner &runner,
+                                   const InceptionV3ClassifierConfig &config = InceptionV3ClassifierConfig());
+    // Completes every accepted request before returning.
+    ~InceptionV3Classifier();
+
+    InceptionV3Classifier(const InceptionV3Classifier &) = delete;
+    InceptionV3Classifier &operator=(const InceptionV3Classifier &) = delete;
+
+    // Throws std::invalid_argument when frame.data is smaller than its format
+    // and size need, InceptionV3Overloaded when full and not blocking, and
+    // InceptionV3Cancelled once the classifier has shut down or failed.
+    std::future<InceptionV3Result> submit(InceptionV3Frame frame,
+                                          InceptionV3CancelToken token = InceptionV3CancelToken());
+    void submit(InceptionV3Frame frame, Callback callback, InceptionV3CancelToken token = InceptionV3CancelToken());
+
+    size_t in_flight() const;
+
+private:
+    struct Request
+    {
+        uint64_t id = 0;
+        InceptionV3Frame frame;
+        Callback callback;
+        InceptionV3CancelToken token;
+    };
+    using RequestPtr = std::unique_ptr<Request>;
+    class SubmissionSource;
+
+    void complete(Request &request, const InceptionV3Result &result, std::exception_ptr error);
+    void on_result(const InceptionV3PipelineResult &result);
+    void run_pipeline();
+
+    InceptionV3ClassifierConfig m_config;
+    InceptionV3Queue<RequestPtr> m_submissions;
+    std::unique_ptr<InceptionV3Pipeline> m_pipeline;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_capacity;
+    size_t m_in_flight;
+    uint64_t m_next_id;
+    std::unordered_map<uint64_t, RequestPtr> m_pending;     // on the pipeline, keyed by frame seq
+
+    std::thread m_thread;
+};
@@ -0,0 +1,88 @@
+#include "inception_v3_classifier.hpp"
+#include "inception_v3_test.hpp"
+#include <unistd.h>
+
+// InceptionV3Classifier input checks and failure handling. A device error must
+// fail every accepted request promptly, not leave their futures waiting for the
+// classifier's destructor; a hang is caught by the alarm below.
+
+namespace
+{
+class FailingBackend : public InceptionV3SimulatedBackend
+{
+public:
+    void infer(const std::vector<uint8_t *> &, const std::vector<uint8_t *> &) override
+    {
+        throw std::runtime_error("device lost");
+    }
+};
+
+InceptionV3Frame make_frame(uint32_t width, uint32_t height)
+{
+    InceptionV3Frame frame;
+    frame.width = width;
+    frame.height = height;
+    frame.data.assign(inception_v3_frame_bytes(frame.format, width, height), 128);
+    return frame;
+}
+
+void check_short_frames(InceptionV3Runner &runner)
+{
+    InceptionV3Classifier classifier(runner);
+    InceptionV3Frame frames[3] = {make_frame(64, 48), make_frame(0, 48), make_frame(64, 48)};
+    frames[0].data.pop_back();
+    frames[2].format = INCEPTION_V3_FORMAT_NV12;
+    frames[2].data.resize(64 * 48);
+    for (size_t i = 0; i < 3; i++) {
+        bool rejected = false;
+        try {
+            classifier.submit(std::move(frames[i]));
+        } catch (const std::invalid_argument &) {
+            rejected = true;
+        }
+        inception_v3_check(rejected, "submit", "short frame", i);
+    }
+    inception_v3_check(classifier.submit(make_frame(64, 48)).get().top_k_count == INCEPTION_V3_TOP_K, "submit",
+                       "full frame", 0);
+}
+
+void check_device_failure(InceptionV3Runner &runner)
+{
+    InceptionV3Classifier classifier(runner);
+
+    // One request at a time, so the pipeline's capture thread is already back
+    // waiting for the next submission when the device fails.
+    bool failed = false;
+    try {
+        classifier.submit(make_frame(64, 48)).get();
+    } catch (const std::runtime_error &) {
+        failed = true;
+    }
+    inception_v3_check(failed, "device failure", "request", 0);
+
+    bool cancelled = false;
+    try {
+        classifier.submit(make_frame(64, 48));
+    } catch (const InceptionV3Cancelled &) {
+        cancelled = true;
+    }
+    inception_v3_check(cancelled, "device failure", "later submit", 0);
+}
+} // namespace
+
+int main()
+{
+    alarm(60);
+
+    InceptionV3Params params("", 0.5f);
+    params.labels.resize(1000);
+    InceptionV3Runner runner(std::unique_ptr<InceptionV3Backend>(new InceptionV3SimulatedBackend(
+                                 std::chrono::microseconds(1000), std::chrono::microseconds(0))),
+                             &params);
+    check_short_frames(runner);
+
+    InceptionV3Runner failing(std::unique_ptr<InceptionV3Backend>(new FailingBackend()), &params);
+    check_device_failure(failing);
+
+    return inception_v3_test_result();
+}
@@ -0,0 +1,261 @@
+#include "inception_v3_config.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <poll.h>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace
+{
+std::runtime_error errno_error(const std::string &what)
+{
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+bool parse_threshold(const std::string &value, float &threshold)
+{
+    size_t parsed = 0;
+    try {
+        threshold = std::stof(value, &parsed);
+    } catch (const std::exception &) {
+        return false;
+    }
+    return !value.empty() && parsed == value.size() && threshold >= 0.0f && threshold <= 1.0f;
+}
+
+// "3,7,281-285" -> class ids, in any order.
+std::vector<size_t> parse_class_list(const std::string &value)
+{
+    std::vector<size_t> ids;
+    size_t start = 0;
+    while (start <= value.size()) {
+        size_t end = value.find(',', start);
+        std::string item = value.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        size_t dash = item.find('-');
+        size_t first = std::stoul(item.substr(0, dash));
+        size_t last = dash == std::string::npos ? first : std::stoul(item.substr(dash + 1));
+        if (last < first || last - first > 0xFFFF) {
+            throw std::invalid_argument(item);
+        }
+        for (size_t id = first; id <= last; id++) {
+            ids.push_back(id);
+        }
+        if (end == std::string::npos) {
+            break;
+        }
+        start = end + 1;
+    }
+    return ids;
+}
+} // namespace
+
+InceptionV3Params *load_inception_v3_config(const std::string &config_path)
+{
+    std::ifstream file(config_path);
+    if (!file) {
+        throw std::runtime_error("cannot open " + config_path);
+    }
+
+    std::unique_ptr<InceptionV3Params> params(new InceptionV3Params("", 0.5f));
+    std::vector<std::pair<size_t, float>> class_thresholds;
+    std::vector<size_t> allowed_ids;
+    std::vector<size_t> denied_ids;
+    bool allow_list = false;
+
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        const std::string where = config_path + ":" + std::to_string(line_number) + ": ";
+        size_t separator = line.find('=');
+        if (separator == std::string::npos) {
+            throw std::runtime_error(where + "expected key=value");
+        }
+        std::string key = line.substr(0, separator);
+        std::string value = line.substr(separator + 1);
+
+        if (key == "label") {
+            params->labels.push_back(value);
+        } else if (key == "detection_threshold") {
+            if (!parse_threshold(value, params->confidence_threshold)) {
+                throw std::runtime_error(where + "detection_threshold must be a number within [0, 1]");
+            }
+        } else if (key == "class_threshold") {
+            // class_threshold=<class id>:<threshold>
+            size_t colon = value.find(':');
+            float threshold = 0.0f;
+            size_t class_id = 0;
+            try {
+                class_id = std::stoul(value.substr(0, colon));
+            } catch (const std::exception &) {
+                colon = std::string::npos;
+            }
+            if (colon == std::string::npos || !parse_threshold(value.substr(colon + 1), threshold)) {
+                throw std::runtime_error(where + "expected class_threshold=<class id>:<threshold in [0, 1]>");
+            }
+            class_thresholds.emplace_back(class_id, threshold);
+        } else if (key == "allow_classes" || key == "deny_classes") {
+            std::vector<size_t> ids;
+            try {
+                ids = parse_class_list(value);
+            } catch (const std::exception &) {
+                throw std::runtime_error(where + "expected " + key + "=<id>[,<id>|<first>-<last>...]");
+            }
+            auto &target = key == "allow_classes" ? allowed_ids : denied_ids;
+            target.insert(target.end(), ids.begin(), ids.end());
+            allow_list = allow_list || key == "allow_classes";
+        } else {
+            throw std::runtime_error(where + "unknown key " + key);
+        }
+    }
+
+    // makeconfig.py splits the labels file on '\n', which leaves a trailing "label=".
+    while (!params->labels.empty() && params->labels.back().empty()) {
+        params->labels.pop_back();
+    }
+    if (params->labels.empty()) {
+        throw std::runtime_error(config_path + ": no labels");
+    }
+
+    if (!class_thresholds.empty() || allow_list || !denied_ids.empty()) {
+        const size_t class_count = params->labels.size();
+        std::vector<float> thresholds(class_count, -1.0f);
+        std::vector<bool> allowed(class_count, !allow_list);
+        auto check = [&](size_t class_id) {
+            if (class_id >= class_count) {
+                throw std::runtime_error(config_path + ": class id " + std::to_string(class_id) + " out of range, " +
+                                         std::to_string(class_count) + " labels");
+            }
+            return class_id;
+        };
+        for (const auto &entry : class_thresholds) {
+            thresholds[check(entry.first)] = entry.second;
+        }
+        for (size_t class_id : allowed_ids) {
+            allowed[check(class_id)] = true;
+        }
+        for (size_t class_id : denied_ids) {
+            allowed[check(class_id)] = false;
+        }
+        compile_inception_v3_filters(*params, class_count, thresholds, allowed);
+    }
+    return params.release();
+}
+
+InceptionV3ParamsWatcher::InceptionV3ParamsWatcher(const std::string &config_path)
+    : m_path(config_path), m_params(load_inception_v3_config(config_path)), m_generation(0), m_inotify_fd(-1),
+      m_stop_fd(-1)
+{
+    size_t slash = m_path.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : m_path.substr(0, slash == 0 ? 1 : slash);
+    m_file_name = slash == std::string::npos ? m_path : m_path.substr(slash + 1);
+
+    m_inotify_fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (m_inotify_fd < 0) {
+        throw errno_error("inotify_init1");
+    }
+    if (inotify_add_watch(m_inotify_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        int error = errno;
+        close(m_inotify_fd);
+        errno = error;
+        throw errno_error("inotify_add_watch " + dir);
+    }
+    m_stop_fd = eventfd(0, EFD_CLOEXEC);
+    if (m_stop_fd < 0) {
+        int error = errno;
+        close(m_inotify_fd);
+        errno = error;
+        throw errno_error("eventfd");
+    }
+
+    m_thread = std::thread(&InceptionV3ParamsWatcher::watch_loop, this);
+}
+
+InceptionV3ParamsWatcher::~InceptionV3ParamsWatcher()
+{
+    uint64_t one = 1;
+    if (write(m_stop_fd, &one, sizeof(one)) < 0) {
+        std::cerr << "config watcher: cannot signal stop: " << std::strerror(errno) << std::endl;
+    }
+    m_thread.join();
+    close(m_stop_fd);
+    close(m_inotify_fd);
+}
+
+bool InceptionV3ParamsWatcher::reload()
+{
+    std::lock_guard<std::mutex> lock(m_reload_mutex);
+
+    InceptionV3Params *params = nullptr;
+    try {
+        params = load_inception_v3_config(m_path);
+    } catch (const std::exception &e) {
+        std::cerr << "config reload rejected, keeping previous params: " << e.what() << std::endl;
+        return false;
+    }
+
+    // Postprocess indexes labels by class id, so the class count is fixed by the network.
+    size_t label_count = m_params.load()->labels.size();
+    if (params->labels.size() != label_count) {
+        std::cerr << "config reload rejected, keeping previous params: " << m_path << " has "
+                  << params->labels.size() << " labels, expected " << label_count << std::endl;
+        delete params;
+        return false;
+    }
+
+    // Returns once no frame can still be postprocessed with the old params.
+    m_params.replace(params);
+    m_generation++;
+    std::cerr << "Reloaded " << m_path << ": threshold " << params->confidence_threshold << ", "
+              << params->labels.size() << " labels" << std::endl;
+    return true;
+}
+
+void InceptionV3ParamsWatcher::watch_loop()
+{
+    alignas(inotify_event) char buffer[4096];
+    pollfd fds[2] = {{m_inotify_fd, POLLIN, 0}, {m_stop_fd, POLLIN, 0}};
+
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "config watcher: poll failed: " << std::strerror(errno) << std::endl;
+            return;
+        }
+        if (fds[1].revents) {
+            return;
+        }
+
+        // Drain every pending event; one reload covers a burst of writes.
+        bool changed = false;
+        ssize_t length;
+        while ((length = read(m_inotify_fd, buffer, sizeof(buffer))) > 0) {
+            for (char *cursor = buffer; cursor < buffer + length;) {
+                auto *event = reinterpret_cast<inotify_event *>(cursor);
+                if (event->len > 0 && m_file_name == event->name) {
+                    changed = true;
+                }
+                cursor += sizeof(inotify_event) + event->len;
+            }
+        }
+        if (changed) {
+            reload();
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "inception_v3_hailortpp.hpp"
+#include "inception_v3_rcu.hpp"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Reads the postprocess config written by makeconfig.py:
+//   detection_threshold=0.1
+//   label=tench, Tinca tinca
+//   ...
+// plus optional per-class filtering, by class id (line number among the labels):
+//   class_threshold=281:0.3      own threshold for one class
+//   allow_classes=281-285,291    report only these classes (repeatable)
+//   deny_classes=282             never report these classes (repeatable, wins over allow)
+// Labels are taken in file order; blank lines and lines starting with '#' are
+// skipped. Throws std::runtime_error on unreadable or malformed files.
+InceptionV3Params *load_inception_v3_config(const std::string &config_path);
+
+// Keeps the params of a config file current while the service runs. The file's
+// directory is watched with inotify (editors and makeconfig.py often replace the
+// file rather than rewrite it); every change is parsed into a fresh
+// InceptionV3Params and published by RCU swap. A file that fails to parse or
+// changes the number of labels is reported on stderr and the previous params
+// stay in effect.
+class InceptionV3ParamsWatcher
+{
+public:
+    explicit InceptionV3ParamsWatcher(const std::string &config_path);
+    ~InceptionV3ParamsWatcher();
+
+    InceptionV3ParamsWatcher(const InceptionV3ParamsWatcher &) = delete;
+    InceptionV3ParamsWatcher &operator=(const InceptionV3ParamsWatcher &) = delete;
+
+    // Only valid inside an InceptionV3RcuReadGuard, for as long as the guard lives.
+    InceptionV3Params *current() const { return m_params.load(); }
+
+    // Number of successful reloads since construction.
+    uint64_t generation() const { return m_generation.load(); }
+
+    // Re-reads the file now; returns false (keeping the old params) if it does not parse.
+    bool reload();
+
+private:
+    void watch_loop();
+
+    std::string m_path;
+    std::string m_file_name;
+    std::mutex m_reload_mutex;     // serializes writers only
+    InceptionV3RcuPointer<InceptionV3Params> m_params;
+    std::atomic<uint64_t> m_generation;
+    int m_inotify_fd;
+    int m_stop_fd;
+    std::thread m_thread;
+};
@@ -0,0 +1,164 @@
+#include "inception_v3_coro.hpp"
+#include <cerrno>
+#include <cstring>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+InceptionV3EventLoop::InceptionV3EventLoop()
+{
+    m_event_fd = eventfd(0, EFD_CLOEXEC);
+    if (m_event_fd < 0) {
+        throw std::runtime_error(std::string("eventfd failed: ") + std::strerror(errno));
+    }
+}
+
+InceptionV3EventLoop::~InceptionV3EventLoop()
+{
+    close(m_event_fd);
+}
+
+void InceptionV3EventLoop::post(std::coroutine_handle<> handle)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_ready.push_back(handle);
+    }
+    uint64_t one = 1;
+    while (write(m_event_fd, &one, sizeof(one)) < 0 && errno == EINTR) {
+    }
+}
+
+void InceptionV3EventLoop::spawn(InceptionV3Task<void> task)
+{
+    drive(*this, std::move(task), nullptr);
+}
+
+InceptionV3EventLoop::Detached InceptionV3EventLoop::drive(InceptionV3EventLoop &loop, InceptionV3Task<void> task,
+                                                           bool *done)
+{
+    try {
+        co_await std::move(task);
+    } catch (...) {
+        if (!loop.m_error) {
+            loop.m_error = std::current_exception();
+        }
+    }
+    if (done) {
+        *done = true;
+    }
+}
+
+void InceptionV3EventLoop::run_ready()
+{
+    uint64_t count;
+    while (read(m_event_fd, &count, sizeof(count)) < 0 && errno == EINTR) {
+    }
+
+    std::deque<std::coroutine_handle<>> ready;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ready.swap(m_ready);
+    }
+    for (auto handle : ready) {
+        handle.resume();
+    }
+}
+
+void InceptionV3EventLoop::run_until(const bool &done)
+{
+    // run_ready() blocks in read() until something is posted; spawned tasks that
+    // are still waiting when done is set simply stay suspended.
+    while (!done && !m_error) {
+        run_ready();
+    }
+    if (m_error) {
+        std::exception_ptr error = m_error;
+        m_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+InceptionV3AsyncGenerator<InceptionV3PipelineResult> InceptionV3CoroClassifier::classify_stream(
+    InceptionV3FrameSource &source)
+{
+    struct Item
+    {
+        InceptionV3PipelineResult result;
+        std::exception_ptr error;
+    };
+
+    InceptionV3Channel<Item> channel(m_loop);
+    InceptionV3CancelToken token;
+    std::atomic<bool> stopping(false);
+    std::mutex mutex;
+    std::condition_variable idle;
+    size_t outstanding = 0;
+
+    std::thread reader([&]() {
+        InceptionV3Frame frame;
+        try {
+            while (!stopping && source.next(frame)) {
+                InceptionV3PipelineResult meta;
+                meta.stream_id = frame.stream_id;
+                meta.seq = frame.seq;
+                meta.capture_time_ns = frame.capture_time_ns ? frame.capture_time_ns : inception_v3_now_ns();
+                frame.capture_time_ns = meta.capture_time_ns;
+                // Counted before submit because the callback may run before submit
+                // returns; a submit that throws (overloaded, shut down) never calls it.
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    outstanding++;
+                }
+                try {
+                    m_classifier.submit(std::move(frame), [&, meta](const InceptionV3Result &result,
+                                                                    std::exception_ptr error) mutable {
+                        meta.done_time_ns = inception_v3_now_ns();
+                        meta.result = result;
+                        channel.send(Item{std::move(meta), error});
+                        std::lock_guard<std::mutex> lock(mutex);
+                        outstanding--;
+                        idle.notify_all();
+                    }, token);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    outstanding--;
+                    idle.notify_all();
+                    throw;
+                }
+                frame = InceptionV3Frame();
+            }
+        } catch (...) {
+            channel.send(Item{InceptionV3PipelineResult(), std::current_exception()});
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [&]() { return outstanding == 0; });
+        channel.close();
+    });
+
+    // Runs when the generator finishes or is destroyed early; joins the reader so
+    // no callback outlives the locals above.
+    struct ReaderGuard
+    {
+        std::thread &reader;
+        std::atomic<bool> &stopping;
+        InceptionV3CancelToken &token;
+
+        ~ReaderGuard()
+        {
+            if (reader.joinable()) {
+                stopping = true;
+                token.cancel();
+                reader.join();
+            }
+        }
+    } guard{reader, stopping, token};
+
+    while (auto item = co_await channel.receive()) {
+        if (item->error) {
+            std::rethrow_exception(item->error);
+        }
+        co_yield std::move(item->result);
+    }
+    reader.join();
+}
@@ -0,0 +1,372 @@
+#pragma once
+#include "inception_v3_classifier.hpp"
+#include <coroutine>
+#include <deque>
+#include <optional>
+
+// C++20 coroutine front-end over InceptionV3Classifier (built with -DINCEPTION_V3_COROUTINES=ON).
+//
+// Coroutines run on a single-threaded InceptionV3EventLoop. Awaiting a
+// classification submits the frame and suspends; the pipeline's postprocess
+// thread posts the coroutine back to the loop when the result is ready, so no
+// thread is parked per outstanding request.
+//
+//   InceptionV3Task<void> handle(InceptionV3CoroClassifier &classifier, InceptionV3Frame frame)
+//   {
+//       InceptionV3Result result = co_await classifier.classify(std::move(frame));
+//       ...
+//   }
+
+template <typename T>
+class InceptionV3Task;
+
+class InceptionV3EventLoop
+{
+public:
+    InceptionV3EventLoop();
+    ~InceptionV3EventLoop();
+
+    InceptionV3EventLoop(const InceptionV3EventLoop &) = delete;
+    InceptionV3EventLoop &operator=(const InceptionV3EventLoop &) = delete;
+
+    // Thread safe: queues the coroutine to be resumed on the loop thread.
+    void post(std::coroutine_handle<> handle);
+
+    // Starts a task that runs alongside the others; its exception, if any, is
+    // rethrown from run().
+    void spawn(InceptionV3Task<void> task);
+
+    // Runs the loop until task finishes and returns its result.
+    template <typename T>
+    T run(InceptionV3Task<T> task);
+
+    // For embedding in an existing reactor: fd becomes readable when coroutines
+    // are queued, run_ready() then resumes them (it blocks if called before that).
+    int fd() const { return m_event_fd; }
+    void run_ready();
+
+private:
+    struct Detached;
+    static Detached drive(InceptionV3EventLoop &loop, InceptionV3Task<void> task, bool *done);
+    void run_until(const bool &done);
+
+    int m_event_fd;
+    std::mutex m_mutex;
+    std::deque<std::coroutine_handle<>> m_ready;
+    std::exception_ptr m_error;
+};
+
+template <typename T>
+class InceptionV3Task
+{
+public:
+    struct promise_type;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    struct FinalAwaiter
+    {
+        bool await_ready() noexcept { return false; }
+        std::coroutine_handle<> await_suspend(Handle handle) noexcept
+        {
+            auto continuation = handle.promise().continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+
+    struct PromiseBase
+    {
+        std::coroutine_handle<> continuation;
+        std::exception_ptr error;
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        FinalAwaiter final_suspend() noexcept { return {}; }
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    struct promise_type : PromiseBase
+    {
+        std::optional<T> value;
+
+        InceptionV3Task get_return_object() { return InceptionV3Task(Handle::from_promise(*this)); }
+        void return_value(T result) { value = std::move(result); }
+    };
+
+    InceptionV3Task(InceptionV3Task &&other) noexcept : m_handle(other.m_handle) { other.m_handle = nullptr; }
+    InceptionV3Task &operator=(InceptionV3Task &&) = delete;
+    ~InceptionV3Task()
+    {
+        if (m_handle) {
+            m_handle.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept
+    {
+        m_handle.promise().continuation = continuation;
+        return m_handle;
+    }
+    T await_resume()
+    {
+        if (m_handle.promise().error) {
+            std::rethrow_exception(m_handle.promise().error);
+        }
+        return std::move(*m_handle.promise().value);
+    }
+
+private:
+    explicit InceptionV3Task(Handle handle) : m_handle(handle) {}
+
+    Handle m_handle;
+};
+
+template <>
+struct InceptionV3Task<void>::promise_type : InceptionV3Task<void>::PromiseBase
+{
+    InceptionV3Task get_return_object() { return InceptionV3Task(Handle::from_promise(*this)); }
+    void return_void() {}
+};
+
+template <>
+inline void InceptionV3Task<void>::await_resume()
+{
+    if (m_handle.promise().error) {
+        std::rethrow_exception(m_handle.promise().error);
+    }
+}
+
+// Coroutine that starts eagerly and frees itself when it finishes; only used by
+// the loop to own spawned tasks.
+struct InceptionV3EventLoop::Detached
+{
+    struct promise_type
+    {
+        Detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+template <typename T>
+T InceptionV3EventLoop::run(InceptionV3Task<T> task)
+{
+    std::optional<T> result;
+    auto wrapper = [](InceptionV3Task<T> inner, std::optional<T> &out) -> InceptionV3Task<void> {
+        out = co_await std::move(inner);
+    };
+    bool done = false;
+    drive(*this, wrapper(std::move(task), result), &done);
+    run_until(done);
+    return std::move(*result);
+}
+
+template <>
+inline void InceptionV3EventLoop::run(InceptionV3Task<void> task)
+{
+    bool done = false;
+    drive(*this, std::move(task), &done);
+    run_until(done);
+}
+
+// Async generator: the body may co_await and co_yield; consumers iterate with
+//   while (auto item = co_await generator.next()) { ... }
+template <typename T>
+class InceptionV3AsyncGenerator
+{
+public:
+    struct promise_type;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    // Suspends the generator and resumes whoever is waiting in next().
+    struct YieldAwaiter
+    {
+        bool await_ready() noexcept { return false; }
+        std::coroutine_handle<> await_suspend(Handle handle) noexcept { return handle.promise().consumer; }
+        void await_resume() noexcept {}
+    };
+
+    struct promise_type
+    {
+        std::optional<T> value;
+        std::exception_ptr error;
+        std::coroutine_handle<> consumer;
+
+        InceptionV3AsyncGenerator get_return_object() { return InceptionV3AsyncGenerator(Handle::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        YieldAwaiter final_suspend() noexcept { return {}; }
+        YieldAwaiter yield_value(T item)
+        {
+            value = std::move(item);
+            return {};
+        }
+        void return_void() {}
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    struct NextAwaiter
+    {
+        Handle handle;
+
+        bool await_ready() noexcept { return false; }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> consumer) noexcept
+        {
+            handle.promise().value.reset();
+            handle.promise().consumer = consumer;
+            return handle;
+        }
+        std::optional<T> await_resume()
+        {
+            if (handle.promise().error) {
+                std::rethrow_exception(handle.promise().error);
+            }
+            if (handle.done()) {
+                return std::nullopt;
+            }
+            return std::move(handle.promise().value);
+        }
+    };
+
+    InceptionV3AsyncGenerator(InceptionV3AsyncGenerator &&other) noexcept : m_handle(other.m_handle)
+    {
+        other.m_handle = nullptr;
+    }
+    InceptionV3AsyncGenerator &operator=(InceptionV3AsyncGenerator &&) = delete;
+    ~InceptionV3AsyncGenerator()
+    {
+        if (m_handle) {
+            m_handle.destroy();
+        }
+    }
+
+    // Empty optional at end of stream. Not valid again after that.
+    NextAwaiter next() { return NextAwaiter{m_handle}; }
+
+private:
+    explicit InceptionV3AsyncGenerator(Handle handle) : m_handle(handle) {}
+
+    Handle m_handle;
+};
+
+// Single-consumer queue between producer threads and a coroutine on the loop.
+template <typename T>
+class InceptionV3Channel
+{
+public:
+    explicit InceptionV3Channel(InceptionV3EventLoop &loop) : m_loop(loop), m_closed(false) {}
+
+    void send(T item)
+    {
+        std::coroutine_handle<> waiter;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_items.push_back(std::move(item));
+            std::swap(waiter, m_waiter);
+        }
+        if (waiter) {
+            m_loop.post(waiter);
+        }
+    }
+
+    void close()
+    {
+        std::coroutine_handle<> waiter;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+            std::swap(waiter, m_waiter);
+        }
+        if (waiter) {
+            m_loop.post(waiter);
+        }
+    }
+
+    struct ReceiveAwaiter
+    {
+        InceptionV3Channel &channel;
+
+        bool await_ready() { return false; }
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            std::lock_guard<std::mutex> lock(channel.m_mutex);
+            if (!channel.m_items.empty() || channel.m_closed) {
+                return false;
+            }
+            channel.m_waiter = handle;
+            return true;
+        }
+        std::optional<T> await_resume()
+        {
+            std::lock_guard<std::mutex> lock(channel.m_mutex);
+            if (channel.m_items.empty()) {
+                return std::nullopt;
+            }
+            T item = std::move(channel.m_items.front());
+            channel.m_items.pop_front();
+            return item;
+        }
+    };
+
+    // Empty optional once the channel is closed and drained.
+    ReceiveAwaiter receive() { return ReceiveAwaiter{*this}; }
+
+private:
+    InceptionV3EventLoop &m_loop;
+    std::mutex m_mutex;
+    std::deque<T> m_items;
+    std::coroutine_handle<> m_waiter;
+    bool m_closed;
+};
+
+class InceptionV3CoroClassifier
+{
+public:
+    InceptionV3CoroClassifier(InceptionV3Classifier &classifier, InceptionV3EventLoop &loop)
+        : m_classifier(classifier), m_loop(loop) {}
+
+    struct ClassifyAwaiter
+    {
+        InceptionV3CoroClassifier &owner;
+        InceptionV3Frame frame;
+        InceptionV3CancelToken token;
+        InceptionV3Result result;
+        std::exception_ptr error;
+
+        bool await_ready() const noexcept { return false; }
+        // Blocks the loop thread while the classifier is at max_in_flight.
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            owner.m_classifier.submit(std::move(frame),
+                                      [this, handle](const InceptionV3Result &value, std::exception_ptr failure) {
+                                          result = value;
+                                          error = failure;
+                                          owner.m_loop.post(handle);
+                                      },
+                                      token);
+        }
+        InceptionV3Result await_resume()
+        {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            return std::move(result);
+        }
+    };
+
+    ClassifyAwaiter classify(InceptionV3Frame frame, InceptionV3CancelToken token = InceptionV3CancelToken())
+    {
+        return ClassifyAwaiter{*this, std::move(frame), std::move(token), InceptionV3Result(), nullptr};
+    }
+
+    // Yields the classification of every frame of source in completion order (frames
+    // are preprocessed in parallel, use seq to restore capture order). Frames are read
+    // and submitted by a helper thread (source.next() blocks), bounded by the
+    // classifier's max_in_flight; dropping the generator early stops the reads.
+    InceptionV3AsyncGenerator<InceptionV3PipelineResult> classify_stream(InceptionV3FrameSource &source);
+
+private:
+    InceptionV3Classifier &m_classifier;
+    InceptionV3EventLoop &m_loop;
+};
@@ -0,0 +1,66 @@
+#include "inception_v3_coro.hpp"
+#include "inception_v3_test.hpp"
+#include <unistd.h>
+
+// classify_stream() over the simulated backend. A classifier that refuses a
+// frame must hand the error to the consumer and still shut the stream down; a
+// hang there is caught by the alarm below.
+
+namespace
+{
+InceptionV3Task<size_t> count_results(InceptionV3CoroClassifier &classifier, InceptionV3FrameSource &source)
+{
+    size_t results = 0;
+    auto stream = classifier.classify_stream(source);
+    while (auto result = co_await stream.next()) {
+        results++;
+    }
+    co_return results;
+}
+
+InceptionV3Task<bool> stops_overloaded(InceptionV3CoroClassifier &classifier, InceptionV3FrameSource &source)
+{
+    auto stream = classifier.classify_stream(source);
+    try {
+        while (auto result = co_await stream.next()) {
+        }
+    } catch (const InceptionV3Overloaded &) {
+        co_return true;
+    }
+    co_return false;
+}
+} // namespace
+
+int main()
+{
+    alarm(60);
+
+    InceptionV3Params params("", 0.5f);
+    params.labels.resize(1000);
+    InceptionV3Runner runner(std::unique_ptr<InceptionV3Backend>(new InceptionV3SimulatedBackend(
+                                 std::chrono::microseconds(20000), std::chrono::microseconds(0))),
+                             &params);
+    InceptionV3EventLoop loop;
+
+    {
+        InceptionV3ClassifierConfig config;
+        config.max_in_flight = 4;
+        InceptionV3Classifier classifier(runner, config);
+        InceptionV3CoroClassifier coro(classifier, loop);
+        InceptionV3SyntheticSource source(0, 64, 48, INCEPTION_V3_FORMAT_RGB, 0.0, 20);
+        inception_v3_check(loop.run(count_results(coro, source)) == 20, "classify_stream", "every frame", 0);
+    }
+
+    {
+        // One slot and no waiting: the second frame is refused while the first is on the device.
+        InceptionV3ClassifierConfig config;
+        config.max_in_flight = 1;
+        config.block_when_full = false;
+        InceptionV3Classifier classifier(runner, config);
+        InceptionV3CoroClassifier coro(classifier, loop);
+        InceptionV3SyntheticSource source(0, 64, 48, INCEPTION_V3_FORMAT_RGB, 0.0, 20);
+        inception_v3_check(loop.run(stops_overloaded(coro, source)), "classify_stream", "full classifier", 0);
+    }
+
+    return inception_v3_test_result();
+}
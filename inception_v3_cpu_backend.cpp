@@ -0,0 +1,747 @@
+#include "inception_v3_cpu_backend.hpp"
+#include "inception_v3_kernels.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+// Output pixels and channels per work item. A tile's weights (64 channels of up
+// to 3x3x448 bytes) and activation rows stay in L2 while it runs.
+const size_t PIXEL_TILE = 16;
+const size_t CHANNEL_TILE = 64;
+
+// Rows of output pixels per pooling / im2col work item.
+const size_t ROW_TILE = 4;
+
+const uint32_t FEATURES = 2048;
+
+// kernel_h, kernel_w, in_channels, out_channels of every layer in file order,
+// following the graph walk in run_frame().
+std::vector<std::array<uint32_t, 4>> expected_layers(uint32_t classes)
+{
+    std::vector<std::array<uint32_t, 4>> layers = {
+        {3, 3, 3, 32}, {3, 3, 32, 32}, {3, 3, 32, 64}, {1, 1, 64, 80}, {3, 3, 80, 192}};
+
+    uint32_t channels = 192;
+    for (uint32_t pool_features : {32u, 64u, 64u}) {
+        layers.insert(layers.end(), {{1, 1, channels, 64}, {1, 1, channels, 48}, {5, 5, 48, 64},
+                                     {1, 1, channels, 64}, {3, 3, 64, 96}, {3, 3, 96, 96},
+                                     {1, 1, channels, pool_features}});
+        channels = 224 + pool_features;
+    }
+
+    layers.insert(layers.end(), {{3, 3, channels, 384}, {1, 1, channels, 64}, {3, 3, 64, 96}, {3, 3, 96, 96}});
+    channels = 768;
+
+    for (uint32_t c : {128u, 160u, 160u, 192u}) {
+        layers.insert(layers.end(), {{1, 1, channels, 192}, {1, 1, channels, c}, {1, 7, c, c}, {7, 1, c, 192},
+                                     {1, 1, channels, c}, {7, 1, c, c}, {1, 7, c, c}, {7, 1, c, c}, {1, 7, c, 192},
+                                     {1, 1, channels, 192}});
+    }
+
+    layers.insert(layers.end(), {{1, 1, channels, 192}, {3, 3, 192, 320}, {1, 1, channels, 192}, {1, 7, 192, 192},
+                                 {7, 1, 192, 192}, {3, 3, 192, 192}});
+    channels = 1280;
+
+    for (int block = 0; block < 2; block++) {
+        layers.insert(layers.end(), {{1, 1, channels, 320}, {1, 1, channels, 384}, {1, 3, 384, 384},
+                                     {3, 1, 384, 384}, {1, 1, channels, 448}, {3, 3, 448, 384}, {1, 3, 384, 384},
+                                     {3, 1, 384, 384}, {1, 1, channels, 192}});
+        channels = FEATURES;
+    }
+
+    layers.push_back({1, 1, FEATURES, classes});
+    return layers;
+}
+
+template <typename T>
+void read_values(std::ifstream &file, T *values, size_t count, const std::string &path)
+{
+    if (!file.read(reinterpret_cast<char *>(values), static_cast<std::streamsize>(count * sizeof(T)))) {
+        throw std::runtime_error(path + " is truncated");
+    }
+}
+
+// Output size and leading padding of one spatial axis, TensorFlow "same" / "valid" rules.
+void output_extent(uint32_t input, uint32_t kernel, uint32_t stride, bool same, uint32_t &output, uint32_t &padding)
+{
+    if (same) {
+        output = (input + stride - 1) / stride;
+        const int64_t total = static_cast<int64_t>(output - 1) * stride + kernel - input;
+        padding = total > 0 ? static_cast<uint32_t>(total / 2) : 0;
+    } else {
+        output = (input - kernel) / stride + 1;
+        padding = 0;
+    }
+}
+} // namespace
+
+struct InceptionV3CpuBackend::Layer
+{
+    uint32_t kernel_h = 0;
+    uint32_t kernel_w = 0;
+    uint32_t in_channels = 0;
+    uint32_t out_channels = 0;
+    uint32_t stride = 1;            // small models only; Inception-v3's come from run_frame()
+    bool same = false;
+    size_t depth = 0;               // kernel_h * kernel_w * in_channels, the length of a weight row
+    std::vector<float> scale;
+    std::vector<float> bias;
+    std::vector<int16_t> weights;   // out_channels rows of depth, int8 values
+};
+
+// Fixed set of threads that split one layer at a time with the calling thread.
+// run() hands out item indices from a shared counter until they run out and
+// returns once every thread is done with the layer.
+class InceptionV3CpuBackend::Workers
+{
+public:
+    explicit Workers(size_t threads) : m_generation(0), m_finished(0), m_stopping(false)
+    {
+        for (size_t i = 1; i < threads; i++) {
+            m_threads.emplace_back(&Workers::loop, this);
+        }
+    }
+
+    ~Workers()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_start.notify_all();
+        for (auto &thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    size_t size() const { return m_threads.size() + 1; }
+
+    template <typename Task>
+    void run(size_t count, const Task &task)
+    {
+        dispatch(count, [](const void *context, size_t index) { (*static_cast<const Task *>(context))(index); },
+                 &task);
+    }
+
+private:
+    using Call = void (*)(const void *, size_t);
+
+    void dispatch(size_t count, Call call, const void *context)
+    {
+        if (m_threads.empty() || count == 1) {
+            for (size_t i = 0; i < count; i++) {
+                call(context, i);
+            }
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_call = call;
+            m_context = context;
+            m_count = count;
+            m_next = 0;
+            m_finished = 0;
+            m_generation++;
+        }
+        m_start.notify_all();
+        work();
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this]() { return m_finished == m_threads.size(); });
+    }
+
+    void work()
+    {
+        for (size_t i = m_next.fetch_add(1, std::memory_order_relaxed); i < m_count;
+             i = m_next.fetch_add(1, std::memory_order_relaxed)) {
+            m_call(m_context, i);
+        }
+    }
+
+    void loop()
+    {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_start.wait(lock, [&]() { return m_stopping || m_generation != seen; });
+            if (m_stopping) {
+                return;
+            }
+            seen = m_generation;
+            lock.unlock();
+            work();
+            lock.lock();
+            if (++m_finished == m_threads.size()) {
+                m_done.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    uint64_t m_generation;
+    size_t m_finished;
+    bool m_stopping;
+
+    Call m_call = nullptr;
+    const void *m_context = nullptr;
+    size_t m_count = 0;
+    std::atomic<size_t> m_next{0};
+};
+
+void InceptionV3CpuBackend::Tensor::reshape(uint32_t new_height, uint32_t new_width, uint32_t new_channels)
+{
+    height = new_height;
+    width = new_width;
+    channels = new_channels;
+    data.resize(static_cast<size_t>(height) * width * channels);
+}
+
+InceptionV3CpuBackend::InceptionV3CpuBackend(const std::string &weights_path, size_t threads,
+                                             const hailo_vstream_info_t &output_info)
+    : m_input_info(inception_v3_input_info()), m_output_info(output_info), m_classes(0), m_small(false),
+      m_next_layer(0)
+{
+    load(weights_path);
+    if (m_output_info.shape.features != m_classes) {
+        throw std::invalid_argument(weights_path + " has " + std::to_string(m_classes) + " classes, output expects " +
+                                    std::to_string(m_output_info.shape.features));
+    }
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    m_workers.reset(new Workers(threads));
+}
+
+InceptionV3CpuBackend::~InceptionV3CpuBackend() = default;
+
+size_t InceptionV3CpuBackend::input_frame_size() const
+{
+    return static_cast<size_t>(m_input_info.shape.height) * m_input_info.shape.width * m_input_info.shape.features;
+}
+
+size_t InceptionV3CpuBackend::output_frame_size() const
+{
+    return m_output_info.shape.features;
+}
+
+size_t InceptionV3CpuBackend::threads() const
+{
+    return m_workers->size();
+}
+
+void InceptionV3CpuBackend::load(const std::string &weights_path)
+{
+    std::ifstream file(weights_path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("cannot open " + weights_path);
+    }
+
+    uint32_t header[4];
+    read_values(file, header, 4, weights_path);
+    if (header[0] != INCEPTION_V3_WEIGHTS_MAGIC ||
+        (header[1] != INCEPTION_V3_WEIGHTS_VERSION && header[1] != INCEPTION_V3_SMALL_WEIGHTS_VERSION)) {
+        throw std::runtime_error(weights_path + " is not an inception_v3 weights file");
+    }
+    m_classes = header[3];
+    if (header[1] == INCEPTION_V3_SMALL_WEIGHTS_VERSION) {
+        load_small(file, weights_path, header[2]);
+    } else {
+        const auto expected = expected_layers(m_classes);
+        if (header[2] != expected.size()) {
+            throw std::runtime_error(weights_path + " has " + std::to_string(header[2]) +
+                                     " layers, Inception-v3 has " + std::to_string(expected.size()));
+        }
+
+        for (size_t i = 0; i < expected.size(); i++) {
+            uint32_t shape[4];
+            read_values(file, shape, 4, weights_path);
+            if (!std::equal(shape, shape + 4, expected[i].begin())) {
+                throw std::runtime_error(weights_path + ": layer " + std::to_string(i) + " is " +
+                                         std::to_string(shape[0]) + "x" + std::to_string(shape[1]) + "x" +
+                                         std::to_string(shape[2]) + "->" + std::to_string(shape[3]) + ", expected " +
+                                         std::to_string(expected[i][0]) + "x" + std::to_string(expected[i][1]) + "x" +
+                                         std::to_string(expected[i][2]) + "->" + std::to_string(expected[i][3]));
+            }
+            m_layers.push_back(read_layer(file, weights_path, shape));
+        }
+    }
+
+    // The network wants pixels as x / 127.5 - 1. The first layer takes the raw
+    // bytes with a scale of 1 / 127.5 instead, and the -1 moves into its bias:
+    // sum(w * (x / 127.5 - 1)) = sum(w * x) / 127.5 - sum(w). Its padding is
+    // "valid", so every tap sees a real pixel and the correction is exact.
+    Layer &first = *m_layers.front();
+    for (uint32_t c = 0; c < first.out_channels; c++) {
+        int32_t sum = 0;
+        for (size_t k = 0; k < first.depth; k++) {
+            sum += first.weights[c * first.depth + k];
+        }
+        first.bias[c] -= first.scale[c] * static_cast<float>(sum);
+    }
+}
+
+// Reads a version 2 chain and checks that its shapes connect, from the input
+// tensor down to a 1x1 classifier over `classes`.
+void InceptionV3CpuBackend::load_small(std::ifstream &file, const std::string &weights_path, uint32_t layer_count)
+{
+    uint32_t input_size;
+    read_values(file, &input_size, 1, weights_path);
+    if (layer_count < 2 || input_size == 0 || input_size > 1024) {
+        throw std::runtime_error(weights_path + " is not a usable small model (" + std::to_string(layer_count) +
+                                 " layers, input " + std::to_string(input_size) + ")");
+    }
+    m_small = true;
+    m_input_info = inception_v3_input_info(input_size, input_size);
+
+    uint32_t height = input_size;
+    uint32_t width = input_size;
+    uint32_t channels = m_input_info.shape.features;
+    for (uint32_t i = 0; i < layer_count; i++) {
+        uint32_t shape[6];
+        read_values(file, shape, 6, weights_path);
+        const bool last = i + 1 == layer_count;
+        const uint32_t stride = shape[4];
+        const bool same = shape[5] != 0;
+        const std::string name = weights_path + ": layer " + std::to_string(i);
+        if (shape[0] == 0 || shape[1] == 0 || shape[3] == 0 || stride == 0 || stride > 8 || shape[2] != channels) {
+            throw std::runtime_error(name + " does not follow the previous layer");
+        }
+        if (i == 0 && same) {
+            throw std::runtime_error(name + " must use \"valid\" padding, the input normalization is folded into it");
+        }
+        if (last && (shape[0] != 1 || shape[1] != 1 || stride != 1 || shape[3] != m_classes)) {
+            throw std::runtime_error(name + " is not a 1x1 classifier over " + std::to_string(m_classes) +
+                                     " classes");
+        }
+        if (!last && !same && (shape[0] > height || shape[1] > width)) {
+            throw std::runtime_error(name + " is larger than its " + std::to_string(height) + "x" +
+                                     std::to_string(width) + " input");
+        }
+
+        std::unique_ptr<Layer> layer = read_layer(file, weights_path, shape);
+        layer->stride = stride;
+        layer->same = same;
+        m_layers.push_back(std::move(layer));
+        if (!last) {
+            uint32_t padding;
+            output_extent(height, shape[0], stride, same, height, padding);
+            output_extent(width, shape[1], stride, same, width, padding);
+            channels = shape[3];
+        }
+    }
+}
+
+std::unique_ptr<InceptionV3CpuBackend::Layer> InceptionV3CpuBackend::read_layer(std::ifstream &file,
+                                                                               const std::string &weights_path,
+                                                                               const uint32_t shape[4])
+{
+    std::unique_ptr<Layer> layer(new Layer());
+    layer->kernel_h = shape[0];
+    layer->kernel_w = shape[1];
+    layer->in_channels = shape[2];
+    layer->out_channels = shape[3];
+    layer->depth = static_cast<size_t>(shape[0]) * shape[1] * shape[2];
+    layer->scale.resize(layer->out_channels);
+    layer->bias.resize(layer->out_channels);
+    read_values(file, layer->scale.data(), layer->scale.size(), weights_path);
+    read_values(file, layer->bias.data(), layer->bias.size(), weights_path);
+    std::vector<int8_t> weights(layer->out_channels * layer->depth);
+    read_values(file, weights.data(), weights.size(), weights_path);
+    layer->weights.assign(weights.begin(), weights.end());
+    return layer;
+}
+
+void InceptionV3CpuBackend::infer(const std::vector<uint8_t *> &inputs, const std::vector<uint8_t *> &outputs)
+{
+    std::lock_guard<std::mutex> lock(m_infer_mutex);
+    for (size_t i = 0; i < inputs.size(); i++) {
+        run_frame(inputs[i], outputs[i]);
+    }
+}
+
+void InceptionV3CpuBackend::quantize(const Tensor &input, QuantizedTensor &output)
+{
+    output.height = input.height;
+    output.width = input.width;
+    output.channels = input.channels;
+    output.data.resize(input.data.size());
+
+    // Activations are post-ReLU, so the range is [0, max].
+    const float *values = input.data.data();
+    const size_t count = input.data.size();
+    float maximum = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        maximum = std::max(maximum, values[i]);
+    }
+    output.scale = maximum > 0.0f ? maximum / 255.0f : 1.0f;
+    const float inverse = 1.0f / output.scale;
+
+    const size_t chunk = 16384;
+    int16_t *quantized = output.data.data();
+    m_workers->run((count + chunk - 1) / chunk, [&](size_t index) {
+        const size_t end = std::min(count, (index + 1) * chunk);
+        for (size_t i = index * chunk; i < end; i++) {
+            quantized[i] = static_cast<int16_t>(std::min(values[i] * inverse + 0.5f, 255.0f));
+        }
+    });
+}
+
+void InceptionV3CpuBackend::conv(const QuantizedTensor &input, uint32_t stride, bool same, Tensor &output)
+{
+    const Layer &layer = *m_layers[m_next_layer];
+    uint32_t height, width, padding;
+    output_extent(input.height, layer.kernel_h, stride, same, height, padding);
+    output_extent(input.width, layer.kernel_w, stride, same, width, padding);
+    output.reshape(height, width, layer.out_channels);
+    conv(input, stride, same, output, 0);
+}
+
+void InceptionV3CpuBackend::conv(const QuantizedTensor &input, uint32_t stride, bool same, Tensor &output,
+                                 uint32_t channel_offset, bool relu)
+{
+    const Layer &layer = *m_layers[m_next_layer++];
+    uint32_t height, width, pad_top, pad_left;
+    output_extent(input.height, layer.kernel_h, stride, same, height, pad_top);
+    output_extent(input.width, layer.kernel_w, stride, same, width, pad_left);
+    if (input.channels != layer.in_channels || output.height != height || output.width != width ||
+        channel_offset + layer.out_channels > output.channels) {
+        throw std::logic_error("inception_v3 CPU graph does not match layer " + std::to_string(m_next_layer - 1));
+    }
+
+    const size_t depth = layer.depth;
+    const size_t pixels = static_cast<size_t>(height) * width;
+    const int16_t *rows = input.data.data();
+
+    // 1x1 stride-1 layers read the input rows directly; everything else gathers
+    // each output pixel's receptive field into one row first (zeros for padding).
+    if (layer.kernel_h != 1 || layer.kernel_w != 1 || stride != 1) {
+        m_columns.resize(pixels * depth);
+        int16_t *columns = m_columns.data();
+        const size_t tap = input.channels;
+        m_workers->run((height + ROW_TILE - 1) / ROW_TILE, [&](size_t index) {
+            const uint32_t y_end = std::min<uint32_t>(height, static_cast<uint32_t>((index + 1) * ROW_TILE));
+            for (uint32_t y = static_cast<uint32_t>(index * ROW_TILE); y < y_end; y++) {
+                for (uint32_t x = 0; x < width; x++) {
+                    int16_t *column = columns + (static_cast<size_t>(y) * width + x) * depth;
+                    for (uint32_t ky = 0; ky < layer.kernel_h; ky++) {
+                        const int64_t iy = static_cast<int64_t>(y) * stride + ky - pad_top;
+                        for (uint32_t kx = 0; kx < layer.kernel_w; kx++, column += tap) {
+                            const int64_t ix = static_cast<int64_t>(x) * stride + kx - pad_left;
+                            if (iy < 0 || iy >= input.height || ix < 0 || ix >= input.width) {
+                                std::memset(column, 0, tap * sizeof(int16_t));
+                            } else {
+                                std::memcpy(column, input.data.data() + (static_cast<size_t>(iy) * input.width + ix) * tap,
+                                            tap * sizeof(int16_t));
+                            }
+                        }
+                    }
+                }
+            }
+        });
+        rows = columns;
+    }
+
+    const size_t pixel_tiles = (pixels + PIXEL_TILE - 1) / PIXEL_TILE;
+    const size_t channel_tiles = (layer.out_channels + CHANNEL_TILE - 1) / CHANNEL_TILE;
+    const float input_scale = input.scale;
+    const size_t output_stride = output.channels;
+    float *destination = output.data.data() + channel_offset;
+    // The int16 dot products are the engine's hot loop; see inception_v3_kernels.hpp.
+    const auto dot_1x4 = inception_v3_kernels().dot_i16_1x4;
+    const auto dot_1x1 = inception_v3_kernels().dot_i16;
+
+    m_workers->run(pixel_tiles * channel_tiles, [&](size_t index) {
+        const size_t pixel_begin = (index / channel_tiles) * PIXEL_TILE;
+        const size_t pixel_end = std::min(pixels, pixel_begin + PIXEL_TILE);
+        const size_t channel_begin = (index % channel_tiles) * CHANNEL_TILE;
+        const size_t channel_end = std::min<size_t>(layer.out_channels, channel_begin + CHANNEL_TILE);
+        const float floor = relu ? 0.0f : -INFINITY;
+
+        for (size_t p = pixel_begin; p < pixel_end; p++) {
+            const int16_t *row = rows + p * depth;
+            float *out = destination + p * output_stride;
+            size_t c = channel_begin;
+            int32_t sums[4];
+            for (; c + 4 <= channel_end; c += 4) {
+                dot_1x4(row, layer.weights.data() + c * depth, depth, depth, sums);
+                for (size_t j = 0; j < 4; j++) {
+                    out[c + j] = std::max(floor, sums[j] * (input_scale * layer.scale[c + j]) + layer.bias[c + j]);
+                }
+            }
+            for (; c < channel_end; c++) {
+                const int32_t sum = dot_1x1(row, layer.weights.data() + c * depth, depth);
+                out[c] = std::max(floor, sum * (input_scale * layer.scale[c]) + layer.bias[c]);
+            }
+        }
+    });
+}
+
+// 3x3 stride-2 "valid" max pooling into channels [channel_offset, channel_offset + input.channels) of output.
+void InceptionV3CpuBackend::max_pool(const Tensor &input, Tensor &output, uint32_t channel_offset)
+{
+    const uint32_t height = (input.height - 3) / 2 + 1;
+    const uint32_t width = (input.width - 3) / 2 + 1;
+    if (output.height != height || output.width != width || channel_offset + input.channels > output.channels) {
+        throw std::logic_error("inception_v3 CPU graph: max pool does not fit its output");
+    }
+
+    const size_t channels = input.channels;
+    m_workers->run((height + ROW_TILE - 1) / ROW_TILE, [&](size_t index) {
+        const uint32_t y_end = std::min<uint32_t>(height, static_cast<uint32_t>((index + 1) * ROW_TILE));
+        for (uint32_t y = static_cast<uint32_t>(index * ROW_TILE); y < y_end; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                float *out = output.data.data() + (static_cast<size_t>(y) * width + x) * output.channels + channel_offset;
+                const float *first = input.data.data() + (static_cast<size_t>(2 * y) * input.width + 2 * x) * channels;
+                std::memcpy(out, first, channels * sizeof(float));
+                for (uint32_t ky = 0; ky < 3; ky++) {
+                    for (uint32_t kx = 0; kx < 3; kx++) {
+                        const float *in = first + (static_cast<size_t>(ky) * input.width + kx) * channels;
+                        for (size_t c = 0; c < channels; c++) {
+                            out[c] = std::max(out[c], in[c]);
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+// 3x3 stride-1 "same" average pooling; padded taps are left out of the average.
+void InceptionV3CpuBackend::avg_pool(const Tensor &input, Tensor &output)
+{
+    output.reshape(input.height, input.width, input.channels);
+    const size_t channels = input.channels;
+    const int64_t height = input.height;
+    const int64_t width = input.width;
+    m_workers->run((input.height + ROW_TILE - 1) / ROW_TILE, [&](size_t index) {
+        const int64_t y_end = std::min<int64_t>(height, static_cast<int64_t>((index + 1) * ROW_TILE));
+        for (int64_t y = static_cast<int64_t>(index * ROW_TILE); y < y_end; y++) {
+            for (int64_t x = 0; x < width; x++) {
+                float *out = output.data.data() + (y * width + x) * channels;
+                std::fill(out, out + channels, 0.0f);
+                int taps = 0;
+                for (int64_t iy = std::max<int64_t>(y - 1, 0); iy <= std::min(y + 1, height - 1); iy++) {
+                    for (int64_t ix = std::max<int64_t>(x - 1, 0); ix <= std::min(x + 1, width - 1); ix++, taps++) {
+                        const float *in = input.data.data() + (iy * width + ix) * channels;
+                        for (size_t c = 0; c < channels; c++) {
+                            out[c] += in[c];
+                        }
+                    }
+                }
+                const float inverse = 1.0f / taps;
+                for (size_t c = 0; c < channels; c++) {
+                    out[c] *= inverse;
+                }
+            }
+        }
+    });
+}
+
+void InceptionV3CpuBackend::mixed_35(const Tensor &input, Tensor &output, uint32_t pool_features)
+{
+    quantize(input, m_block_quantized);
+    output.reshape(input.height, input.width, 224 + pool_features);
+
+    conv(m_block_quantized, 1, true, output, 0);            // 1x1, 64
+
+    conv(m_block_quantized, 1, true, m_branches[0]);        // 1x1, 48
+    quantize(m_branches[0], m_branch_quantized);
+    conv(m_branch_quantized, 1, true, output, 64);          // 5x5, 64
+
+    conv(m_block_quantized, 1, true, m_branches[0]);        // 1x1, 64
+    quantize(m_branches[0], m_branch_quantized);
+    conv(m_branch_quantized, 1, true, m_branches[1]);       // 3x3, 96
+    quantize(m_branches[1], m_branch_quantized);
+    conv(m_branch_quantized, 1, true, output, 128);         // 3x3, 96
+
+    avg_pool(input, m_pooled);
+    quantize(m_pooled, m_branch_quantized);
+    conv(m_branch_quantized, 1, true, output, 224);         // 1x1, pool_features
+}
+
+void InceptionV3CpuBackend::reduce_35(const Tensor &input, Tensor &output)
+{
+    quantize(input, m_block_quantized);
+    output.reshape((input.height - 3) / 2 + 1, (input.width - 3) / 2 + 1, 480 + input.channels);
+
+    conv(m_block_quantized, 2, false, output, 0);           // 3x3 /2, 384
+
+    conv(m_block_quantized, 1, true, m_branches[0]);        // 1x1, 64
+    quantize(m_branches[0], m_branch_quantized);
+    conv(m_branch_quantized, 1, true, m_branches[1]);       // 3x3, 96
+    quantize(m_branches[1], m_branch_quantized);
+    conv(m_branch_quantized, 2, false, output, 384);        // 3x3 /2, 96
+
+    max_pool(input, output, 480);
+}
+
+void InceptionV3CpuBackend::mixed_17(const Tensor &input, Tensor &output)
+{
+    quantize(input, m_block_quantized);
+    output.reshape(input.height, input.width, 768);
+
+    conv(m_block_quantized, 1, true, output, 0);            // 1x1, 192
+
+    conv(m_block_quantized, 1, true, m_branches[0]);        // 1x1, c
+    quantize(m_branches[0], m_branch_quantized);
+    conv(m_branch_quantized, 1, true, m_branches[1]);       // 1x7, c
+    quantize(m_branches[1], m_branch_quantized);
+    conv(m_branch_quantized, 1, true, output, 192);         // 7x1, 192
+
+    conv(m_block_quantized, 1, true, m_branches[0]);        // 1x1, c
+    for (int i = 0; i < 3; i++) {                           // 7x1, 1x7, 7x1, c
+        quantize(m_branches[i % 2], m_branch_quantized);
+        conv(m_branch_quantized, 1, true, m_branches[(i + 1) % 2]);
+    }
+    quantize(m_branches[1], m_branch_quantized);
+    conv(m_branch_quantized, 1, true, output, 384);         // 1x7, 192
+
+    avg_pool(input, m_pooled);
+    quantize(m_pooled, m_branch_quantized);
+    conv(m_branch_quantized, 1, true, output, 576);         // 1x1, 192
+}
+
+void InceptionV3CpuBackend::reduce_17(const Tensor &input, Tensor &output)
+{
+    quantize(input, m_block_quantized);
+    output.reshape((input.height - 3) / 2 + 1, (input.width - 3) / 2 + 1, 512 + input.channels);
+
+    conv(m_block_quantized, 1, true, m_branches[0]);        // 1x1, 192
+    quantize(m_branches[0], m_branch_quantized);
+    conv(m_branch_quantized, 2, false, output, 0);          // 3x3 /2, 320
+
+    conv(m_block_quantized, 1, true, m_branches[0]);        // 1x1, 192
+    quantize(m_branches[0], m_branch_quantized);
+    conv(m_branch_quantized, 1, true, m_branches[1]);       // 1x7, 192
+    quantize(m_branches[1], m_branch_quantized);
+    conv(m_branch_quantized, 1, true, m_branches[0]);       // 7x1, 192
+    quantize(m_branches[0], m_branch_quantized);
+    conv(m_branch_quantized, 2, false, output, 320);        // 3x3 /2, 192
+
+    max_pool(input, output, 512);
+}
+
+void InceptionV3CpuBackend::mixed_8(const Tensor &input, Tensor &output)
+{
+    quantize(input, m_block_quantized);
+    output.reshape(input.height, input.width, FEATURES);
+
+    conv(m_block_quantized, 1, true, output, 0);            // 1x1, 320
+
+    conv(m_block_quantized, 1, true, m_branches[0]);        // 1x1, 384
+    quantize(m_branches[0], m_branch_quantized);
+    conv(m_branch_quantized, 1, true, output, 320);         // 1x3, 384
+    conv(m_branch_quantized, 1, true, output, 704);         // 3x1, 384
+
+    conv(m_block_quantized, 1, true, m_branches[0]);        // 1x1, 448
+    quantize(m_branches[0], m_branch_quantized);
+    conv(m_branch_quantized, 1, true, m_branches[1]);       // 3x3, 384
+    quantize(m_branches[1], m_branch_quantized);
+    conv(m_branch_quantized, 1, true, output, 1088);        // 1x3, 384
+    conv(m_branch_quantized, 1, true, output, 1472);        // 3x1, 384
+
+    avg_pool(input, m_pooled);
+    quantize(m_pooled, m_branch_quantized);
+    conv(m_branch_quantized, 1, true, output, 1856);        // 1x1, 192
+}
+
+void InceptionV3CpuBackend::run_frame(const uint8_t *input, uint8_t *output)
+{
+    m_next_layer = 0;
+    m_input.height = m_input_info.shape.height;
+    m_input.width = m_input_info.shape.width;
+    m_input.channels = m_input_info.shape.features;
+    m_input.scale = 1.0f / 127.5f;
+    m_input.data.assign(input, input + input_frame_size());
+    if (m_small) {
+        classify(run_small(), output);
+        return;
+    }
+
+    // Stem: 299 -> 149 -> 147 -> 147 -> 73 -> 73 -> 71 -> 35.
+    Tensor &a = m_blocks[0];
+    Tensor &b = m_blocks[1];
+    conv(m_input, 2, false, a);                             // 3x3 /2, 32
+    quantize(a, m_block_quantized);
+    conv(m_block_quantized, 1, false, b);                   // 3x3, 32
+    quantize(b, m_block_quantized);
+    conv(m_block_quantized, 1, true, a);                    // 3x3, 64
+    b.reshape((a.height - 3) / 2 + 1, (a.width - 3) / 2 + 1, a.channels);
+    max_pool(a, b, 0);
+    quantize(b, m_block_quantized);
+    conv(m_block_quantized, 1, false, a);                   // 1x1, 80
+    quantize(a, m_block_quantized);
+    conv(m_block_quantized, 1, false, b);                   // 3x3, 192
+    a.reshape((b.height - 3) / 2 + 1, (b.width - 3) / 2 + 1, b.channels);
+    max_pool(b, a, 0);
+
+    // 35x35x192 -> 35x35x288 -> 17x17x768 -> 8x8x1280 -> 8x8x2048; the 17x17
+    // blocks narrow to c = 128, 160, 160, 192 inside their 7x7 branches.
+    mixed_35(a, b, 32);
+    mixed_35(b, a, 64);
+    mixed_35(a, b, 64);
+    reduce_35(b, a);
+    mixed_17(a, b);
+    mixed_17(b, a);
+    mixed_17(a, b);
+    mixed_17(b, a);
+    reduce_17(a, b);
+    mixed_8(b, a);
+    mixed_8(a, b);
+    classify(b, output);
+}
+
+// A small model's convolutions up to the classifier; returns their output.
+const InceptionV3CpuBackend::Tensor &InceptionV3CpuBackend::run_small()
+{
+    const QuantizedTensor *input = &m_input;
+    for (size_t i = 0;; i++) {
+        const Layer &layer = *m_layers[i];
+        Tensor &output = m_blocks[i % 2];
+        conv(*input, layer.stride, layer.same, output);
+        if (i + 2 == m_layers.size()) {
+            return output;
+        }
+        quantize(output, m_block_quantized);
+        input = &m_block_quantized;
+    }
+}
+
+// Global average pool, the classifier (the last layer) and the output quantization.
+void InceptionV3CpuBackend::classify(const Tensor &features, uint8_t *output)
+{
+    m_pooled.reshape(1, 1, features.channels);
+    const size_t positions = static_cast<size_t>(features.height) * features.width;
+    for (size_t c = 0; c < features.channels; c++) {
+        float sum = 0.0f;
+        for (size_t p = 0; p < positions; p++) {
+            sum += features.data[p * features.channels + c];
+        }
+        m_pooled.data[c] = sum / positions;
+    }
+    quantize(m_pooled, m_block_quantized);
+    m_branches[0].reshape(1, 1, m_classes);
+    conv(m_block_quantized, 1, false, m_branches[0], 0, false);
+
+    // Softmax, then quantized like the device's output vstream.
+    float *scores = m_branches[0].data.data();
+    inception_v3_kernels().softmax_f32(scores, m_classes);
+    const float scale = m_output_info.quant_info.qp_scale > 0.0f ? m_output_info.quant_info.qp_scale : 1.0f / 255.0f;
+    const float zero_point = m_output_info.quant_info.qp_zp;
+    for (uint32_t c = 0; c < m_classes; c++) {
+        const float quantized = std::round(scores[c] / scale + zero_point);
+        output[c] = static_cast<uint8_t>(std::min(std::max(quantized, 0.0f), 255.0f));
+    }
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include "inception_v3_backend.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+static const uint32_t INCEPTION_V3_WEIGHTS_MAGIC = 0x49563357; // "IV3W"
+static const uint32_t INCEPTION_V3_WEIGHTS_VERSION = 1;
+static const uint32_t INCEPTION_V3_SMALL_WEIGHTS_VERSION = 2;
+
+// Weights file written by export_cpu_weights.py, little endian:
+//   header: magic, version, layer_count, classes (uint32 each)
+//   per layer: kernel_h, kernel_w, in_channels, out_channels (uint32 each),
+//              scale[out_channels] float, bias[out_channels] float,
+//              weights[out_channels][kernel_h][kernel_w][in_channels] int8
+// The 94 convolutions come in graph order with their batch norm folded in, each
+// output channel quantized symmetrically (float weight = int8 * scale). The last
+// layer is the classifier as a 1x1 convolution over the 2048 pooled features.
+//
+// Version 2 holds a small plain CNN instead, the cascade's cheap first stage
+// (export_cpu_weights.py --small):
+//   header: magic, version, layer_count, classes, input_size (uint32 each)
+//   per layer: kernel_h, kernel_w, in_channels, out_channels, stride, same (uint32 each),
+//              then scale, bias and weights as above
+// The convolutions run one after another with ReLU on an input_size square RGB
+// tensor (the first with "valid" padding), their output is average pooled, and
+// the last layer is the 1x1 classifier.
+
+// Inception-v3 on the host CPU, for overflow offload when the accelerator is
+// saturated and as a numeric reference on machines without one. Loaded with a
+// version 2 file it runs that small model instead.
+//
+// Convolutions run on 8-bit values: each input tensor is quantized to 0..255
+// with a per-tensor scale taken from its maximum (every activation is post-ReLU,
+// so the zero point is 0), multiplied with the int8 weights into int32
+// accumulators, and rescaled, biased and rectified into float. Pooling and
+// concatenation stay in float. The inner products are plain loops that the
+// compiler vectorizes, and each layer is split into tiles of output pixels and
+// channels that the worker threads pick up.
+//
+// Takes the same 299x299 RGB tensor as the HEF (a small model takes its own
+// input_size) and produces softmax scores quantized with output_info, so its
+// output goes through the same postprocess as the device's.
+class InceptionV3CpuBackend : public InceptionV3Backend
+{
+public:
+    // threads = 0 uses every online core.
+    explicit InceptionV3CpuBackend(const std::string &weights_path, size_t threads = 0,
+                                   const hailo_vstream_info_t &output_info = inception_v3_output_info());
+    ~InceptionV3CpuBackend();
+
+    hailo_vstream_info_t input_info() const override { return m_input_info; }
+    hailo_vstream_info_t output_info() const override { return m_output_info; }
+    size_t input_frame_size() const override;
+    size_t output_frame_size() const override;
+
+    // Frames run one after another, each across every thread.
+    void infer(const std::vector<uint8_t *> &inputs, const std::vector<uint8_t *> &outputs) override;
+
+    size_t threads() const;
+    // Whether the file was a version 2 small model rather than Inception-v3.
+    bool small_model() const { return m_small; }
+
+private:
+    struct Layer;
+    class Workers;
+
+    struct Tensor
+    {
+        uint32_t height = 0;
+        uint32_t width = 0;
+        uint32_t channels = 0;
+        std::vector<float> data;  // height x width x channels
+
+        void reshape(uint32_t new_height, uint32_t new_width, uint32_t new_channels);
+    };
+
+    struct QuantizedTensor
+    {
+        uint32_t height = 0;
+        uint32_t width = 0;
+        uint32_t channels = 0;
+        float scale = 1.0f;         // float value = quantized * scale
+        std::vector<int16_t> data;  // 0..255, in 16-bit lanes for the multiply-adds
+    };
+
+    void load(const std::string &weights_path);
+    void load_small(std::ifstream &file, const std::string &weights_path, uint32_t layer_count);
+    std::unique_ptr<Layer> read_layer(std::ifstream &file, const std::string &weights_path, const uint32_t shape[4]);
+    void run_frame(const uint8_t *input, uint8_t *output);
+    const Tensor &run_small();
+    void classify(const Tensor &features, uint8_t *output);
+
+    // Graph primitives; conv() consumes the next layer of the file.
+    void quantize(const Tensor &input, QuantizedTensor &output);
+    void conv(const QuantizedTensor &input, uint32_t stride, bool same, Tensor &output);
+    void conv(const QuantizedTensor &input, uint32_t stride, bool same, Tensor &output, uint32_t channel_offset,
+              bool relu = true);
+    void max_pool(const Tensor &input, Tensor &output, uint32_t channel_offset);
+    void avg_pool(const Tensor &input, Tensor &output);
+
+    // Inception blocks at 35x35, 35x35 -> 17x17, 17x17, 17x17 -> 8x8 and 8x8.
+    void mixed_35(const Tensor &input, Tensor &output, uint32_t pool_features);
+    void reduce_35(const Tensor &input, Tensor &output);
+    void mixed_17(const Tensor &input, Tensor &output);
+    void reduce_17(const Tensor &input, Tensor &output);
+    void mixed_8(const Tensor &input, Tensor &output);
+
+    hailo_vstream_info_t m_input_info;
+    hailo_vstream_info_t m_output_info;
+    uint32_t m_classes;
+    bool m_small;               // a version 2 chain rather than Inception-v3
+    std::vector<std::unique_ptr<Layer>> m_layers;
+    size_t m_next_layer;
+
+    std::unique_ptr<Workers> m_workers;
+    std::mutex m_infer_mutex;
+
+    // Scratch, sized by the first frame and reused afterwards.
+    QuantizedTensor m_input;
+    Tensor m_blocks[2];
+    Tensor m_branches[2];
+    Tensor m_pooled;
+    QuantizedTensor m_block_quantized;
+    QuantizedTensor m_branch_quantized;
+    std::vector<int16_t> m_columns;
+};
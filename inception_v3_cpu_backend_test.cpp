@@ -0,0 +1,246 @@
+#include "inception_v3_cpu_backend.hpp"
+#include "inception_v3_test.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+// The CPU engine's small-model (version 2) path against a direct reference
+// implementation of the same int8 arithmetic, on a random model written to a
+// temporary file, plus the loader's shape checks.
+
+namespace
+{
+struct LayerSpec
+{
+    uint32_t kernel_h, kernel_w, in_channels, out_channels, stride, same;
+    std::vector<float> scale;
+    std::vector<float> bias;
+    std::vector<int8_t> weights;
+};
+
+struct Activation
+{
+    uint32_t height, width, channels;
+    std::vector<float> data;
+};
+
+const uint32_t INPUT_SIZE = 37;
+const uint32_t CLASSES = 10;
+
+std::vector<LayerSpec> random_model(std::mt19937 &rng)
+{
+    const uint32_t shapes[][6] = {
+        {3, 3, 3, 8, 2, 0}, {3, 3, 8, 16, 2, 1}, {1, 3, 16, 12, 1, 1}, {3, 3, 12, 24, 2, 1}, {1, 1, 24, CLASSES, 1, 0}};
+    std::uniform_real_distribution<float> scale(0.0005f, 0.003f);
+    std::uniform_real_distribution<float> bias(-0.5f, 0.5f);
+
+    std::vector<LayerSpec> layers;
+    for (const auto &shape : shapes) {
+        LayerSpec layer{shape[0], shape[1], shape[2], shape[3], shape[4], shape[5], {}, {}, {}};
+        for (uint32_t c = 0; c < layer.out_channels; c++) {
+            layer.scale.push_back(scale(rng));
+            layer.bias.push_back(bias(rng));
+        }
+        layer.weights.resize(static_cast<size_t>(layer.out_channels) * layer.kernel_h * layer.kernel_w *
+                             layer.in_channels);
+        for (auto &weight : layer.weights) {
+            weight = static_cast<int8_t>(static_cast<int>(rng() % 255) - 127);
+        }
+        layers.push_back(std::move(layer));
+    }
+    return layers;
+}
+
+void write_model(const std::string &path, const std::vector<LayerSpec> &layers, uint32_t input_size)
+{
+    std::ofstream file(path, std::ios::binary);
+    const uint32_t header[5] = {INCEPTION_V3_WEIGHTS_MAGIC, INCEPTION_V3_SMALL_WEIGHTS_VERSION,
+                                static_cast<uint32_t>(layers.size()), layers.back().out_channels, input_size};
+    file.write(reinterpret_cast<const char *>(header), sizeof(header));
+    for (const auto &layer : layers) {
+        const uint32_t shape[6] = {layer.kernel_h, layer.kernel_w, layer.in_channels,
+                                   layer.out_channels, layer.stride, layer.same};
+        file.write(reinterpret_cast<const char *>(shape), sizeof(shape));
+        file.write(reinterpret_cast<const char *>(layer.scale.data()), layer.scale.size() * sizeof(float));
+        file.write(reinterpret_cast<const char *>(layer.bias.data()), layer.bias.size() * sizeof(float));
+        file.write(reinterpret_cast<const char *>(layer.weights.data()), layer.weights.size());
+    }
+}
+
+// Per-tensor 8-bit quantization of a post-ReLU activation, as the engine does it.
+std::vector<int32_t> quantize(const Activation &input, float &scale)
+{
+    float maximum = 0.0f;
+    for (float value : input.data) {
+        maximum = std::max(maximum, value);
+    }
+    scale = maximum > 0.0f ? maximum / 255.0f : 1.0f;
+    std::vector<int32_t> quantized;
+    for (float value : input.data) {
+        quantized.push_back(static_cast<int32_t>(std::min(value / scale + 0.5f, 255.0f)));
+    }
+    return quantized;
+}
+
+Activation reference_conv(const Activation &input, const LayerSpec &layer, bool first, bool relu)
+{
+    float input_scale = 1.0f / 127.5f;
+    std::vector<int32_t> values;
+    if (first) {
+        for (float value : input.data) {
+            values.push_back(static_cast<int32_t>(value));
+        }
+    } else {
+        values = quantize(input, input_scale);
+    }
+
+    Activation output;
+    uint32_t pad_top = 0, pad_left = 0;
+    if (layer.same) {
+        output.height = (input.height + layer.stride - 1) / layer.stride;
+        output.width = (input.width + layer.stride - 1) / layer.stride;
+        pad_top = std::max<int>(0, (output.height - 1) * layer.stride + layer.kernel_h - input.height) / 2;
+        pad_left = std::max<int>(0, (output.width - 1) * layer.stride + layer.kernel_w - input.width) / 2;
+    } else {
+        output.height = (input.height - layer.kernel_h) / layer.stride + 1;
+        output.width = (input.width - layer.kernel_w) / layer.stride + 1;
+    }
+    output.channels = layer.out_channels;
+    output.data.resize(static_cast<size_t>(output.height) * output.width * output.channels);
+
+    for (uint32_t y = 0; y < output.height; y++) {
+        for (uint32_t x = 0; x < output.width; x++) {
+            for (uint32_t c = 0; c < layer.out_channels; c++) {
+                // The first layer sees x / 127.5 - 1: sum(w * x) / 127.5 - sum(w).
+                int32_t sum = 0;
+                int32_t weight_sum = 0;
+                const int8_t *weights = layer.weights.data() +
+                                        static_cast<size_t>(c) * layer.kernel_h * layer.kernel_w * layer.in_channels;
+                for (uint32_t ky = 0; ky < layer.kernel_h; ky++) {
+                    for (uint32_t kx = 0; kx < layer.kernel_w; kx++) {
+                        const int iy = static_cast<int>(y * layer.stride + ky) - static_cast<int>(pad_top);
+                        const int ix = static_cast<int>(x * layer.stride + kx) - static_cast<int>(pad_left);
+                        for (uint32_t k = 0; k < layer.in_channels; k++, weights++) {
+                            weight_sum += *weights;
+                            if (iy >= 0 && iy < static_cast<int>(input.height) && ix >= 0 &&
+                                ix < static_cast<int>(input.width)) {
+                                sum += *weights * values[(static_cast<size_t>(iy) * input.width + ix) *
+                                                             input.channels + k];
+                            }
+                        }
+                    }
+                }
+                float value = sum * input_scale * layer.scale[c] + layer.bias[c];
+                if (first) {
+                    value -= layer.scale[c] * weight_sum;
+                }
+                output.data[(static_cast<size_t>(y) * output.width + x) * output.channels + c] =
+                    relu ? std::max(value, 0.0f) : value;
+            }
+        }
+    }
+    return output;
+}
+
+std::vector<uint8_t> reference_scores(const std::vector<LayerSpec> &layers, const std::vector<uint8_t> &input)
+{
+    Activation activation{INPUT_SIZE, INPUT_SIZE, 3, std::vector<float>(input.begin(), input.end())};
+    for (size_t i = 0; i + 1 < layers.size(); i++) {
+        activation = reference_conv(activation, layers[i], i == 0, true);
+    }
+
+    Activation pooled{1, 1, activation.channels, std::vector<float>(activation.channels)};
+    const size_t positions = static_cast<size_t>(activation.height) * activation.width;
+    for (size_t c = 0; c < activation.channels; c++) {
+        float sum = 0.0f;
+        for (size_t p = 0; p < positions; p++) {
+            sum += activation.data[p * activation.channels + c];
+        }
+        pooled.data[c] = sum / positions;
+    }
+    Activation logits = reference_conv(pooled, layers.back(), false, false);
+
+    const float maximum = *std::max_element(logits.data.begin(), logits.data.end());
+    float total = 0.0f;
+    for (float &value : logits.data) {
+        value = std::exp(value - maximum);
+        total += value;
+    }
+    std::vector<uint8_t> scores;
+    for (float value : logits.data) {
+        scores.push_back(static_cast<uint8_t>(std::min(std::round(value / total * 255.0f), 255.0f)));
+    }
+    return scores;
+}
+
+bool rejected(const std::string &path)
+{
+    try {
+        InceptionV3CpuBackend backend(path, 1, inception_v3_output_info(CLASSES));
+    } catch (const std::runtime_error &) {
+        return true;
+    }
+    return false;
+}
+
+void compare(const std::string &isa, std::mt19937 &rng)
+{
+    const std::string path = "inception_v3_cpu_backend_test.iv3w";
+    for (size_t c = 0; c < 5; c++) {
+        const auto layers = random_model(rng);
+        write_model(path, layers, INPUT_SIZE);
+
+        for (size_t threads : {1, 3}) {
+            InceptionV3CpuBackend backend(path, threads, inception_v3_output_info(CLASSES));
+            inception_v3_check(backend.input_info().shape.width == INPUT_SIZE &&
+                                   backend.input_frame_size() == INPUT_SIZE * INPUT_SIZE * 3,
+                               isa, "small model input shape", c);
+
+            std::vector<uint8_t> input(backend.input_frame_size());
+            for (auto &value : input) {
+                value = static_cast<uint8_t>(rng());
+            }
+            std::vector<uint8_t> output(CLASSES);
+            backend.infer({input.data()}, {output.data()});
+
+            // Float summation order differs, which can move a quantized activation by one step.
+            const auto expected = reference_scores(layers, input);
+            bool close = true;
+            for (uint32_t k = 0; k < CLASSES; k++) {
+                close = close && std::abs(static_cast<int>(output[k]) - static_cast<int>(expected[k])) <= 2;
+            }
+            inception_v3_check(close, isa, "small model scores", c);
+        }
+    }
+
+    // The loader refuses chains that do not connect or that it cannot run exactly.
+    auto layers = random_model(rng);
+    layers[0].same = 1;
+    write_model(path, layers, INPUT_SIZE);
+    inception_v3_check(rejected(path), isa, "same-padded first layer", 0);
+
+    layers = random_model(rng);
+    layers[2].in_channels = 15;
+    write_model(path, layers, INPUT_SIZE);
+    inception_v3_check(rejected(path), isa, "unconnected layer", 0);
+
+    layers = random_model(rng);
+    layers.back().kernel_h = 3;
+    write_model(path, layers, INPUT_SIZE);
+    inception_v3_check(rejected(path), isa, "classifier that is not 1x1", 0);
+
+    write_model(path, random_model(rng), 2);
+    inception_v3_check(rejected(path), isa, "input smaller than the first kernel", 0);
+
+    std::remove(path.c_str());
+}
+} // namespace
+
+int main()
+{
+    inception_v3_for_each_isa(compare);
+    return inception_v3_test_result();
+}
@@ -0,0 +1,325 @@
+#include "inception_v3_daemon.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+std::runtime_error errno_error(const std::string &what)
+{
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+bool read_all(int fd, void *buffer, size_t size)
+{
+    auto *ptr = static_cast<uint8_t *>(buffer);
+    while (size > 0) {
+        ssize_t n = ::read(fd, ptr, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        ptr += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool write_all(int fd, const void *buffer, size_t size)
+{
+    auto *ptr = static_cast<const uint8_t *>(buffer);
+    while (size > 0) {
+        ssize_t n = ::send(fd, ptr, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        ptr += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+sockaddr_un make_address(const std::string &socket_path)
+{
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("socket path too long: " + socket_path);
+    }
+    std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    return addr;
+}
+}
+
+struct InceptionV3Daemon::Connection
+{
+    int fd;
+    std::mutex write_mutex;
+
+    explicit Connection(int fd) : fd(fd) {}
+    ~Connection() { ::close(fd); }
+
+    void reply(uint32_t status, float confidence, const std::string &label)
+    {
+        InceptionV3DaemonReply header = {status, confidence, static_cast<uint32_t>(label.size())};
+        std::lock_guard<std::mutex> lock(write_mutex);
+        if (write_all(fd, &header, sizeof(header))) {
+            write_all(fd, label.data(), label.size());
+        }
+    }
+};
+
+InceptionV3Daemon::InceptionV3Daemon(InceptionV3Runner &runner, const std::string &socket_path,
+                                     size_t max_batch, std::chrono::microseconds batch_window,
+                                     size_t max_pending)
+    : m_runner(runner), m_socket_path(socket_path), m_max_batch(max_batch > 0 ? max_batch : 1),
+      m_batch_window(batch_window), m_max_pending(std::max(max_pending, m_max_batch)), m_listen_fd(-1),
+      m_running(false)
+{
+    m_listen_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_listen_fd < 0) {
+        throw errno_error("socket");
+    }
+
+    auto addr = make_address(socket_path);
+    ::unlink(socket_path.c_str());
+    if (::bind(m_listen_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 ||
+        ::listen(m_listen_fd, SOMAXCONN) < 0) {
+        auto error = errno_error("bind " + socket_path);
+        ::close(m_listen_fd);
+        throw error;
+    }
+}
+
+InceptionV3Daemon::~InceptionV3Daemon()
+{
+    ::close(m_listen_fd);
+    ::unlink(m_socket_path.c_str());
+}
+
+void InceptionV3Daemon::run()
+{
+    m_running = true;
+    std::thread inference_thread(&InceptionV3Daemon::inference_loop, this);
+
+    while (m_running) {
+        pollfd pfd = {m_listen_fd, POLLIN, 0};
+        int ready = ::poll(&pfd, 1, 200);
+        reap_clients();
+        if (ready <= 0) {
+            continue;
+        }
+
+        int fd = ::accept4(m_listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+
+        auto connection = std::make_shared<Connection>(fd);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_connections.push_back(connection);
+        std::thread client(&InceptionV3Daemon::serve_client, this, connection);
+        auto id = client.get_id();
+        m_client_threads.emplace(id, std::move(client));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto &weak : m_connections) {
+            if (auto connection = weak.lock()) {
+                ::shutdown(connection->fd, SHUT_RDWR);
+            }
+        }
+    }
+    m_cv.notify_all();
+    m_space_cv.notify_all();
+    inference_thread.join();
+
+    std::map<std::thread::id, std::thread> clients;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        clients.swap(m_client_threads);
+        m_finished_clients.clear();
+    }
+    for (auto &client : clients) {
+        client.second.join();
+    }
+}
+
+void InceptionV3Daemon::stop()
+{
+    m_running = false;
+    m_cv.notify_all();
+    m_space_cv.notify_all();
+}
+
+void InceptionV3Daemon::reap_clients()
+{
+    std::vector<std::thread> finished;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto id : m_finished_clients) {
+            auto it = m_client_threads.find(id);
+            if (it != m_client_threads.end()) {
+                finished.push_back(std::move(it->second));
+                m_client_threads.erase(it);
+            }
+        }
+        m_finished_clients.clear();
+
+        m_connections.erase(std::remove_if(m_connections.begin(), m_connections.end(),
+                                           [](const std::weak_ptr<Connection> &c) { return c.expired(); }),
+                            m_connections.end());
+    }
+    for (auto &thread : finished) {
+        thread.join();
+    }
+}
+
+void InceptionV3Daemon::serve_client(std::shared_ptr<Connection> connection)
+{
+    const size_t frame_size = m_runner.input_frame_size();
+    InceptionV3DaemonRequest request;
+
+    while (m_running && read_all(connection->fd, &request, sizeof(request))) {
+        if (request.magic != INCEPTION_V3_DAEMON_MAGIC || request.frame_size != frame_size) {
+            connection->reply(INCEPTION_V3_DAEMON_BAD_REQUEST, 0.0f, "");
+            break;
+        }
+
+        // Backpressure: the frame is read only once the queue has room for it.
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_space_cv.wait(lock, [this]() { return m_pending.size() < m_max_pending || !m_running; });
+        }
+        if (!m_running) {
+            break;
+        }
+
+        Pending pending;
+        pending.connection = connection;
+        pending.frame.resize(frame_size);
+        if (!read_all(connection->fd, pending.frame.data(), frame_size)) {
+            break;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pending.push_back(std::move(pending));
+        }
+        m_cv.notify_one();
+    }
+
+    connection.reset();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_finished_clients.push_back(std::this_thread::get_id());
+}
+
+void InceptionV3Daemon::inference_loop()
+{
+    std::vector<Pending> batch;
+    std::vector<uint8_t *> frames;
+
+    while (true) {
+        batch.clear();
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]() { return !m_pending.empty() || !m_running; });
+            if (!m_running) {
+                return;
+            }
+
+            // Give other clients a short window to join this batch.
+            auto deadline = std::chrono::steady_clock::now() + m_batch_window;
+            m_cv.wait_until(lock, deadline, [this]() { return m_pending.size() >= m_max_batch || !m_running; });
+
+            while (!m_pending.empty() && batch.size() < m_max_batch) {
+                batch.push_back(std::move(m_pending.front()));
+                m_pending.pop_front();
+            }
+        }
+        m_space_cv.notify_all();
+
+        frames.clear();
+        for (auto &pending : batch) {
+            frames.push_back(pending.frame.data());
+        }
+
+        try {
+            auto results = m_runner.classify_batch(frames);
+            for (size_t i = 0; i < batch.size(); i++) {
+                auto status = results[i].valid ? INCEPTION_V3_DAEMON_OK : INCEPTION_V3_DAEMON_BELOW_THRESHOLD;
+                batch[i].connection->reply(status, results[i].confidence, results[i].label);
+            }
+        } catch (const std::exception &e) {
+            for (auto &pending : batch) {
+                pending.connection->reply(INCEPTION_V3_DAEMON_INFERENCE_ERROR, 0.0f, e.what());
+            }
+        }
+    }
+}
+
+InceptionV3DaemonClient::InceptionV3DaemonClient(const std::string &socket_path)
+{
+    m_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_fd < 0) {
+        throw errno_error("socket");
+    }
+
+    auto addr = make_address(socket_path);
+    if (::connect(m_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+        auto error = errno_error("connect " + socket_path);
+        ::close(m_fd);
+        throw error;
+    }
+}
+
+InceptionV3DaemonClient::~InceptionV3DaemonClient()
+{
+    ::close(m_fd);
+}
+
+InceptionV3Result InceptionV3DaemonClient::classify(const uint8_t *frame, size_t frame_size)
+{
+    InceptionV3DaemonRequest request = {INCEPTION_V3_DAEMON_MAGIC, static_cast<uint32_t>(frame_size)};
+    if (!write_all(m_fd, &request, sizeof(request)) || !write_all(m_fd, frame, frame_size)) {
+        throw errno_error("daemon request");
+    }
+
+    InceptionV3DaemonReply reply;
+    if (!read_all(m_fd, &reply, sizeof(reply))) {
+        throw std::runtime_error("daemon closed the connection");
+    }
+
+    std::string label(reply.label_size, '\0');
+    if (reply.label_size > 0 && !read_all(m_fd, &label[0], label.size())) {
+        throw std::runtime_error("daemon closed the connection");
+    }
+
+    switch (reply.status) {
+    case INCEPTION_V3_DAEMON_OK:
+        break;
+    case INCEPTION_V3_DAEMON_BELOW_THRESHOLD:
+        return InceptionV3Result();
+    case INCEPTION_V3_DAEMON_BAD_REQUEST:
+        throw std::runtime_error("daemon rejected the request (frame size mismatch?)");
+    default:
+        throw std::runtime_error("daemon inference error: " + label);
+    }
+
+    InceptionV3Result result;
+    result.valid = true;
+    result.label = label;
+    result.confidence = reply.confidence;
+    return result;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include "inception_v3_runner.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Wire format on the Unix socket, host byte order (both ends are local).
+// A client sends a request header followed by frame_size bytes of input tensor,
+// the daemon answers with a reply header followed by label_size bytes of label.
+// Requests on one connection are answered in order, so clients may pipeline them.
+static const uint32_t INCEPTION_V3_DAEMON_MAGIC = 0x49563344; // "IV3D"
+
+enum InceptionV3DaemonStatus : uint32_t
+{
+    INCEPTION_V3_DAEMON_OK = 0,
+    INCEPTION_V3_DAEMON_BELOW_THRESHOLD = 1,
+    INCEPTION_V3_DAEMON_BAD_REQUEST = 2,
+    INCEPTION_V3_DAEMON_INFERENCE_ERROR = 3,
+};
+
+struct InceptionV3DaemonRequest
+{
+    uint32_t magic;
+    uint32_t frame_size;
+};
+
+struct InceptionV3DaemonReply
+{
+    uint32_t status;
+    float confidence;
+    uint32_t label_size;
+};
+
+// Keeps one InceptionV3Runner configured and serves classification requests from
+// any number of local clients. Requests that arrive within batch_window of each
+// other are sent to the device as one batch, regardless of which client sent them.
+// At most max_pending requests wait for the device; beyond that a client's next
+// frame stays unread in its socket until the queue drains.
+class InceptionV3Daemon
+{
+public:
+    InceptionV3Daemon(InceptionV3Runner &runner, const std::string &socket_path,
+                      size_t max_batch = 8,
+                      std::chrono::microseconds batch_window = std::chrono::microseconds(2000),
+                      size_t max_pending = 64);
+    ~InceptionV3Daemon();
+
+    // Blocks until stop() is called.
+    void run();
+    void stop();
+
+private:
+    struct Connection;
+    struct Pending
+    {
+        std::shared_ptr<Connection> connection;
+        std::vector<uint8_t> frame;
+    };
+
+    void serve_client(std::shared_ptr<Connection> connection);
+    void reap_clients();
+    void inference_loop();
+
+    InceptionV3Runner &m_runner;
+    std::string m_socket_path;
+    size_t m_max_batch;
+    std::chrono::microseconds m_batch_window;
+    size_t m_max_pending;
+    int m_listen_fd;
+    std::atomic<bool> m_running;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::condition_variable m_space_cv;     // m_pending dropped below m_max_pending
+    std::deque<Pending> m_pending;
+    std::map<std::thread::id, std::thread> m_client_threads;
+    std::vector<std::thread::id> m_finished_clients;
+    std::vector<std::weak_ptr<Connection>> m_connections;
+};
+
+class InceptionV3DaemonClient
+{
+public:
+    explicit InceptionV3DaemonClient(const std::string &socket_path);
+    ~InceptionV3DaemonClient();
+
+    InceptionV3Result classify(const uint8_t *frame, size_t frame_size);
+
+private:
+    int m_fd;
+};
@@ -0,0 +1,430 @@
+#include "inception_v3_embedding.hpp"
+#include "inception_v3_kernels.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+struct IndexFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t dims;
+    uint32_t stride;
+    uint64_t count;
+    uint64_t lists;
+    uint64_t ids_offset;
+    uint64_t scales_offset;
+    uint64_t assignments_offset;
+    uint64_t centroid_scales_offset;
+    uint64_t centroids_offset;
+    uint64_t rows_offset;
+};
+
+const size_t ALIGNMENT = 64;
+
+size_t align_up(size_t value)
+{
+    return (value + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+// True if count elements of element_size bytes at offset lie inside a file_size byte file.
+// Offsets must keep the uint64_t/float views aligned.
+bool section_fits(uint64_t offset, uint64_t count, uint64_t element_size, uint64_t file_size)
+{
+    if (offset % sizeof(uint64_t) != 0 || offset > file_size) {
+        return false;
+    }
+    return element_size == 0 || count <= (file_size - offset) / element_size;
+}
+
+std::runtime_error errno_error(const std::string &what)
+{
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+// Normalizes values to unit length and quantizes them into out (stride bytes, zero padded).
+float quantize_unit(std::vector<float> &values, int8_t *out, size_t stride)
+{
+    double norm = 0.0;
+    for (float value : values) {
+        norm += static_cast<double>(value) * value;
+    }
+    std::fill(out, out + stride, 0);
+    if (norm == 0.0) {
+        return 0.0f;
+    }
+
+    float inverse_norm = static_cast<float>(1.0 / std::sqrt(norm));
+    float max_abs = 0.0f;
+    for (auto &value : values) {
+        value *= inverse_norm;
+        max_abs = std::max(max_abs, std::fabs(value));
+    }
+    for (size_t i = 0; i < values.size(); i++) {
+        out[i] = static_cast<int8_t>(std::lround(values[i] / max_abs * 127.0f));
+    }
+    return max_abs / 127.0f;
+}
+
+void write_all(int fd, const void *data, size_t size, const std::string &path)
+{
+    const char *bytes = static_cast<const char *>(data);
+    while (size > 0) {
+        ssize_t written = write(fd, bytes, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw errno_error("write " + path);
+        }
+        bytes += written;
+        size -= written;
+    }
+}
+} // namespace
+
+void make_inception_v3_embedding(const uint8_t *features, size_t dims, const hailo_quant_info_t &quant,
+                                 InceptionV3Embedding &embedding)
+{
+    std::vector<float> values(dims);
+    double mean = 0.0;
+    for (size_t i = 0; i < dims; i++) {
+        values[i] = (features[i] - quant.qp_zp) * quant.qp_scale;
+        mean += values[i];
+    }
+    mean /= dims ? dims : 1;
+    for (auto &value : values) {
+        value -= static_cast<float>(mean);
+    }
+
+    embedding.values.resize(dims);
+    std::vector<int8_t> padded(align_up(dims));
+    embedding.scale = quantize_unit(values, padded.data(), padded.size());
+    std::copy(padded.begin(), padded.begin() + dims, embedding.values.begin());
+}
+
+int32_t inception_v3_dot_i8(const int8_t *a, const int8_t *b, size_t dims)
+{
+    // Widening multiply-add, built per ISA (pmaddwd on x86, sdot with dotprod).
+    return inception_v3_kernels().dot_i8(a, b, dims);
+}
+
+InceptionV3EmbeddingIndex::InceptionV3EmbeddingIndex(size_t dims)
+    : m_dims(dims), m_stride(align_up(dims)), m_count(0), m_ids(nullptr), m_scales(nullptr),
+      m_assignments(nullptr), m_rows(nullptr), m_list_count(0), m_centroid_scales(nullptr), m_centroids(nullptr),
+      m_mapping(nullptr), m_mapping_size(0)
+{
+    if (dims == 0) {
+        throw std::invalid_argument("embedding index needs at least one dimension");
+    }
+}
+
+InceptionV3EmbeddingIndex::~InceptionV3EmbeddingIndex()
+{
+    unmap();
+}
+
+void InceptionV3EmbeddingIndex::unmap()
+{
+    if (m_mapping) {
+        munmap(m_mapping, m_mapping_size);
+        m_mapping = nullptr;
+        m_mapping_size = 0;
+    }
+}
+
+// Copies a mapped index into the owned vectors so that it can grow.
+void InceptionV3EmbeddingIndex::own_storage()
+{
+    if (!m_mapping) {
+        return;
+    }
+    m_owned_ids.assign(m_ids, m_ids + m_count);
+    m_owned_scales.assign(m_scales, m_scales + m_count);
+    m_owned_assignments.assign(m_assignments, m_assignments + (m_list_count ? m_count : 0));
+    m_owned_rows.assign(m_rows, m_rows + m_count * m_stride);
+    m_owned_centroid_scales.assign(m_centroid_scales, m_centroid_scales + m_list_count);
+    m_owned_centroids.assign(m_centroids, m_centroids + m_list_count * m_stride);
+    unmap();
+
+    m_ids = m_owned_ids.data();
+    m_scales = m_owned_scales.data();
+    m_assignments = m_owned_assignments.data();
+    m_rows = m_owned_rows.data();
+    m_centroid_scales = m_owned_centroid_scales.data();
+    m_centroids = m_owned_centroids.data();
+}
+
+void InceptionV3EmbeddingIndex::add(uint64_t id, const InceptionV3Embedding &embedding)
+{
+    if (embedding.values.size() != m_dims) {
+        throw std::invalid_argument("embedding has " + std::to_string(embedding.values.size()) +
+                                    " dimensions, index expects " + std::to_string(m_dims));
+    }
+    own_storage();
+
+    m_owned_ids.push_back(id);
+    m_owned_scales.push_back(embedding.scale);
+    m_owned_rows.resize((m_count + 1) * m_stride, 0);
+    std::copy(embedding.values.begin(), embedding.values.end(), m_owned_rows.begin() + m_count * m_stride);
+
+    m_ids = m_owned_ids.data();
+    m_scales = m_owned_scales.data();
+    m_rows = m_owned_rows.data();
+    if (m_list_count) {
+        uint32_t list = static_cast<uint32_t>(nearest_list(row(m_count)));
+        m_owned_assignments.push_back(list);
+        m_assignments = m_owned_assignments.data();
+        m_lists[list].push_back(static_cast<uint32_t>(m_count));
+    }
+    m_count++;
+}
+
+size_t InceptionV3EmbeddingIndex::nearest_list(const int8_t *values) const
+{
+    size_t best = 0;
+    float best_similarity = -2.0f;
+    for (size_t list = 0; list < m_list_count; list++) {
+        float similarity = inception_v3_dot_i8(values, centroid(list), m_stride) * m_centroid_scales[list];
+        if (similarity > best_similarity) {
+            best_similarity = similarity;
+            best = list;
+        }
+    }
+    return best;
+}
+
+void InceptionV3EmbeddingIndex::rebuild_lists()
+{
+    m_lists.assign(m_list_count, {});
+    for (size_t i = 0; i < m_count && m_list_count; i++) {
+        m_lists[m_assignments[i]].push_back(static_cast<uint32_t>(i));
+    }
+}
+
+std::vector<InceptionV3Match> InceptionV3EmbeddingIndex::search(const InceptionV3Embedding &query, size_t k,
+                                                                size_t nprobe) const
+{
+    if (query.values.size() != m_dims) {
+        throw std::invalid_argument("query has " + std::to_string(query.values.size()) + " dimensions, index expects " +
+                                    std::to_string(m_dims));
+    }
+    std::vector<int8_t> padded(m_stride, 0);
+    std::copy(query.values.begin(), query.values.end(), padded.begin());
+
+    // Min-heap of the best k so far, worst on top.
+    auto worse = [](const InceptionV3Match &a, const InceptionV3Match &b) { return a.similarity > b.similarity; };
+    std::priority_queue<InceptionV3Match, std::vector<InceptionV3Match>, decltype(worse)> best(worse);
+    auto consider = [&](size_t index) {
+        float similarity = inception_v3_dot_i8(padded.data(), row(index), m_stride) * m_scales[index] * query.scale;
+        if (best.size() < k) {
+            best.push({m_ids[index], similarity});
+        } else if (k > 0 && similarity > best.top().similarity) {
+            best.pop();
+            best.push({m_ids[index], similarity});
+        }
+    };
+
+    if (m_list_count == 0) {
+        for (size_t i = 0; i < m_count; i++) {
+            consider(i);
+        }
+    } else {
+        std::vector<std::pair<float, size_t>> lists(m_list_count);
+        for (size_t list = 0; list < m_list_count; list++) {
+            lists[list] = {inception_v3_dot_i8(padded.data(), centroid(list), m_stride) * m_centroid_scales[list], list};
+        }
+        nprobe = std::min(std::max<size_t>(nprobe, 1), m_list_count);
+        std::partial_sort(lists.begin(), lists.begin() + nprobe, lists.end(), std::greater<std::pair<float, size_t>>());
+        for (size_t p = 0; p < nprobe; p++) {
+            for (uint32_t index : m_lists[lists[p].second]) {
+                consider(index);
+            }
+        }
+    }
+
+    std::vector<InceptionV3Match> matches(best.size());
+    for (size_t i = matches.size(); i > 0; i--) {
+        matches[i - 1] = best.top();
+        best.pop();
+    }
+    return matches;
+}
+
+void InceptionV3EmbeddingIndex::train(size_t nlist, size_t iterations)
+{
+    if (nlist == 0 || nlist > m_count) {
+        throw std::invalid_argument("IVF needs between 1 and " + std::to_string(m_count) + " lists");
+    }
+    own_storage();
+
+    // Spread initial centroids over the rows, then plain spherical k-means.
+    m_list_count = nlist;
+    m_owned_centroids.assign(nlist * m_stride, 0);
+    m_owned_centroid_scales.assign(nlist, 0.0f);
+    for (size_t list = 0; list < nlist; list++) {
+        size_t source = list * m_count / nlist;
+        std::copy(row(source), row(source) + m_stride, m_owned_centroids.begin() + list * m_stride);
+        m_owned_centroid_scales[list] = m_scales[source];
+    }
+    m_centroids = m_owned_centroids.data();
+    m_centroid_scales = m_owned_centroid_scales.data();
+    m_owned_assignments.assign(m_count, 0);
+    m_assignments = m_owned_assignments.data();
+
+    std::vector<float> sums(nlist * m_dims);
+    std::vector<size_t> sizes(nlist);
+    std::vector<float> values(m_dims);
+    for (size_t iteration = 0; iteration < iterations; iteration++) {
+        for (size_t i = 0; i < m_count; i++) {
+            m_owned_assignments[i] = static_cast<uint32_t>(nearest_list(row(i)));
+        }
+
+        std::fill(sums.begin(), sums.end(), 0.0f);
+        std::fill(sizes.begin(), sizes.end(), 0);
+        for (size_t i = 0; i < m_count; i++) {
+            float *sum = &sums[m_owned_assignments[i] * m_dims];
+            const int8_t *values_i8 = row(i);
+            for (size_t d = 0; d < m_dims; d++) {
+                sum[d] += values_i8[d] * m_scales[i];
+            }
+            sizes[m_owned_assignments[i]]++;
+        }
+        for (size_t list = 0; list < nlist; list++) {
+            if (sizes[list] == 0) {
+                continue; // keep the old centroid for an empty list
+            }
+            values.assign(sums.begin() + list * m_dims, sums.begin() + (list + 1) * m_dims);
+            m_owned_centroid_scales[list] = quantize_unit(values, &m_owned_centroids[list * m_stride], m_stride);
+        }
+    }
+    for (size_t i = 0; i < m_count; i++) {
+        m_owned_assignments[i] = static_cast<uint32_t>(nearest_list(row(i)));
+    }
+    rebuild_lists();
+}
+
+void InceptionV3EmbeddingIndex::save(const std::string &path) const
+{
+    IndexFileHeader header = {};
+    header.magic = INCEPTION_V3_INDEX_MAGIC;
+    header.version = INCEPTION_V3_INDEX_VERSION;
+    header.dims = static_cast<uint32_t>(m_dims);
+    header.stride = static_cast<uint32_t>(m_stride);
+    header.count = m_count;
+    header.lists = m_list_count;
+    header.ids_offset = align_up(sizeof(header));
+    header.scales_offset = align_up(header.ids_offset + m_count * sizeof(uint64_t));
+    header.assignments_offset = align_up(header.scales_offset + m_count * sizeof(float));
+    header.centroid_scales_offset =
+        align_up(header.assignments_offset + (m_list_count ? m_count : 0) * sizeof(uint32_t));
+    header.centroids_offset = align_up(header.centroid_scales_offset + m_list_count * sizeof(float));
+    header.rows_offset = align_up(header.centroids_offset + m_list_count * m_stride);
+    const size_t file_size = header.rows_offset + m_count * m_stride;
+
+    // Written to a temporary name and renamed, so a reader never maps half a file.
+    std::string temporary = path + ".tmp";
+    int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw errno_error("open " + temporary);
+    }
+    try {
+        std::vector<char> image(file_size, 0);
+        std::memcpy(image.data(), &header, sizeof(header));
+        if (m_count) {
+            std::memcpy(image.data() + header.ids_offset, m_ids, m_count * sizeof(uint64_t));
+            std::memcpy(image.data() + header.scales_offset, m_scales, m_count * sizeof(float));
+            std::memcpy(image.data() + header.rows_offset, m_rows, m_count * m_stride);
+        }
+        if (m_list_count) {
+            std::memcpy(image.data() + header.assignments_offset, m_assignments, m_count * sizeof(uint32_t));
+            std::memcpy(image.data() + header.centroid_scales_offset, m_centroid_scales, m_list_count * sizeof(float));
+            std::memcpy(image.data() + header.centroids_offset, m_centroids, m_list_count * m_stride);
+        }
+        write_all(fd, image.data(), image.size(), temporary);
+    } catch (...) {
+        close(fd);
+        unlink(temporary.c_str());
+        throw;
+    }
+    close(fd);
+    if (rename(temporary.c_str(), path.c_str()) < 0) {
+        throw errno_error("rename " + temporary);
+    }
+}
+
+void InceptionV3EmbeddingIndex::load(const std::string &path)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw errno_error("open " + path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) < 0) {
+        close(fd);
+        throw errno_error("stat " + path);
+    }
+    const size_t size = static_cast<size_t>(info.st_size);
+    if (size < sizeof(IndexFileHeader)) {
+        close(fd);
+        throw std::runtime_error(path + " is not an inception_v3 embedding index");
+    }
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        throw errno_error("mmap " + path);
+    }
+
+    const auto *base = static_cast<const uint8_t *>(mapping);
+    IndexFileHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    const bool lists = header.lists != 0;
+    bool valid = header.magic == INCEPTION_V3_INDEX_MAGIC && header.version == INCEPTION_V3_INDEX_VERSION &&
+                 header.dims != 0 && header.stride == align_up(header.dims) &&
+                 section_fits(header.ids_offset, header.count, sizeof(uint64_t), size) &&
+                 section_fits(header.scales_offset, header.count, sizeof(float), size) &&
+                 section_fits(header.assignments_offset, lists ? header.count : 0, sizeof(uint32_t), size) &&
+                 section_fits(header.centroid_scales_offset, header.lists, sizeof(float), size) &&
+                 section_fits(header.centroids_offset, header.lists, header.stride, size) &&
+                 section_fits(header.rows_offset, header.count, header.stride, size);
+    // Every row must point at a real list, or rebuild_lists() would index past m_lists.
+    const auto *assignments = reinterpret_cast<const uint32_t *>(base + header.assignments_offset);
+    for (uint64_t i = 0; valid && lists && i < header.count; i++) {
+        valid = assignments[i] < header.lists;
+    }
+    if (!valid) {
+        munmap(mapping, size);
+        throw std::runtime_error(path + " is not an inception_v3 embedding index or is damaged");
+    }
+
+    unmap();
+    m_mapping = mapping;
+    m_mapping_size = size;
+    m_dims = header.dims;
+    m_stride = header.stride;
+    m_count = header.count;
+    m_list_count = header.lists;
+    m_ids = reinterpret_cast<const uint64_t *>(base + header.ids_offset);
+    m_scales = reinterpret_cast<const float *>(base + header.scales_offset);
+    m_assignments = assignments;
+    m_centroid_scales = reinterpret_cast<const float *>(base + header.centroid_scales_offset);
+    m_centroids = reinterpret_cast<const int8_t *>(base + header.centroids_offset);
+    m_rows = reinterpret_cast<const int8_t *>(base + header.rows_offset);
+    m_owned_ids.clear();
+    m_owned_scales.clear();
+    m_owned_assignments.clear();
+    m_owned_rows.clear();
+    m_owned_centroid_scales.clear();
+    m_owned_centroids.clear();
+    rebuild_lists();
+}
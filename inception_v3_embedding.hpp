@@ -0,0 +1,102 @@
+#pragma once
+#include "hailo/hailort.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Int8 frame embeddings and an in-process similarity index.
+//
+// An embedding is a feature tensor (a pooled feature output when the HEF exposes
+// one, otherwise the fc1 logits) dequantized with its vstream quant info,
+// mean-centred, L2-normalized and quantized to int8 with a per-vector scale, so
+// that cosine similarity = dot(a, b) * scale_a * scale_b.
+
+struct InceptionV3Embedding
+{
+    std::vector<int8_t> values;
+    float scale = 0.0f;
+};
+
+// Builds the embedding of dims uint8 features.
+void make_inception_v3_embedding(const uint8_t *features, size_t dims, const hailo_quant_info_t &quant,
+                                 InceptionV3Embedding &embedding);
+
+// Dot product of two int8 vectors; written so the compiler vectorizes it.
+int32_t inception_v3_dot_i8(const int8_t *a, const int8_t *b, size_t dims);
+
+struct InceptionV3Match
+{
+    uint64_t id;
+    float similarity;           // cosine, in [-1, 1]
+};
+
+static const uint32_t INCEPTION_V3_INDEX_MAGIC = 0x49563345; // "IV3E"
+static const uint32_t INCEPTION_V3_INDEX_VERSION = 1;
+
+// Flat int8 index with optional IVF partitioning.
+//
+// Rows are padded to a multiple of 64 bytes, so in the saved file every vector
+// starts on a cache line. Without train() a search scans every row; after
+// train(nlist) rows are bucketed by their nearest of nlist k-means centroids and a
+// search only scans the nprobe buckets closest to the query.
+//
+// save() writes one file that load() maps read-only; searching a loaded index
+// reads the mapping directly, and the first add() copies it into memory.
+class InceptionV3EmbeddingIndex
+{
+public:
+    explicit InceptionV3EmbeddingIndex(size_t dims = 1000);
+    ~InceptionV3EmbeddingIndex();
+
+    InceptionV3EmbeddingIndex(const InceptionV3EmbeddingIndex &) = delete;
+    InceptionV3EmbeddingIndex &operator=(const InceptionV3EmbeddingIndex &) = delete;
+
+    size_t dims() const { return m_dims; }
+    size_t size() const { return m_count; }
+    size_t lists() const { return m_list_count; }
+
+    void add(uint64_t id, const InceptionV3Embedding &embedding);
+
+    // Best k matches, most similar first. nprobe is ignored on an untrained index.
+    std::vector<InceptionV3Match> search(const InceptionV3Embedding &query, size_t k, size_t nprobe = 4) const;
+
+    // k-means over the current rows; rows added later join their nearest list.
+    void train(size_t nlist, size_t iterations = 10);
+
+    void save(const std::string &path) const;
+    void load(const std::string &path);
+
+private:
+    const int8_t *row(size_t index) const { return m_rows + index * m_stride; }
+    const int8_t *centroid(size_t list) const { return m_centroids + list * m_stride; }
+    size_t nearest_list(const int8_t *values) const;
+    void own_storage();
+    void rebuild_lists();
+    void unmap();
+
+    size_t m_dims;
+    size_t m_stride;            // dims rounded up to 64
+
+    // Views used by search; point into the owned vectors or into the mapped file.
+    size_t m_count;
+    const uint64_t *m_ids;
+    const float *m_scales;
+    const uint32_t *m_assignments;
+    const int8_t *m_rows;
+    size_t m_list_count;
+    const float *m_centroid_scales;
+    const int8_t *m_centroids;
+
+    std::vector<uint64_t> m_owned_ids;
+    std::vector<float> m_owned_scales;
+    std::vector<uint32_t> m_owned_assignments;
+    std::vector<int8_t> m_owned_rows;
+    std::vector<float> m_owned_centroid_scales;
+    std::vector<int8_t> m_owned_centroids;
+
+    std::vector<std::vector<uint32_t>> m_lists;     // row indices per IVF list
+
+    void *m_mapping;
+    size_t m_mapping_size;
+};
@@ -0,0 +1,57 @@
+#include "inception_v3_config.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+
+// hailofilter entry points, for the GStreamer pipelines:
+//   hailofilter so-path=libinception_v3_inference.so function-name=infer [config-path=<file>]
+//
+// With a config file (the element's config-path, or INCEPTION_V3_CONFIG without
+// one), labels and thresholds come from it and are hot-reloaded through the same
+// inotify watcher and RCU swap as the C++ services: infer() reads them inside an
+// RCU read section, so the streaming thread never waits for a reload. Without one,
+// ./imagenet_classes.txt is used at a fixed 0.5 threshold.
+
+namespace
+{
+struct InceptionV3FilterParams : InceptionV3Params
+{
+    InceptionV3FilterParams(const std::string &labels_file) : InceptionV3Params(labels_file, 0.5f) {}
+
+    std::unique_ptr<InceptionV3ParamsWatcher> watcher;
+};
+}
+
+__BEGIN_DECLS
+void *init(const std::string config_path, const std::string function_name);
+void infer(HailoROIPtr roi, void *params_void_ptr);
+__END_DECLS
+
+void *init(const std::string config_path, const std::string function_name)
+{
+    (void)function_name;
+    std::string path = config_path == "NULL" ? "" : config_path;
+    const char *environment = std::getenv("INCEPTION_V3_CONFIG");
+    if (path.empty() && environment) {
+        path = environment;
+    }
+
+    if (path.empty()) {
+        return static_cast<InceptionV3Params *>(new InceptionV3FilterParams("./imagenet_classes.txt"));
+    }
+    std::unique_ptr<InceptionV3FilterParams> params(new InceptionV3FilterParams(""));
+    params->watcher.reset(new InceptionV3ParamsWatcher(path));
+    std::cerr << "inception_v3 filter: watching " << path << " for threshold and label changes" << std::endl;
+    return static_cast<InceptionV3Params *>(params.release());
+}
+
+void infer(HailoROIPtr roi, void *params_void_ptr)
+{
+    auto *params = static_cast<InceptionV3FilterParams *>(reinterpret_cast<InceptionV3Params *>(params_void_ptr));
+    if (params->watcher) {
+        InceptionV3RcuReadGuard guard;
+        postprocess_inception_v3(roi, params->watcher->current());
+        return;
+    }
+    postprocess_inception_v3(roi, params);
+}
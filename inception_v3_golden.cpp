@@ -0,0 +1,329 @@
+#include "inception_v3_cpu_backend.hpp"
+#include "inception_v3_jpeg.hpp"
+#include "inception_v3_runner.hpp"
+#include <algorithm>
+#include <cmath>
+#include <dirent.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+// Accuracy and latency regression check over an image corpus.
+//
+// Each image goes through the full native path (JPEG decode, resize, inference,
+// postprocess). Its top-5 is compared with the golden file, and its median
+// latency over --repeat runs must stay within the image's recorded budget. The
+// timed runs start after --warmup untimed passes over the corpus's first image,
+// so configuration and cold caches are not charged to whichever image is first. The
+// mean of the medians is checked against the aggregate budget. With --record,
+// the golden file is rewritten from the current run instead, and budgets are
+// set to the measured latency times --headroom.
+//
+// --cpu runs the int8 CPU engine instead of the device. A golden file recorded
+// with it on any machine is a numeric reference for checking a device's top-5
+// (use a looser --tolerance, and skip the CPU latency budgets with --headroom 0).
+//
+// Golden file format, one entry per line ('#' starts a comment):
+//   aggregate <budget_ms>
+//   <image_path> <budget_ms> <class_id>:<confidence> ... (best first)
+
+namespace
+{
+struct GoldenEntry
+{
+    double budget_ms = 0.0;
+    std::vector<std::pair<int, float>> top_k;
+};
+
+struct Golden
+{
+    double aggregate_budget_ms = 0.0;
+    std::map<std::string, GoldenEntry> images;
+};
+
+struct Measurement
+{
+    double median_ms = 0.0;
+    InceptionV3Result result;
+};
+
+void print_usage(const char *program)
+{
+    std::cerr << "Usage: " << program << " (--hef <hef_path> | --simulate | --cpu <weights.iv3w>) --golden <golden_file>"
+              << std::endl
+              << "       [--record] [--tolerance 0.05] [--repeat 5] [--warmup 3] [--headroom 1.5] [image_or_dir...]"
+              << std::endl
+              << "Default corpus: images/ processed_images/" << std::endl;
+}
+
+bool is_jpeg(const std::string &name)
+{
+    auto dot = name.rfind('.');
+    if (dot == std::string::npos) {
+        return false;
+    }
+    std::string extension = name.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == "jpg" || extension == "jpeg";
+}
+
+void collect_images(const std::string &path, std::vector<std::string> &images)
+{
+    DIR *dir = opendir(path.c_str());
+    if (dir == nullptr) {
+        images.push_back(path);
+        return;
+    }
+
+    std::vector<std::string> found;
+    while (dirent *entry = readdir(dir)) {
+        if (is_jpeg(entry->d_name)) {
+            found.push_back(path + "/" + entry->d_name);
+        }
+    }
+    closedir(dir);
+    std::sort(found.begin(), found.end());
+    images.insert(images.end(), found.begin(), found.end());
+}
+
+Golden read_golden(const std::string &path)
+{
+    Golden golden;
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("cannot open golden file " + path + " (create it with --record)");
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string key;
+        if (!(fields >> key)) {
+            continue;
+        }
+        if (key == "aggregate") {
+            fields >> golden.aggregate_budget_ms;
+            continue;
+        }
+
+        GoldenEntry entry;
+        fields >> entry.budget_ms;
+        std::string pair;
+        while (fields >> pair) {
+            auto colon = pair.find(':');
+            if (colon == std::string::npos) {
+                throw std::runtime_error("malformed golden entry for " + key + ": " + pair);
+            }
+            entry.top_k.emplace_back(std::stoi(pair.substr(0, colon)), std::stof(pair.substr(colon + 1)));
+        }
+        golden.images[key] = entry;
+    }
+    return golden;
+}
+
+void write_golden(const std::string &path, const std::vector<std::string> &images,
+                  const std::vector<Measurement> &measurements, double headroom)
+{
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error("cannot write golden file " + path);
+    }
+
+    double total_ms = 0.0;
+    for (auto &measurement : measurements) {
+        total_ms += measurement.median_ms;
+    }
+    file << "# Recorded by inception_v3_golden --record; budgets include x" << headroom << " headroom\n";
+    file << std::fixed << std::setprecision(3);
+    file << "aggregate " << headroom * total_ms / std::max<size_t>(measurements.size(), 1) << "\n";
+    for (size_t i = 0; i < images.size(); i++) {
+        file << images[i] << ' ' << headroom * measurements[i].median_ms;
+        const auto &result = measurements[i].result;
+        for (size_t k = 0; k < result.top_k_count; k++) {
+            file << ' ' << result.top_k_ids[k] << ':' << std::setprecision(4) << result.top_k_confidences[k]
+                 << std::setprecision(3);
+        }
+        file << "\n";
+    }
+}
+
+// Ranks may swap between classes whose confidences are within tolerance of each
+// other, and a golden class may fall out of the top-K when it sat within
+// tolerance of the cut-off. Anything else is a mismatch.
+std::string compare_top_k(const GoldenEntry &golden, const InceptionV3Result &result, float tolerance)
+{
+    if (golden.top_k.empty()) {
+        return "";
+    }
+
+    std::ostringstream errors;
+    float cutoff = result.top_k_count > 0 ? result.top_k_confidences[result.top_k_count - 1] : 0.0f;
+
+    for (auto &expected : golden.top_k) {
+        size_t k = 0;
+        while (k < result.top_k_count && result.top_k_ids[k] != expected.first) {
+            k++;
+        }
+        if (k == result.top_k_count) {
+            if (expected.second > cutoff + tolerance) {
+                errors << " class " << expected.first << " (" << expected.second << ") missing from top-K;";
+            }
+            continue;
+        }
+        if (std::fabs(result.top_k_confidences[k] - expected.second) > tolerance) {
+            errors << " class " << expected.first << " confidence " << result.top_k_confidences[k] << " vs "
+                   << expected.second << ";";
+        }
+    }
+
+    int expected_top1 = golden.top_k[0].first;
+    bool top1_tied = golden.top_k.size() > 1 && golden.top_k[0].second - golden.top_k[1].second <= tolerance;
+    if (result.top_k_count == 0 || (result.top_k_ids[0] != expected_top1 && !top1_tied)) {
+        errors << " top-1 " << (result.top_k_count ? result.top_k_ids[0] : -1) << " vs " << expected_top1 << ";";
+    }
+    return errors.str();
+}
+}
+
+int main(int argc, char *argv[])
+{
+    std::string hef_path;
+    std::string cpu_weights;
+    std::string golden_path;
+    bool simulate = false;
+    bool record = false;
+    float tolerance = 0.05f;
+    size_t repeat = 5;
+    size_t warmup = 3;
+    double headroom = 1.5;
+    std::vector<std::string> inputs;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            bool has_value = i + 1 < argc;
+            if (arg == "--hef" && has_value) {
+                hef_path = argv[++i];
+            } else if (arg == "--cpu" && has_value) {
+                cpu_weights = argv[++i];
+            } else if (arg == "--simulate") {
+                simulate = true;
+            } else if (arg == "--golden" && has_value) {
+                golden_path = argv[++i];
+            } else if (arg == "--record") {
+                record = true;
+            } else if (arg == "--tolerance" && has_value) {
+                tolerance = std::stof(argv[++i]);
+            } else if (arg == "--repeat" && has_value) {
+                repeat = std::max<size_t>(std::stoul(argv[++i]), 1);
+            } else if (arg == "--warmup" && has_value) {
+                warmup = std::stoul(argv[++i]);
+            } else if (arg == "--headroom" && has_value) {
+                headroom = std::stod(argv[++i]);
+            } else if (arg.compare(0, 2, "--") == 0) {
+                print_usage(argv[0]);
+                return 1;
+            } else {
+                inputs.push_back(arg);
+            }
+        }
+
+        if (golden_path.empty() || (hef_path.empty() && cpu_weights.empty() && !simulate)) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        if (inputs.empty()) {
+            inputs = {"images", "processed_images"};
+        }
+
+        std::vector<std::string> images;
+        for (auto &input : inputs) {
+            collect_images(input, images);
+        }
+
+        auto params = init_inception_v3("./imagenet_classes.txt", 0.5f);
+        std::unique_ptr<InceptionV3Backend> backend;
+        if (simulate) {
+            backend.reset(new InceptionV3SimulatedBackend());
+        } else if (!cpu_weights.empty()) {
+            backend.reset(new InceptionV3CpuBackend(cpu_weights));
+        } else {
+            backend.reset(new InceptionV3HailoBackend(hef_path));
+        }
+        InceptionV3Runner runner(std::move(backend), params);
+        auto input_info = runner.backend().input_info();
+
+        std::vector<uint8_t> tensor(runner.input_frame_size());
+        InceptionV3Frame scratch;
+        std::vector<Measurement> measurements;
+        std::vector<double> samples;
+
+        for (size_t r = 0; r < warmup && !images.empty(); r++) {
+            load_image_tensor(images[0], input_info.shape.width, input_info.shape.height, tensor.data(), scratch);
+            runner.classify(tensor.data());
+        }
+
+        for (auto &image : images) {
+            Measurement measurement;
+            samples.clear();
+            for (size_t r = 0; r < repeat; r++) {
+                auto start = std::chrono::steady_clock::now();
+                load_image_tensor(image, input_info.shape.width, input_info.shape.height, tensor.data(), scratch);
+                measurement.result = runner.classify(tensor.data());
+                samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            }
+            std::sort(samples.begin(), samples.end());
+            measurement.median_ms = samples[samples.size() / 2];
+            measurements.push_back(measurement);
+        }
+
+        if (record) {
+            write_golden(golden_path, images, measurements, headroom);
+            std::cout << "Recorded " << images.size() << " images to " << golden_path << std::endl;
+            free_resources(params);
+            return 0;
+        }
+
+        Golden golden = read_golden(golden_path);
+        size_t failures = 0;
+        double total_ms = 0.0;
+        for (size_t i = 0; i < images.size(); i++) {
+            const auto &measurement = measurements[i];
+            total_ms += measurement.median_ms;
+
+            auto it = golden.images.find(images[i]);
+            if (it == golden.images.end()) {
+                std::cout << "FAIL " << images[i] << ": no golden entry" << std::endl;
+                failures++;
+                continue;
+            }
+
+            std::string errors = compare_top_k(it->second, measurement.result, tolerance);
+            if (it->second.budget_ms > 0.0 && measurement.median_ms > it->second.budget_ms) {
+                std::ostringstream latency;
+                latency << " latency " << measurement.median_ms << " ms over budget " << it->second.budget_ms << " ms;";
+                errors += latency.str();
+            }
+
+            std::cout << (errors.empty() ? "PASS " : "FAIL ") << images[i] << " (" << measurement.median_ms << " ms)"
+                      << errors << std::endl;
+            failures += errors.empty() ? 0 : 1;
+        }
+
+        double mean_ms = images.empty() ? 0.0 : total_ms / images.size();
+        bool aggregate_ok = golden.aggregate_budget_ms <= 0.0 || mean_ms <= golden.aggregate_budget_ms;
+        std::cout << (aggregate_ok ? "PASS " : "FAIL ") << "aggregate mean " << mean_ms << " ms (budget "
+                  << golden.aggregate_budget_ms << " ms)" << std::endl;
+        failures += aggregate_ok ? 0 : 1;
+
+        free_resources(params);
+        return failures == 0 ? 0 : 1;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -1,4 +1,5 @@
 #include "inception_v3_hailortpp.hpp"
+#include "inception_v3_kernels.hpp"
 #include <fstream>
 #include <algorithm>
 #include <iostream>
@@ -50,6 +51,17 @@ void postprocess_inception_v3(HailoROIPtr roi, void *params_void_ptr)
     auto output_tensor = roi->get_tensor("inception-v3/fc1");
     
     auto *output_data = output_tensor->data();
+
+    if (!params->score_thresholds.empty())
+    {
+        int best = best_eligible_class_inception_v3(output_data, std::min<size_t>(1000, params->score_thresholds.size()),
+                                                    *params);
+        if (best >= 0)
+        {
+            roi->add_object(HailoClassification(params->labels[best], output_data[best] / 255.0f));
+        }
+        return;
+    }
     
     int max_index = std::distance(output_data, std::max_element(output_data, output_data + 1000));
     
@@ -64,4 +76,71 @@ void postprocess_inception_v3(HailoROIPtr roi, void *params_void_ptr)
         
         roi->add_object(classification);
     }
-}
\ No newline at end of file
+}
+
+void compile_inception_v3_filters(InceptionV3Params &params, size_t class_count,
+                                  const std::vector<float> &class_thresholds, const std::vector<bool> &allowed)
+{
+    params.score_thresholds.assign(class_count, INCEPTION_V3_CLASS_DISABLED);
+    params.class_mask.assign((class_count + 63) / 64, 0);
+    params.eligible_classes = 0;
+
+    for (size_t i = 0; i < class_count; i++)
+    {
+        if (i < allowed.size() && !allowed[i])
+        {
+            continue;
+        }
+        float threshold = i < class_thresholds.size() && class_thresholds[i] >= 0.0f ? class_thresholds[i]
+                                                                                      : params.confidence_threshold;
+
+        // Smallest score that passes the same float comparison as the unfiltered path.
+        uint16_t score = 0;
+        while (score < 256 && score / 255.0f < threshold)
+        {
+            score++;
+        }
+        params.score_thresholds[i] = score;
+        if (score < INCEPTION_V3_CLASS_DISABLED)
+        {
+            params.class_mask[i / 64] |= 1ull << (i % 64);
+            params.eligible_classes++;
+        }
+    }
+}
+
+int best_eligible_class_inception_v3(const uint8_t *scores, size_t count, const InceptionV3Params &params)
+{
+    const uint16_t *thresholds = params.score_thresholds.data();
+
+    // Few allowed classes: visit only their bits.
+    if (params.eligible_classes <= INCEPTION_V3_SPARSE_CLASSES)
+    {
+        int best = -1;
+        for (size_t word = 0; word < params.class_mask.size(); word++)
+        {
+            for (uint64_t bits = params.class_mask[word]; bits != 0; bits &= bits - 1)
+            {
+                size_t i = word * 64 + __builtin_ctzll(bits);
+                if (i < count && scores[i] >= thresholds[i] && (best < 0 || scores[i] > scores[best]))
+                {
+                    best = static_cast<int>(i);
+                }
+            }
+        }
+        return best;
+    }
+
+    // Dense pass: the branch-free argmax, built for the best ISA this CPU runs.
+    return inception_v3_kernels().argmax_eligible_u8(scores, thresholds, std::min<size_t>(count, 0xFFFF));
+}
+
+size_t top_k_inception_v3(const uint8_t *scores, size_t count, size_t k, int *class_ids, float *confidences)
+{
+    size_t filled = inception_v3_kernels().top_k_u8(scores, count, k, class_ids);
+    for (size_t i = 0; i < filled; i++)
+    {
+        confidences[i] = scores[class_ids[i]] / 255.0f;
+    }
+    return filled;
+}
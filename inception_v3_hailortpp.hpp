@@ -3,6 +3,13 @@
 #include "hailo_common.hpp"
 #include <vector>
 #include <string>
+#include <cstddef>
+#include <cstdint>
+
+#define INCEPTION_V3_TOP_K 5
+#define INCEPTION_V3_CLASS_DISABLED 0x100
+// Allow-lists up to this size are scanned bit by bit instead of over every class.
+#define INCEPTION_V3_SPARSE_CLASSES 64
 
 __BEGIN_DECLS
 
@@ -12,13 +19,30 @@ public:
     std::vector<std::string> labels;
     float confidence_threshold;
 
+    // Per-class filtering, filled by compile_inception_v3_filters(). Empty means the
+    // plain argmax against confidence_threshold.
+    std::vector<uint16_t> score_thresholds; // minimum uint8 score per class, INCEPTION_V3_CLASS_DISABLED if filtered out
+    std::vector<uint64_t> class_mask;       // bit per class allowed to be reported
+    size_t eligible_classes = 0;             // popcount of class_mask
+
     InceptionV3Params(const std::string &labels_file = "./imagenet_classes.txt",
                       float confidence_threshold = 0.5f);
+    // free_resources() also frees params that carry more state (the hailofilter's).
+    virtual ~InceptionV3Params() = default;
 };
 
 InceptionV3Params *init_inception_v3(const std::string &labels_file, float confidence_threshold);
 void free_resources(void *params_void_ptr);
 void preprocess_inception_v3(HailoROIPtr roi);
 void postprocess_inception_v3(HailoROIPtr roi, void *params_void_ptr);
+// Builds score_thresholds and class_mask for class_count classes. class_thresholds
+// holds one confidence per class (negative: use confidence_threshold), allowed one
+// flag per class.
+void compile_inception_v3_filters(InceptionV3Params &params, size_t class_count,
+                                  const std::vector<float> &class_thresholds, const std::vector<bool> &allowed);
+// Highest-scoring class whose score reaches its threshold, ties to the lowest id; -1 if none.
+int best_eligible_class_inception_v3(const uint8_t *scores, size_t count, const InceptionV3Params &params);
+// Writes the k highest scores (best first) as class ids and confidences; returns how many were written.
+size_t top_k_inception_v3(const uint8_t *scores, size_t count, size_t k, int *class_ids, float *confidences);
 
 __END_DECLS
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "inception_v3_image.hpp"
+#include "inception_v3_kernels.hpp"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+// 8-bit fixed-point source coordinate for each destination column or row,
+// sampling at pixel centers.
+std::vector<InceptionV3ResizeTap> make_samples(uint32_t src_size, uint32_t dst_size)
+{
+    std::vector<InceptionV3ResizeTap> samples(dst_size);
+    const uint64_t scale = (static_cast<uint64_t>(src_size) << 16) / dst_size;
+    for (uint32_t i = 0; i < dst_size; i++) {
+        int64_t position = static_cast<int64_t>((i * scale) + scale / 2) - (1 << 15);
+        position = std::max<int64_t>(position, 0);
+        uint32_t index0 = static_cast<uint32_t>(position >> 16);
+        index0 = std::min(index0, src_size - 1);
+        samples[i].index0 = index0;
+        samples[i].index1 = std::min(index0 + 1, src_size - 1);
+        samples[i].weight1 = static_cast<uint32_t>((position >> 8) & 0xff);
+    }
+    return samples;
+}
+}
+
+size_t inception_v3_frame_bytes(InceptionV3PixelFormat format, uint32_t width, uint32_t height)
+{
+    switch (format) {
+    case INCEPTION_V3_FORMAT_NV12:
+        return static_cast<size_t>(width) * height * 3 / 2;
+    case INCEPTION_V3_FORMAT_RGB:
+    default:
+        return static_cast<size_t>(width) * height * 3;
+    }
+}
+
+bool parse_inception_v3_pixel_format(const std::string &name, InceptionV3PixelFormat &format)
+{
+    if (name == "RGB") {
+        format = INCEPTION_V3_FORMAT_RGB;
+        return true;
+    }
+    if (name == "NV12") {
+        format = INCEPTION_V3_FORMAT_NV12;
+        return true;
+    }
+    return false;
+}
+
+const char *inception_v3_pixel_format_name(InceptionV3PixelFormat format)
+{
+    return format == INCEPTION_V3_FORMAT_NV12 ? "NV12" : "RGB";
+}
+
+void resize_rgb_bilinear(const uint8_t *src, uint32_t src_width, uint32_t src_height, size_t src_stride,
+                         uint8_t *dst, uint32_t dst_width, uint32_t dst_height)
+{
+    const auto xs = make_samples(src_width, dst_width);
+    const auto ys = make_samples(src_height, dst_height);
+
+    const auto resize_row = inception_v3_kernels().resize_rgb_row;
+
+    for (uint32_t y = 0; y < dst_height; y++) {
+        resize_row(src + ys[y].index0 * src_stride, src + ys[y].index1 * src_stride, ys[y].weight1, xs.data(),
+                   dst_width, dst + static_cast<size_t>(y) * dst_width * 3);
+    }
+}
+
+void nv12_to_rgb_resize(const uint8_t *y_plane, const uint8_t *uv_plane, uint32_t src_width, uint32_t src_height,
+                        size_t stride, uint8_t *dst, uint32_t dst_width, uint32_t dst_height)
+{
+    const auto xs = make_samples(src_width, dst_width);
+    const auto ys = make_samples(src_height, dst_height);
+
+    const auto convert_row = inception_v3_kernels().nv12_rgb_row;
+
+    for (uint32_t y = 0; y < dst_height; y++) {
+        convert_row(y_plane + ys[y].index0 * stride, y_plane + ys[y].index1 * stride,
+                    uv_plane + (ys[y].index0 / 2) * stride, ys[y].weight1, xs.data(), dst_width,
+                    dst + static_cast<size_t>(y) * dst_width * 3);
+    }
+}
+
+void resize_frame_to_rgb(const uint8_t *src, InceptionV3PixelFormat format, uint32_t src_width, uint32_t src_height,
+                         uint8_t *dst, uint32_t dst_width, uint32_t dst_height)
+{
+    if (format == INCEPTION_V3_FORMAT_NV12) {
+        nv12_to_rgb_resize(src, src + static_cast<size_t>(src_width) * src_height, src_width, src_height, src_width,
+                           dst, dst_width, dst_height);
+        return;
+    }
+    if (src_width == dst_width && src_height == dst_height) {
+        // Already a network-sized tensor (e.g. a replayed recording); pass it through bit-exact.
+        std::memcpy(dst, src, static_cast<size_t>(dst_width) * dst_height * 3);
+        return;
+    }
+    resize_rgb_bilinear(src, src_width, src_height, static_cast<size_t>(src_width) * 3, dst, dst_width, dst_height);
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+enum InceptionV3PixelFormat
+{
+    INCEPTION_V3_FORMAT_RGB,
+    INCEPTION_V3_FORMAT_NV12,
+};
+
+size_t inception_v3_frame_bytes(InceptionV3PixelFormat format, uint32_t width, uint32_t height);
+bool parse_inception_v3_pixel_format(const std::string &name, InceptionV3PixelFormat &format);
+const char *inception_v3_pixel_format_name(InceptionV3PixelFormat format);
+
+// Bilinear resize between packed RGB images; src_stride is in bytes.
+void resize_rgb_bilinear(const uint8_t *src, uint32_t src_width, uint32_t src_height, size_t src_stride,
+                         uint8_t *dst, uint32_t dst_width, uint32_t dst_height);
+
+// NV12 (BT.601, limited range) to packed RGB fused with the resize, so the
+// full-resolution RGB frame is never materialized. stride applies to both planes.
+void nv12_to_rgb_resize(const uint8_t *y_plane, const uint8_t *uv_plane, uint32_t src_width, uint32_t src_height,
+                        size_t stride, uint8_t *dst, uint32_t dst_width, uint32_t dst_height);
+
+// Resizes (and converts) a whole source frame of the given format into a packed RGB tensor.
+void resize_frame_to_rgb(const uint8_t *src, InceptionV3PixelFormat format, uint32_t src_width, uint32_t src_height,
+                         uint8_t *dst, uint32_t dst_width, uint32_t dst_height);
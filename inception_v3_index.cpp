@@ -0,0 +1,180 @@
+#include "inception_v3_embedding.hpp"
+#include "inception_v3_jpeg.hpp"
+#include "inception_v3_runner.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <sys/stat.h>
+
+// "Find similar frames" on the box: embeds images through the network into an
+// int8 index file, optionally partitions it (IVF) and answers nearest-neighbour
+// queries. Image paths are kept next to the index in <index>.paths, one per id.
+
+namespace
+{
+void print_usage(const char *program)
+{
+    std::cerr << "Usage: " << program << " [--hef <hef_path> | --simulate] <index_file> add <image.jpg>..." << std::endl
+              << "       " << program << " [--hef <hef_path> | --simulate] <index_file> query <image.jpg> [k=5] [nprobe=4]"
+              << std::endl
+              << "       " << program << " <index_file> train <nlist> [iterations=10]" << std::endl;
+}
+
+bool file_exists(const std::string &path)
+{
+    struct stat info;
+    return stat(path.c_str(), &info) == 0;
+}
+
+std::vector<std::string> read_paths(const std::string &path)
+{
+    std::vector<std::string> paths;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        paths.push_back(line);
+    }
+    return paths;
+}
+
+void write_paths(const std::string &path, const std::vector<std::string> &paths)
+{
+    std::ofstream file(path, std::ios::trunc);
+    for (const auto &line : paths) {
+        file << line << '\n';
+    }
+    file.close();
+    if (!file) {
+        std::remove(path.c_str());
+        throw std::runtime_error("cannot write " + path);
+    }
+}
+
+// Runs one image through the network and embeds its fc1 output.
+class Embedder
+{
+public:
+    Embedder(const std::string &hef_path, bool simulate)
+        : m_params(init_inception_v3("./imagenet_classes.txt", 0.5f), free_resources),
+          m_runner(simulate ? std::unique_ptr<InceptionV3Backend>(new InceptionV3SimulatedBackend())
+                            : std::unique_ptr<InceptionV3Backend>(new InceptionV3HailoBackend(hef_path)),
+                   m_params.get()),
+          m_tensor(m_runner.input_frame_size())
+    {}
+
+    InceptionV3Embedding embed(const std::string &image)
+    {
+        auto input_info = m_runner.backend().input_info();
+        load_image_tensor(image, input_info.shape.width, input_info.shape.height, m_tensor.data(), m_scratch);
+        m_runner.classify(m_tensor.data());
+
+        InceptionV3Embedding embedding;
+        make_inception_v3_embedding(m_runner.last_output(0), dims(), m_runner.backend().output_info().quant_info,
+                                    embedding);
+        return embedding;
+    }
+
+    size_t dims() const { return m_runner.output_frame_size(); }
+
+private:
+    std::unique_ptr<InceptionV3Params, void (*)(void *)> m_params;
+    InceptionV3Runner m_runner;
+    std::vector<uint8_t> m_tensor;
+    InceptionV3Frame m_scratch;
+};
+} // namespace
+
+int main(int argc, char **argv)
+{
+    try {
+        std::string hef_path;
+        bool simulate = false;
+        int arg = 1;
+        for (; arg < argc; arg++) {
+            std::string option = argv[arg];
+            if (option == "--hef" && arg + 1 < argc) {
+                hef_path = argv[++arg];
+            } else if (option == "--simulate") {
+                simulate = true;
+            } else {
+                break;
+            }
+        }
+        if (argc - arg < 2) {
+            print_usage(argv[0]);
+            return 1;
+        }
+
+        const std::string index_path = argv[arg];
+        const std::string paths_path = index_path + ".paths";
+        const std::string command = argv[arg + 1];
+        char **values = argv + arg + 2;
+        const int value_count = argc - arg - 2;
+
+        if (command == "train") {
+            if (value_count < 1) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            InceptionV3EmbeddingIndex index;
+            index.load(index_path);
+            index.train(std::stoul(values[0]), value_count > 1 ? std::stoul(values[1]) : 10);
+            index.save(index_path);
+            std::cout << "Partitioned " << index.size() << " embeddings into " << index.lists() << " lists" << std::endl;
+            return 0;
+        }
+
+        if ((command != "add" && command != "query") || value_count < 1 || (hef_path.empty() && !simulate)) {
+            print_usage(argv[0]);
+            return 1;
+        }
+
+        Embedder embedder(hef_path, simulate);
+        InceptionV3EmbeddingIndex index(embedder.dims());
+        if (file_exists(index_path)) {
+            index.load(index_path);
+        }
+        std::vector<std::string> paths = read_paths(paths_path);
+
+        if (command == "add") {
+            // Ids are line numbers in the paths file. Rows saved without their paths
+            // (a crash between the two renames below) keep their ids, with no path.
+            if (paths.size() < index.size()) {
+                paths.resize(index.size());
+            }
+            for (int i = 0; i < value_count; i++) {
+                index.add(paths.size(), embedder.embed(values[i]));
+                paths.push_back(values[i]);
+            }
+
+            // Both files are replaced only once the index saved, so a failed add
+            // leaves neither with entries the other lacks.
+            write_paths(paths_path + ".tmp", paths);
+            try {
+                index.save(index_path);
+            } catch (...) {
+                std::remove((paths_path + ".tmp").c_str());
+                throw;
+            }
+            if (std::rename((paths_path + ".tmp").c_str(), paths_path.c_str()) != 0) {
+                throw std::runtime_error("cannot replace " + paths_path);
+            }
+            std::cout << "Index holds " << index.size() << " embeddings" << std::endl;
+            return 0;
+        }
+
+        size_t k = value_count > 1 ? std::stoul(values[1]) : 5;
+        size_t nprobe = value_count > 2 ? std::stoul(values[2]) : 4;
+        for (const auto &match : index.search(embedder.embed(values[0]), k, nprobe)) {
+            std::cout << match.similarity << ' ' << (match.id < paths.size() ? paths[match.id] : std::to_string(match.id))
+                      << '\n';
+        }
+
+    } catch (const std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
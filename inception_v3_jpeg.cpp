@@ -0,0 +1,96 @@
+#include "inception_v3_jpeg.hpp"
+#include <csetjmp>
+#include <cstdio>
+#include <jpeglib.h>
+#include <stdexcept>
+
+namespace
+{
+// libjpeg reports fatal errors through error_exit, which must not return.
+// Jump back to decode_jpeg_file and turn the message into an exception there,
+// after libjpeg's own frames are gone.
+struct JpegErrorManager
+{
+    jpeg_error_mgr base;
+    std::jmp_buf jump;
+    char message[JMSG_LENGTH_MAX];
+};
+
+void jpeg_error_exit(j_common_ptr cinfo)
+{
+    auto *errors = reinterpret_cast<JpegErrorManager *>(cinfo->err);
+    (*cinfo->err->format_message)(cinfo, errors->message);
+    std::longjmp(errors->jump, 1);
+}
+
+struct FileCloser
+{
+    FILE *file;
+    ~FileCloser()
+    {
+        if (file != nullptr) {
+            fclose(file);
+        }
+    }
+};
+}
+
+void decode_jpeg_file(const std::string &path, InceptionV3Frame &frame, uint32_t min_width, uint32_t min_height)
+{
+    FileCloser input = {fopen(path.c_str(), "rb")};
+    if (input.file == nullptr) {
+        throw std::runtime_error("cannot open " + path);
+    }
+
+    jpeg_decompress_struct cinfo;
+    JpegErrorManager errors;
+    cinfo.err = jpeg_std_error(&errors.base);
+    errors.base.error_exit = jpeg_error_exit;
+
+    if (setjmp(errors.jump)) {
+        jpeg_destroy_decompress(&cinfo);
+        throw std::runtime_error("cannot decode " + path + ": " + errors.message);
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_stdio_src(&cinfo, input.file);
+    jpeg_read_header(&cinfo, TRUE);
+    cinfo.out_color_space = JCS_RGB;
+
+    // Coarsest scale first; fall back to full size if even 1/2 is too small.
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = 1;
+    if (min_width > 0 || min_height > 0) {
+        for (unsigned int denom = 8; denom > 1; denom /= 2) {
+            cinfo.scale_denom = denom;
+            jpeg_calc_output_dimensions(&cinfo);
+            if (cinfo.output_width >= min_width && cinfo.output_height >= min_height) {
+                break;
+            }
+            cinfo.scale_denom = 1;
+        }
+    }
+    jpeg_start_decompress(&cinfo);
+
+    const size_t row_bytes = static_cast<size_t>(cinfo.output_width) * 3;
+    frame.data.resize(row_bytes * cinfo.output_height);
+    while (cinfo.output_scanline < cinfo.output_height) {
+        JSAMPROW row = &frame.data[cinfo.output_scanline * row_bytes];
+        jpeg_read_scanlines(&cinfo, &row, 1);
+    }
+
+    frame.width = cinfo.output_width;
+    frame.height = cinfo.output_height;
+    frame.format = INCEPTION_V3_FORMAT_RGB;
+    frame.capture_time_ns = inception_v3_now_ns();
+
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+}
+
+void load_image_tensor(const std::string &path, uint32_t width, uint32_t height, uint8_t *tensor,
+                       InceptionV3Frame &scratch)
+{
+    decode_jpeg_file(path, scratch, width, height);
+    resize_frame_to_rgb(scratch.data.data(), scratch.format, scratch.width, scratch.height, tensor, width, height);
+}
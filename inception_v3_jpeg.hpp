@@ -0,0 +1,17 @@
+#pragma once
+#include "inception_v3_source.hpp"
+#include <string>
+
+// Decodes a JPEG file into a packed RGB frame (grayscale input is expanded).
+// With a minimum size, libjpeg scales in the DCT domain (1/2, 1/4 or 1/8) to the
+// smallest output still at least min_width x min_height, which skips most of the
+// IDCT and colour conversion work on large images.
+// Throws std::runtime_error if the file cannot be read or decoded.
+void decode_jpeg_file(const std::string &path, InceptionV3Frame &frame, uint32_t min_width = 0,
+                      uint32_t min_height = 0);
+
+// Decodes a JPEG file at the smallest DCT scale that covers width x height and
+// resizes the rest of the way into a packed RGB tensor of width x height.
+// scratch holds the decoded image so its buffer can be reused across calls.
+void load_image_tensor(const std::string &path, uint32_t width, uint32_t height, uint8_t *tensor,
+                       InceptionV3Frame &scratch);
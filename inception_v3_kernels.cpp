@@ -0,0 +1,107 @@
+#include "inception_v3_kernels.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#if defined(__aarch64__)
+#include <sys/auxv.h>
+#endif
+
+// One per inception_v3_kernels_<isa>.cpp.
+InceptionV3Kernels inception_v3_scalar_kernels();
+InceptionV3Kernels inception_v3_baseline_kernels();
+#if defined(__x86_64__)
+InceptionV3Kernels inception_v3_avx2_kernels();
+InceptionV3Kernels inception_v3_avx512_kernels();
+#elif defined(__aarch64__)
+InceptionV3Kernels inception_v3_dotprod_kernels();
+#endif
+
+namespace
+{
+// Best first; the baseline and scalar builds run everywhere.
+std::vector<InceptionV3Kernels> detect_kernels()
+{
+    std::vector<InceptionV3Kernels> kernels;
+#if defined(__x86_64__)
+    // __builtin_cpu_supports also checks that the OS saves the wider registers.
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+        __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx512dq")) {
+        kernels.push_back(inception_v3_avx512_kernels());
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        kernels.push_back(inception_v3_avx2_kernels());
+    }
+#elif defined(__aarch64__) && defined(HWCAP_ASIMDDP)
+    if (getauxval(AT_HWCAP) & HWCAP_ASIMDDP) {
+        kernels.push_back(inception_v3_dotprod_kernels());
+    }
+#endif
+    kernels.push_back(inception_v3_baseline_kernels());
+    kernels.push_back(inception_v3_scalar_kernels());
+    return kernels;
+}
+
+const std::vector<InceptionV3Kernels> &supported_kernels()
+{
+    static const std::vector<InceptionV3Kernels> kernels = detect_kernels();
+    return kernels;
+}
+
+const InceptionV3Kernels *find_kernels(const std::string &isa)
+{
+    for (const auto &kernels : supported_kernels()) {
+        if (isa == kernels.isa) {
+            return &kernels;
+        }
+    }
+    return nullptr;
+}
+
+// The best supported set, or the one INCEPTION_V3_ISA asks for.
+const InceptionV3Kernels *default_kernels()
+{
+    const char *isa = std::getenv("INCEPTION_V3_ISA");
+    if (isa && *isa) {
+        if (const InceptionV3Kernels *kernels = find_kernels(isa)) {
+            return kernels;
+        }
+        std::cerr << "INCEPTION_V3_ISA=" << isa << " is not supported on this CPU, using "
+                  << supported_kernels().front().isa << std::endl;
+    }
+    return &supported_kernels().front();
+}
+
+std::atomic<const InceptionV3Kernels *> g_active(nullptr);
+} // namespace
+
+const InceptionV3Kernels &inception_v3_kernels()
+{
+    const InceptionV3Kernels *kernels = g_active.load(std::memory_order_acquire);
+    if (kernels == nullptr) {
+        static const InceptionV3Kernels *selected = default_kernels();
+        const InceptionV3Kernels *expected = nullptr;
+        g_active.compare_exchange_strong(expected, selected, std::memory_order_acq_rel);
+        kernels = g_active.load(std::memory_order_acquire);
+    }
+    return *kernels;
+}
+
+std::vector<std::string> inception_v3_isas()
+{
+    std::vector<std::string> isas;
+    for (const auto &kernels : supported_kernels()) {
+        isas.push_back(kernels.isa);
+    }
+    return isas;
+}
+
+bool inception_v3_use_isa(const std::string &isa)
+{
+    const InceptionV3Kernels *kernels = find_kernels(isa);
+    if (kernels == nullptr) {
+        return false;
+    }
+    g_active.store(kernels, std::memory_order_release);
+    return true;
+}
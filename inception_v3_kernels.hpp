@@ -0,0 +1,75 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Host-side kernels, compiled once per instruction set and picked at startup.
+//
+// Each kernel is written once, as plain loops the compiler vectorizes, in
+// inception_v3_kernels_impl.hpp. Every inception_v3_kernels_<isa>.cpp compiles
+// that file with its own target flags (see CMakeLists.txt):
+//   x86-64:  avx512 (F/BW/VL/DQ), avx2 (+FMA), sse2 (the x86-64 baseline)
+//   AArch64: dotprod (ARMv8.2 SDOT), neon (the AArch64 baseline)
+//   any:     scalar, with vectorization disabled, as the reference
+// The best set the CPU supports is used unless INCEPTION_V3_ISA names another
+// (or inception_v3_use_isa() is called), so one build serves every host.
+
+struct InceptionV3ResizeTap
+{
+    uint32_t index0;
+    uint32_t index1;
+    uint32_t weight1;   // 0..256, weight of index1
+};
+
+struct InceptionV3Kernels
+{
+    const char *isa;
+
+    // Ids of the k best uint8 scores, best first, lower id first on ties. Returns min(k, count).
+    size_t (*top_k_u8)(const uint8_t *scores, size_t count, size_t k, int *class_ids);
+
+    // Best class whose score reaches its threshold, lower id first on ties; -1 when none does.
+    // count must be below 0x10000.
+    int (*argmax_eligible_u8)(const uint8_t *scores, const uint16_t *thresholds, size_t count);
+
+    // One destination row of the bilinear resizes: RGB rows, or NV12 luma rows
+    // plus their chroma row (BT.601 limited range) converted to RGB.
+    void (*resize_rgb_row)(const uint8_t *row0, const uint8_t *row1, uint32_t weight1,
+                           const InceptionV3ResizeTap *xs, uint32_t width, uint8_t *out);
+    void (*nv12_rgb_row)(const uint8_t *row0, const uint8_t *row1, const uint8_t *uv_row, uint32_t weight1,
+                         const InceptionV3ResizeTap *xs, uint32_t width, uint8_t *out);
+
+    // values = exp(values - max) / sum, in place.
+    void (*softmax_f32)(float *values, size_t count);
+
+    // Dot products of int16 vectors holding 8-bit values (exact in 32 bits); the
+    // 1x4 form shares one row of a against four rows of w, stride elements apart.
+    int32_t (*dot_i16)(const int16_t *a, const int16_t *w, size_t depth);
+    void (*dot_i16_1x4)(const int16_t *a, const int16_t *w, size_t stride, size_t depth, int32_t sums[4]);
+
+    int32_t (*dot_i8)(const int8_t *a, const int8_t *b, size_t count);
+
+    // Temporal smoothing of one frame of scores, each returning the argmax of the
+    // updated values (lowest id first on ties). The EMA moves Q8.8 values by
+    // alpha / 256; the window form adds scores, subtracts oldest & keep (0 until
+    // the window is full, 0xff after) and stores scores into oldest.
+    int (*ema_update_u8)(uint16_t *smoothed, const uint8_t *scores, uint32_t count, int32_t alpha);
+    int (*window_update_u8)(uint16_t *smoothed, uint8_t *oldest, const uint8_t *scores, uint32_t count,
+                            uint32_t keep);
+
+    // Overlay blits: row = (row * (256 - alpha) + value * alpha) >> 8, and
+    // row = mask ? value : row with mask bytes 0x00 or 0xff.
+    void (*shade_row)(uint8_t *row, uint32_t bytes, uint32_t alpha, uint8_t value);
+    void (*stamp_row)(uint8_t *row, const uint8_t *mask, uint32_t bytes, uint8_t value);
+};
+
+// The active kernels. The first call selects them.
+const InceptionV3Kernels &inception_v3_kernels();
+
+// Instruction sets this CPU can run, best first.
+std::vector<std::string> inception_v3_isas();
+
+// Switches every later kernel call to isa; false when it is unknown or not
+// supported here. Not meant for use while other threads are classifying.
+bool inception_v3_use_isa(const std::string &isa);
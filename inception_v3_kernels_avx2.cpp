@@ -0,0 +1,12 @@
+// Host kernels built with -mavx2 -mfma (see CMakeLists.txt); x86-64 only.
+#if defined(__x86_64__)
+#ifndef __AVX2__
+#error "inception_v3_kernels_avx2.cpp must be compiled with -mavx2 -mfma"
+#endif
+#include "inception_v3_kernels_impl.hpp"
+
+InceptionV3Kernels inception_v3_avx2_kernels()
+{
+    return make_kernels("avx2");
+}
+#endif
@@ -0,0 +1,13 @@
+// Host kernels built with -mavx512f -mavx512bw -mavx512vl -mavx512dq (see
+// CMakeLists.txt); x86-64 only.
+#if defined(__x86_64__)
+#if !defined(__AVX512F__) || !defined(__AVX512BW__)
+#error "inception_v3_kernels_avx512.cpp must be compiled with -mavx512f -mavx512bw -mavx512vl -mavx512dq"
+#endif
+#include "inception_v3_kernels_impl.hpp"
+
+InceptionV3Kernels inception_v3_avx512_kernels()
+{
+    return make_kernels("avx512");
+}
+#endif
@@ -0,0 +1,14 @@
+// Host kernels at the target's baseline instruction set, which every CPU of the
+// architecture has: SSE2 on x86-64, NEON (ASIMD) on AArch64.
+#include "inception_v3_kernels_impl.hpp"
+
+InceptionV3Kernels inception_v3_baseline_kernels()
+{
+#if defined(__x86_64__)
+    return make_kernels("sse2");
+#elif defined(__aarch64__)
+    return make_kernels("neon");
+#else
+    return make_kernels("generic");
+#endif
+}
@@ -0,0 +1,13 @@
+// Host kernels built with -march=armv8.2-a+dotprod (see CMakeLists.txt), for
+// cores with the SDOT/UDOT instructions such as the Cortex-A76; AArch64 only.
+#if defined(__aarch64__)
+#ifndef __ARM_FEATURE_DOTPROD
+#error "inception_v3_kernels_dotprod.cpp must be compiled with -march=armv8.2-a+dotprod"
+#endif
+#include "inception_v3_kernels_impl.hpp"
+
+InceptionV3Kernels inception_v3_dotprod_kernels()
+{
+    return make_kernels("dotprod");
+}
+#endif
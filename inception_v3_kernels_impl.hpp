@@ -0,0 +1,241 @@
+#pragma once
+#include "inception_v3_kernels.hpp"
+#include <math.h>
+
+// Kernel bodies for inception_v3_kernels_<isa>.cpp; include from nowhere else.
+// Each of those files compiles this with different target flags, so everything
+// here is TU-local and calls no inline library templates: an out-of-line copy
+// of, say, std::max built for AVX-512 must never be what the scalar variant
+// links against.
+
+namespace
+{
+inline uint8_t clamp_u8(int value)
+{
+    return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+const size_t TOP_K_BLOCK = 64;
+
+size_t top_k_u8(const uint8_t *scores, size_t count, size_t k, int *class_ids)
+{
+    k = k < count ? k : count;
+    if (k == 0) {
+        return 0;
+    }
+    size_t filled = 0;
+
+    // Once the list is full, a block whose maximum does not beat the k-th score
+    // is skipped after one vectorized max pass; only the rare blocks that do
+    // beat it go through the insertion below.
+    for (size_t begin = 0; begin < count; begin += TOP_K_BLOCK) {
+        const size_t end = begin + TOP_K_BLOCK < count ? begin + TOP_K_BLOCK : count;
+        if (filled == k) {
+            uint8_t block_max = 0;
+            for (size_t i = begin; i < end; i++) {
+                block_max = scores[i] > block_max ? scores[i] : block_max;
+            }
+            if (block_max <= scores[class_ids[k - 1]]) {
+                continue;
+            }
+        }
+
+        // Insertion into a tiny sorted list; for k <= 5 this beats a heap or partial_sort.
+        for (size_t i = begin; i < end; i++) {
+            const uint8_t score = scores[i];
+            if (filled == k && score <= scores[class_ids[k - 1]]) {
+                continue;
+            }
+            size_t pos = filled < k ? filled++ : k - 1;
+            while (pos > 0 && scores[class_ids[pos - 1]] < score) {
+                class_ids[pos] = class_ids[pos - 1];
+                pos--;
+            }
+            class_ids[pos] = static_cast<int>(i);
+        }
+    }
+    return filled;
+}
+
+int argmax_eligible_u8(const uint8_t *scores, const uint16_t *thresholds, size_t count)
+{
+    // No branches: each eligible class becomes score << 16 | ~id, so the max key
+    // is the best score with the lowest id.
+    uint32_t best_key = 0;
+    const uint32_t classes = static_cast<uint32_t>(count);
+    for (uint32_t i = 0; i < classes; i++) {
+        uint32_t score = scores[i];
+        uint32_t eligible = 0u - static_cast<uint32_t>(score >= thresholds[i]);
+        uint32_t key = ((score << 16) | (0xFFFFu - i)) & eligible;
+        best_key = key > best_key ? key : best_key;
+    }
+    return best_key == 0 ? -1 : static_cast<int>(0xFFFFu - (best_key & 0xFFFFu));
+}
+
+void resize_rgb_row(const uint8_t *row0, const uint8_t *row1, uint32_t weight1, const InceptionV3ResizeTap *xs,
+                    uint32_t width, uint8_t *out)
+{
+    const uint32_t wy1 = weight1;
+    const uint32_t wy0 = 256 - wy1;
+    for (uint32_t x = 0; x < width; x++) {
+        const uint32_t x0 = xs[x].index0 * 3;
+        const uint32_t x1 = xs[x].index1 * 3;
+        const uint32_t wx1 = xs[x].weight1;
+        const uint32_t wx0 = 256 - wx1;
+        for (uint32_t c = 0; c < 3; c++) {
+            uint32_t top = row0[x0 + c] * wx0 + row0[x1 + c] * wx1;
+            uint32_t bottom = row1[x0 + c] * wx0 + row1[x1 + c] * wx1;
+            out[x * 3 + c] = static_cast<uint8_t>((top * wy0 + bottom * wy1 + (1u << 15)) >> 16);
+        }
+    }
+}
+
+void nv12_rgb_row(const uint8_t *row0, const uint8_t *row1, const uint8_t *uv_row, uint32_t weight1,
+                  const InceptionV3ResizeTap *xs, uint32_t width, uint8_t *out)
+{
+    const uint32_t wy1 = weight1;
+    const uint32_t wy0 = 256 - wy1;
+    for (uint32_t x = 0; x < width; x++) {
+        const uint32_t x0 = xs[x].index0;
+        const uint32_t x1 = xs[x].index1;
+        const uint32_t wx1 = xs[x].weight1;
+        const uint32_t wx0 = 256 - wx1;
+        uint32_t top = row0[x0] * wx0 + row0[x1] * wx1;
+        uint32_t bottom = row1[x0] * wx0 + row1[x1] * wx1;
+        int luma = static_cast<int>((top * wy0 + bottom * wy1 + (1u << 15)) >> 16);
+
+        // Chroma is subsampled 2x2, nearest sample is within half a luma pixel.
+        const uint8_t *uv = uv_row + (x0 & ~1u);
+        int c = 298 * (luma - 16);
+        int d = uv[0] - 128;
+        int e = uv[1] - 128;
+        out[x * 3 + 0] = clamp_u8((c + 409 * e + 128) >> 8);
+        out[x * 3 + 1] = clamp_u8((c - 100 * d - 208 * e + 128) >> 8);
+        out[x * 3 + 2] = clamp_u8((c + 516 * d + 128) >> 8);
+    }
+}
+
+void softmax_f32(float *values, size_t count)
+{
+    if (count == 0) {
+        return;
+    }
+    float maximum = values[0];
+    for (size_t i = 1; i < count; i++) {
+        maximum = values[i] > maximum ? values[i] : maximum;
+    }
+    float total = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        values[i] = expf(values[i] - maximum);
+        total += values[i];
+    }
+    for (size_t i = 0; i < count; i++) {
+        values[i] = values[i] / total;
+    }
+}
+
+// Both operands hold 8-bit values in 16-bit lanes, so these compile to packed
+// 16-bit multiply-adds into 32-bit sums (pmaddwd and its AVX2 / AVX-512 forms,
+// smlal on NEON) rather than widening every byte first; the products stay exact.
+int32_t dot_i16(const int16_t *a, const int16_t *w, size_t depth)
+{
+    int32_t sum = 0;
+    for (size_t k = 0; k < depth; k++) {
+        sum += static_cast<int32_t>(a[k]) * w[k];
+    }
+    return sum;
+}
+
+void dot_i16_1x4(const int16_t *a, const int16_t *w, size_t stride, size_t depth, int32_t sums[4])
+{
+    const int16_t *w0 = w;
+    const int16_t *w1 = w + stride;
+    const int16_t *w2 = w + 2 * stride;
+    const int16_t *w3 = w + 3 * stride;
+    int32_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for (size_t k = 0; k < depth; k++) {
+        const int32_t x = a[k];
+        s0 += x * w0[k];
+        s1 += x * w1[k];
+        s2 += x * w2[k];
+        s3 += x * w3[k];
+    }
+    sums[0] = s0;
+    sums[1] = s1;
+    sums[2] = s2;
+    sums[3] = s3;
+}
+
+// Widening multiply-add; pmaddwd on x86, sdot with the dotprod extension.
+int32_t dot_i8(const int8_t *a, const int8_t *b, size_t count)
+{
+    int32_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        sum += static_cast<int16_t>(a[i]) * static_cast<int16_t>(b[i]);
+    }
+    return sum;
+}
+
+// Both smoothing loops are branch-free with 32-bit indices so that they
+// vectorize; the argmax rides along as max(value << 16 | ~id).
+int ema_update_u8(uint16_t *smoothed, const uint8_t *scores, uint32_t count, int32_t alpha)
+{
+    uint32_t best_key = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        int32_t value = smoothed[i];
+        value += ((static_cast<int32_t>(scores[i]) << 8) - value) * alpha >> 8;
+        smoothed[i] = static_cast<uint16_t>(value);
+        uint32_t key = (static_cast<uint32_t>(value) << 16) | (0xFFFFu - i);
+        best_key = key > best_key ? key : best_key;
+    }
+    return static_cast<int>(0xFFFFu - (best_key & 0xFFFFu));
+}
+
+int window_update_u8(uint16_t *smoothed, uint8_t *oldest, const uint8_t *scores, uint32_t count, uint32_t keep)
+{
+    uint32_t best_key = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t value = smoothed[i] + scores[i] - (oldest[i] & keep);
+        smoothed[i] = static_cast<uint16_t>(value);
+        oldest[i] = scores[i];
+        uint32_t key = (value << 16) | (0xFFFFu - i);
+        best_key = key > best_key ? key : best_key;
+    }
+    return static_cast<int>(0xFFFFu - (best_key & 0xFFFFu));
+}
+
+void shade_row(uint8_t *row, uint32_t bytes, uint32_t alpha, uint8_t value)
+{
+    const uint32_t keep = 256 - alpha;
+    const uint32_t add = value * alpha;
+    for (uint32_t i = 0; i < bytes; i++) {
+        row[i] = static_cast<uint8_t>((row[i] * keep + add) >> 8);
+    }
+}
+
+void stamp_row(uint8_t *row, const uint8_t *mask, uint32_t bytes, uint8_t value)
+{
+    for (uint32_t i = 0; i < bytes; i++) {
+        row[i] = static_cast<uint8_t>((row[i] & ~mask[i]) | (value & mask[i]));
+    }
+}
+
+InceptionV3Kernels make_kernels(const char *isa)
+{
+    InceptionV3Kernels kernels;
+    kernels.isa = isa;
+    kernels.top_k_u8 = top_k_u8;
+    kernels.argmax_eligible_u8 = argmax_eligible_u8;
+    kernels.resize_rgb_row = resize_rgb_row;
+    kernels.nv12_rgb_row = nv12_rgb_row;
+    kernels.softmax_f32 = softmax_f32;
+    kernels.dot_i16 = dot_i16;
+    kernels.dot_i16_1x4 = dot_i16_1x4;
+    kernels.dot_i8 = dot_i8;
+    kernels.ema_update_u8 = ema_update_u8;
+    kernels.window_update_u8 = window_update_u8;
+    kernels.shade_row = shade_row;
+    kernels.stamp_row = stamp_row;
+    return kernels;
+}
+} // namespace
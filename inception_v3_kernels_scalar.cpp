@@ -0,0 +1,8 @@
+// Reference build of the host kernels: compiled with vectorization disabled
+// (see CMakeLists.txt), so it is the plain per-element code on every machine.
+#include "inception_v3_kernels_impl.hpp"
+
+InceptionV3Kernels inception_v3_scalar_kernels()
+{
+    return make_kernels("scalar");
+}
@@ -0,0 +1,174 @@
+#include "inception_v3_kernels.hpp"
+#include "inception_v3_test.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Every kernel set this CPU runs against the scalar reference, on random inputs
+// of lengths that leave vector tails. Integer kernels must match exactly;
+// softmax within float rounding.
+
+namespace
+{
+void check(bool ok, const std::string &isa, const char *kernel, size_t case_index)
+{
+    inception_v3_check(ok, isa + " vs scalar", kernel, case_index);
+}
+
+void compare(const InceptionV3Kernels &scalar, const InceptionV3Kernels &kernels, std::mt19937 &rng)
+{
+    const std::string isa = kernels.isa;
+    const size_t sizes[] = {1, 7, 31, 64, 65, 127, 1000, 1001, 4099};
+
+    for (size_t c = 0; c < 300; c++) {
+        const size_t count = sizes[c % 9];
+        // Narrow score ranges make ties and equal thresholds common.
+        const uint32_t range = c % 3 == 0 ? 4 : 256;
+        std::vector<uint8_t> scores(count);
+        std::vector<uint16_t> thresholds(count);
+        for (auto &score : scores) {
+            score = static_cast<uint8_t>(rng() % range);
+        }
+        for (auto &threshold : thresholds) {
+            threshold = static_cast<uint16_t>(rng() % 3 == 0 ? 0x100 : rng() % (range + 1));
+        }
+
+        const size_t k = c % 7;
+        int expected_ids[8] = {};
+        int ids[8] = {};
+        size_t expected = scalar.top_k_u8(scores.data(), count, k, expected_ids);
+        size_t got = kernels.top_k_u8(scores.data(), count, k, ids);
+        check(got == expected && std::memcmp(ids, expected_ids, got * sizeof(int)) == 0, isa, "top_k_u8", c);
+
+        check(kernels.argmax_eligible_u8(scores.data(), thresholds.data(), count) ==
+                  scalar.argmax_eligible_u8(scores.data(), thresholds.data(), count),
+              isa, "argmax_eligible_u8", c);
+    }
+
+    for (size_t c = 0; c < 50; c++) {
+        const uint32_t width = 1 + rng() % 400;
+        const uint32_t source_width = width * 2 + 2;
+        std::vector<InceptionV3ResizeTap> xs(width);
+        for (uint32_t x = 0; x < width; x++) {
+            xs[x].index0 = rng() % source_width;
+            xs[x].index1 = std::min(xs[x].index0 + 1, source_width - 1);
+            xs[x].weight1 = rng() % 257;
+        }
+        std::vector<uint8_t> row0(source_width * 3), row1(source_width * 3), uv(source_width + 2);
+        for (auto *row : {&row0, &row1, &uv}) {
+            for (auto &value : *row) {
+                value = static_cast<uint8_t>(rng());
+            }
+        }
+        const uint32_t weight1 = rng() % 257;
+
+        std::vector<uint8_t> expected(width * 3), got(width * 3);
+        scalar.resize_rgb_row(row0.data(), row1.data(), weight1, xs.data(), width, expected.data());
+        kernels.resize_rgb_row(row0.data(), row1.data(), weight1, xs.data(), width, got.data());
+        check(got == expected, isa, "resize_rgb_row", c);
+
+        // NV12 taps index luma pixels; the chroma pair is read at index & ~1.
+        scalar.nv12_rgb_row(row0.data(), row1.data(), uv.data(), weight1, xs.data(), width, expected.data());
+        kernels.nv12_rgb_row(row0.data(), row1.data(), uv.data(), weight1, xs.data(), width, got.data());
+        check(got == expected, isa, "nv12_rgb_row", c);
+    }
+
+    for (size_t c = 0; c < 100; c++) {
+        const size_t depth = sizes[c % 9];
+        const size_t stride = depth + c % 5;
+        std::vector<int16_t> a(depth), w(4 * stride);
+        std::vector<int8_t> a8(depth), b8(depth);
+        for (auto &value : a) {
+            value = static_cast<int16_t>(rng() % 256);
+        }
+        for (auto &value : w) {
+            value = static_cast<int16_t>(static_cast<int>(rng() % 256) - 128);
+        }
+        for (size_t i = 0; i < depth; i++) {
+            a8[i] = static_cast<int8_t>(rng());
+            b8[i] = static_cast<int8_t>(rng());
+        }
+
+        check(kernels.dot_i16(a.data(), w.data(), depth) == scalar.dot_i16(a.data(), w.data(), depth), isa,
+              "dot_i16", c);
+        int32_t expected[4], got[4];
+        scalar.dot_i16_1x4(a.data(), w.data(), stride, depth, expected);
+        kernels.dot_i16_1x4(a.data(), w.data(), stride, depth, got);
+        check(std::memcmp(got, expected, sizeof(got)) == 0, isa, "dot_i16_1x4", c);
+        check(kernels.dot_i8(a8.data(), b8.data(), depth) == scalar.dot_i8(a8.data(), b8.data(), depth), isa,
+              "dot_i8", c);
+
+        std::vector<float> expected_softmax(depth), got_softmax(depth);
+        std::normal_distribution<float> logits(0.0f, 4.0f);
+        for (size_t i = 0; i < depth; i++) {
+            expected_softmax[i] = got_softmax[i] = logits(rng);
+        }
+        scalar.softmax_f32(expected_softmax.data(), depth);
+        kernels.softmax_f32(got_softmax.data(), depth);
+        bool close = true;
+        for (size_t i = 0; i < depth; i++) {
+            close = close && std::fabs(got_softmax[i] - expected_softmax[i]) <= 1e-6f + 1e-4f * expected_softmax[i];
+        }
+        check(close, isa, "softmax_f32", c);
+    }
+
+    for (size_t c = 0; c < 100; c++) {
+        const uint32_t count = static_cast<uint32_t>(sizes[c % 9]);
+        // Few distinct values, so the argmax often has to break ties. Even cases
+        // start from window sums that include oldest, odd ones from any Q8.8 value.
+        const uint32_t range = c % 3 == 0 ? 3 : 256;
+        std::vector<uint8_t> scores(count), oldest(count);
+        std::vector<uint16_t> smoothed(count);
+        for (uint32_t i = 0; i < count; i++) {
+            scores[i] = static_cast<uint8_t>(rng() % range);
+            oldest[i] = static_cast<uint8_t>(rng() % range);
+            smoothed[i] = static_cast<uint16_t>(c % 2 ? rng() % (range << 8) : oldest[i] * 8 + rng() % range);
+        }
+
+        auto expected = smoothed, got = smoothed;
+        const int32_t alpha = 1 + rng() % 256;
+        check(kernels.ema_update_u8(got.data(), scores.data(), count, alpha) ==
+                      scalar.ema_update_u8(expected.data(), scores.data(), count, alpha) &&
+                  got == expected,
+              isa, "ema_update_u8", c);
+
+        expected = got = smoothed;
+        auto expected_oldest = oldest, got_oldest = oldest;
+        const uint32_t keep = c % 4 == 0 ? 0u : 0xFFu;
+        check(kernels.window_update_u8(got.data(), got_oldest.data(), scores.data(), count, keep) ==
+                      scalar.window_update_u8(expected.data(), expected_oldest.data(), scores.data(), count, keep) &&
+                  got == expected && got_oldest == expected_oldest,
+              isa, "window_update_u8", c);
+
+        std::vector<uint8_t> mask(count);
+        for (auto &value : mask) {
+            value = rng() % 2 ? 0xFF : 0x00;
+        }
+        auto expected_row = oldest, got_row = oldest;
+        const uint32_t box_alpha = rng() % 257;
+        const uint8_t value = static_cast<uint8_t>(rng());
+        scalar.shade_row(expected_row.data(), count, box_alpha, value);
+        kernels.shade_row(got_row.data(), count, box_alpha, value);
+        check(got_row == expected_row, isa, "shade_row", c);
+        scalar.stamp_row(expected_row.data(), mask.data(), count, value);
+        kernels.stamp_row(got_row.data(), mask.data(), count, value);
+        check(got_row == expected_row, isa, "stamp_row", c);
+    }
+}
+} // namespace
+
+int main()
+{
+    if (!inception_v3_use_isa("scalar")) {
+        std::cerr << "scalar kernels are missing" << std::endl;
+        return 1;
+    }
+    const InceptionV3Kernels scalar = inception_v3_kernels();
+
+    inception_v3_for_each_isa([&](const std::string &, std::mt19937 &rng) {
+        compare(scalar, inception_v3_kernels(), rng);
+    }, false);
+    return inception_v3_test_result();
+}
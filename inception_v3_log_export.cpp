@@ -0,0 +1,123 @@
+#include "inception_v3_result_log.hpp"
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+// Converts a binary result log directory to CSV or JSON lines on stdout.
+
+static void print_usage(const char *program)
+{
+    std::cerr << "Usage: " << program << " <log_dir> [--csv | --jsonl] [--labels ./imagenet_classes.txt]" << std::endl;
+}
+
+static std::string json_escape(const std::string &text)
+{
+    static const char hex[] = "0123456789abcdef";
+    std::string escaped;
+    for (char c : text) {
+        const unsigned char byte = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (byte < 0x20) {
+            // Control characters are not allowed raw in JSON strings.
+            escaped += "\\u00";
+            escaped += hex[byte >> 4];
+            escaped += hex[byte & 0xf];
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+static std::string csv_escape(const std::string &text)
+{
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"') {
+            escaped += '"';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::string dir = argv[1];
+    bool jsonl = false;
+    std::string labels_file = "./imagenet_classes.txt";
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--csv") {
+            jsonl = false;
+        } else if (arg == "--jsonl") {
+            jsonl = true;
+        } else if (arg == "--labels" && i + 1 < argc) {
+            labels_file = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<std::string> labels;
+    std::ifstream file(labels_file);
+    std::string line;
+    while (std::getline(file, line)) {
+        labels.push_back(line);
+    }
+    auto label_of = [&labels](uint16_t id) { return id < labels.size() ? labels[id] : std::to_string(id); };
+
+    try {
+        if (!jsonl) {
+            std::cout << "timestamp_ns,stream_id,frame_seq,latency_us,valid,event";
+            for (size_t k = 0; k < INCEPTION_V3_LOG_TOP_K; k++) {
+                std::cout << ",class_id_" << k << ",label_" << k << ",confidence_" << k;
+            }
+            std::cout << '\n';
+        }
+
+        read_inception_v3_log(dir, [&](const InceptionV3LogRecord &record) {
+            bool valid = record.flags & INCEPTION_V3_LOG_VALID;
+            bool event = record.flags & INCEPTION_V3_LOG_EVENT;
+            if (jsonl) {
+                std::cout << "{\"timestamp_ns\":" << record.timestamp_ns << ",\"stream_id\":" << record.stream_id
+                          << ",\"frame_seq\":" << record.frame_seq << ",\"latency_us\":" << record.latency_us
+                          << ",\"valid\":" << (valid ? "true" : "false") << ",\"event\":" << (event ? "true" : "false")
+                          << ",\"top_k\":[";
+                for (size_t k = 0; k < record.top_k_count && k < INCEPTION_V3_LOG_TOP_K; k++) {
+                    std::cout << (k ? "," : "") << "{\"class_id\":" << record.class_ids[k] << ",\"label\":\""
+                              << json_escape(label_of(record.class_ids[k])) << "\",\"confidence\":"
+                              << record.confidences[k] << "}";
+                }
+                std::cout << "]}\n";
+                return;
+            }
+
+            std::cout << record.timestamp_ns << ',' << record.stream_id << ',' << record.frame_seq << ','
+                      << record.latency_us << ',' << (valid ? 1 : 0) << ',' << (event ? 1 : 0);
+            for (size_t k = 0; k < INCEPTION_V3_LOG_TOP_K; k++) {
+                if (k < record.top_k_count) {
+                    std::cout << ',' << record.class_ids[k] << ",\"" << csv_escape(label_of(record.class_ids[k])) << "\","
+                              << record.confidences[k];
+                } else {
+                    std::cout << ",,,";
+                }
+            }
+            std::cout << '\n';
+        });
+
+    } catch (const std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
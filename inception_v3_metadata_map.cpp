@@ -0,0 +1,108 @@
+#include "inception_v3_metadata_map.hpp"
+#include "inception_v3_source.hpp"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+InceptionV3MetadataMap::InceptionV3MetadataMap(size_t capacity)
+    : m_mask(0), m_published(0)
+{
+    if (capacity == 0) {
+        throw std::invalid_argument("metadata map capacity must be positive");
+    }
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    // new Slot[] only honours alignas(64) from C++17 on, so the slots are
+    // allocated cache-line aligned by hand and constructed in place.
+    static_assert(std::is_trivially_destructible<Slot>::value, "FreeSlots does not run destructors");
+    void *memory = nullptr;
+    if (posix_memalign(&memory, alignof(Slot), size * sizeof(Slot)) != 0) {
+        throw std::bad_alloc();
+    }
+    Slot *slots = static_cast<Slot *>(memory);
+    for (size_t i = 0; i < size; i++) {
+        new (&slots[i]) Slot();
+    }
+    m_slots.reset(slots);
+    m_mask = size - 1;
+}
+
+void InceptionV3MetadataMap::publish(const InceptionV3FrameMetadata &metadata)
+{
+    const uint64_t published = m_published.load(std::memory_order_relaxed);
+    Slot &slot = m_slots[published & m_mask];
+
+    // Single writer: nobody else changes the sequence, so no read-modify-write is needed.
+    uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::memcpy(&slot.metadata, &metadata, sizeof(metadata));
+
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+    m_published.store(published + 1, std::memory_order_release);
+}
+
+void InceptionV3MetadataMap::publish(uint64_t key, const std::string &label, float confidence, int32_t class_id)
+{
+    InceptionV3FrameMetadata metadata;
+    metadata.key = key;
+    metadata.publish_time_ns = inception_v3_now_ns();
+    metadata.class_id = class_id;
+    metadata.confidence = confidence;
+    std::memcpy(metadata.label, label.data(), std::min(label.size(), INCEPTION_V3_METADATA_LABEL_SIZE - 1));
+    publish(metadata);
+}
+
+bool InceptionV3MetadataMap::read(const Slot &slot, InceptionV3FrameMetadata &metadata)
+{
+    while (true) {
+        uint32_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before == 0) {
+            return false;
+        }
+        if (before & 1) {
+            continue;
+        }
+
+        std::memcpy(&metadata, &slot.metadata, sizeof(metadata));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+}
+
+bool InceptionV3MetadataMap::find(uint64_t key, InceptionV3FrameMetadata &metadata) const
+{
+    const uint64_t published = m_published.load(std::memory_order_acquire);
+    const uint64_t depth = std::min<uint64_t>(published, m_mask + 1);
+    for (uint64_t i = 1; i <= depth; i++) {
+        if (!read(m_slots[(published - i) & m_mask], metadata) || metadata.key < key) {
+            return false;
+        }
+        if (metadata.key == key) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool InceptionV3MetadataMap::latest(InceptionV3FrameMetadata &metadata) const
+{
+    const uint64_t published = m_published.load(std::memory_order_acquire);
+    return published != 0 && read(m_slots[(published - 1) & m_mask], metadata);
+}
+
+bool InceptionV3MetadataMap::lookup(uint64_t key, uint64_t max_lag, InceptionV3FrameMetadata &metadata) const
+{
+    if (find(key, metadata)) {
+        return true;
+    }
+    return latest(metadata) && (metadata.key >= key || key - metadata.key <= max_lag);
+}
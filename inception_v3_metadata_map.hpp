@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+static const size_t INCEPTION_V3_METADATA_LABEL_SIZE = 64;
+
+struct InceptionV3FrameMetadata
+{
+    uint64_t key = 0;               // PTS or sequence number of the frame the result belongs to
+    uint64_t publish_time_ns = 0;   // CLOCK_MONOTONIC
+    int32_t class_id = -1;
+    float confidence = 0.0f;
+    char label[INCEPTION_V3_METADATA_LABEL_SIZE] = {};
+};
+
+// Results of the inference branch keyed by frame, for attaching them to the
+// full-resolution frames of the display branch without pairing the two branches
+// (hailomuxer) or holding display frames back.
+//
+// A ring of the last capacity results in seqlocked slots. Keys must be published
+// in increasing order (PTS or sequence numbers of one stream are), so find()
+// walks back from the newest result and stops at the first older key; a display
+// asking about a recent frame finds it in a slot or two. One writer, any number of
+// readers, no locks and no allocation after construction.
+class InceptionV3MetadataMap
+{
+public:
+    explicit InceptionV3MetadataMap(size_t capacity = 64);
+
+    InceptionV3MetadataMap(const InceptionV3MetadataMap &) = delete;
+    InceptionV3MetadataMap &operator=(const InceptionV3MetadataMap &) = delete;
+
+    // Single writer.
+    void publish(const InceptionV3FrameMetadata &metadata);
+    void publish(uint64_t key, const std::string &label, float confidence, int32_t class_id = -1);
+
+    // The result of exactly this frame; false if it is not (or no longer) in the map.
+    bool find(uint64_t key, InceptionV3FrameMetadata &metadata) const;
+
+    // The most recently published result; false before the first one.
+    bool latest(InceptionV3FrameMetadata &metadata) const;
+
+    // What a display shows for frame key: its own result when inference already
+    // finished it, otherwise the latest result unless that is more than max_lag
+    // behind key (in key units, e.g. nanoseconds of PTS).
+    bool lookup(uint64_t key, uint64_t max_lag, InceptionV3FrameMetadata &metadata) const;
+
+    size_t capacity() const { return m_mask + 1; }
+
+private:
+    struct alignas(64) Slot
+    {
+        std::atomic<uint32_t> sequence{0};
+        InceptionV3FrameMetadata metadata;
+    };
+
+    // The slots come from posix_memalign (see the constructor) and are trivially destructible.
+    struct FreeSlots
+    {
+        void operator()(Slot *slots) const { std::free(slots); }
+    };
+
+    static bool read(const Slot &slot, InceptionV3FrameMetadata &metadata);
+
+    std::unique_ptr<Slot[], FreeSlots> m_slots;
+    size_t m_mask;
+    std::atomic<uint64_t> m_published;  // results published so far; the newest is in slot (m_published - 1) & m_mask
+};
@@ -0,0 +1,116 @@
+#include "inception_v3_metadata_map.hpp"
+#include "inception_v3_test.hpp"
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+// InceptionV3MetadataMap lookups once the ring has wrapped, and readers racing
+// one writer: every result a reader gets must be one the writer published
+// whole, never a mix of two. Torn reads are only likely with the readers on
+// other cores than the writer.
+
+namespace
+{
+// Every field derives from the key, so a torn read shows as a mismatch.
+InceptionV3FrameMetadata make_metadata(uint64_t key)
+{
+    InceptionV3FrameMetadata metadata;
+    metadata.key = key;
+    metadata.publish_time_ns = key * 3;
+    metadata.class_id = static_cast<int32_t>(key % 1000);
+    metadata.confidence = static_cast<float>(key % 997);
+    const std::string label = "class " + std::to_string(key);
+    std::memcpy(metadata.label, label.c_str(), label.size() + 1);
+    return metadata;
+}
+
+bool consistent(const InceptionV3FrameMetadata &metadata)
+{
+    const InceptionV3FrameMetadata expected = make_metadata(metadata.key);
+    return std::memcmp(&metadata, &expected, sizeof(metadata)) == 0;
+}
+
+void check_wraparound()
+{
+    InceptionV3MetadataMap map(5);
+    InceptionV3FrameMetadata metadata;
+    inception_v3_check(map.capacity() == 8, "wraparound", "capacity rounds up", 0);
+    inception_v3_check(!map.latest(metadata) && !map.find(0, metadata), "wraparound", "empty map finds nothing", 0);
+
+    // Keys 0, 10, ..., 190: only the last eight are still in the ring.
+    for (uint64_t i = 0; i < 20; i++) {
+        map.publish(make_metadata(i * 10));
+    }
+    for (uint64_t i = 0; i < 20; i++) {
+        const bool found = map.find(i * 10, metadata);
+        inception_v3_check(found == (i >= 12) && (!found || (metadata.key == i * 10 && consistent(metadata))),
+                           "wraparound", "find", i);
+    }
+    inception_v3_check(!map.find(175, metadata), "wraparound", "find between keys", 0);
+    inception_v3_check(!map.find(500, metadata), "wraparound", "find beyond the newest key", 0);
+    inception_v3_check(map.latest(metadata) && metadata.key == 190, "wraparound", "latest", 0);
+
+    // A frame inference has not reached yet falls back to the latest result within max_lag.
+    inception_v3_check(map.lookup(150, 0, metadata) && metadata.key == 150, "wraparound", "lookup of a finished frame",
+                       0);
+    inception_v3_check(map.lookup(200, 10, metadata) && metadata.key == 190, "wraparound", "lookup within lag", 0);
+    inception_v3_check(!map.lookup(200, 9, metadata), "wraparound", "lookup beyond lag", 0);
+    inception_v3_check(map.lookup(20, 0, metadata) && metadata.key == 190, "wraparound", "lookup of an evicted frame",
+                       0);
+}
+
+void check_concurrent_readers()
+{
+    // A small ring so the writer laps the readers constantly.
+    InceptionV3MetadataMap map(4);
+    const uint64_t results = 200000;
+    std::atomic<bool> done(false);
+    std::atomic<int> torn(0);
+    std::atomic<int> backwards(0);
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; r++) {
+        readers.emplace_back([&, r]() {
+            InceptionV3FrameMetadata metadata;
+            uint64_t last = 0;
+            uint64_t probe = 0;
+            while (!done) {
+                if (map.latest(metadata)) {
+                    torn += consistent(metadata) ? 0 : 1;
+                    backwards += metadata.key < last ? 1 : 0;
+                    last = metadata.key;
+                    probe = metadata.key - metadata.key % (r + 2);
+                }
+                if (map.find(probe, metadata)) {
+                    torn += consistent(metadata) && metadata.key == probe ? 0 : 1;
+                }
+            }
+        });
+    }
+
+    for (uint64_t key = 1; key <= results; key++) {
+        map.publish(make_metadata(key));
+        if (key % 1024 == 0) {
+            std::this_thread::yield();
+        }
+    }
+    done = true;
+    for (auto &reader : readers) {
+        reader.join();
+    }
+
+    InceptionV3FrameMetadata metadata;
+    inception_v3_check(torn == 0, "concurrent readers", "torn or wrong result", 0);
+    inception_v3_check(backwards == 0, "concurrent readers", "latest going backwards", 0);
+    inception_v3_check(map.latest(metadata) && metadata.key == results, "concurrent readers", "final latest", 0);
+}
+} // namespace
+
+int main()
+{
+    check_wraparound();
+    check_concurrent_readers();
+    return inception_v3_test_result();
+}
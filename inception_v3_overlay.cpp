@@ -0,0 +1,276 @@
+#include "inception_v3_overlay.hpp"
+#include "inception_v3_kernels.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+// Public-domain 8x8 font (IBM PC BIOS shapes) for printable ASCII, one byte per
+// row, least significant bit leftmost.
+const uint8_t FONT_8X8[95][8] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ' '
+    {0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00}, // '!'
+    {0x36, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '"'
+    {0x36, 0x36, 0x7F, 0x36, 0x7F, 0x36, 0x36, 0x00}, // '#'
+    {0x0C, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x0C, 0x00}, // '$'
+    {0x00, 0x63, 0x33, 0x18, 0x0C, 0x66, 0x63, 0x00}, // '%'
+    {0x1C, 0x36, 0x1C, 0x6E, 0x3B, 0x33, 0x6E, 0x00}, // '&'
+    {0x06, 0x06, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00}, // '''
+    {0x18, 0x0C, 0x06, 0x06, 0x06, 0x0C, 0x18, 0x00}, // '('
+    {0x06, 0x0C, 0x18, 0x18, 0x18, 0x0C, 0x06, 0x00}, // ')'
+    {0x00, 0x66, 0x3C, 0xFF, 0x3C, 0x66, 0x00, 0x00}, // '*'
+    {0x00, 0x0C, 0x0C, 0x3F, 0x0C, 0x0C, 0x00, 0x00}, // '+'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x06}, // ','
+    {0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00}, // '-'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00}, // '.'
+    {0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x01, 0x00}, // '/'
+    {0x3E, 0x63, 0x73, 0x7B, 0x6F, 0x67, 0x3E, 0x00}, // '0'
+    {0x0C, 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x3F, 0x00}, // '1'
+    {0x1E, 0x33, 0x30, 0x1C, 0x06, 0x33, 0x3F, 0x00}, // '2'
+    {0x1E, 0x33, 0x30, 0x1C, 0x30, 0x33, 0x1E, 0x00}, // '3'
+    {0x38, 0x3C, 0x36, 0x33, 0x7F, 0x30, 0x78, 0x00}, // '4'
+    {0x3F, 0x03, 0x1F, 0x30, 0x30, 0x33, 0x1E, 0x00}, // '5'
+    {0x1C, 0x06, 0x03, 0x1F, 0x33, 0x33, 0x1E, 0x00}, // '6'
+    {0x3F, 0x33, 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x00}, // '7'
+    {0x1E, 0x33, 0x33, 0x1E, 0x33, 0x33, 0x1E, 0x00}, // '8'
+    {0x1E, 0x33, 0x33, 0x3E, 0x30, 0x18, 0x0E, 0x00}, // '9'
+    {0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x00}, // ':'
+    {0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x06}, // ';'
+    {0x18, 0x0C, 0x06, 0x03, 0x06, 0x0C, 0x18, 0x00}, // '<'
+    {0x00, 0x00, 0x3F, 0x00, 0x00, 0x3F, 0x00, 0x00}, // '='
+    {0x06, 0x0C, 0x18, 0x30, 0x18, 0x0C, 0x06, 0x00}, // '>'
+    {0x1E, 0x33, 0x30, 0x18, 0x0C, 0x00, 0x0C, 0x00}, // '?'
+    {0x3E, 0x63, 0x7B, 0x7B, 0x7B, 0x03, 0x1E, 0x00}, // '@'
+    {0x0C, 0x1E, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x00}, // 'A'
+    {0x3F, 0x66, 0x66, 0x3E, 0x66, 0x66, 0x3F, 0x00}, // 'B'
+    {0x3C, 0x66, 0x03, 0x03, 0x03, 0x66, 0x3C, 0x00}, // 'C'
+    {0x1F, 0x36, 0x66, 0x66, 0x66, 0x36, 0x1F, 0x00}, // 'D'
+    {0x7F, 0x46, 0x16, 0x1E, 0x16, 0x46, 0x7F, 0x00}, // 'E'
+    {0x7F, 0x46, 0x16, 0x1E, 0x16, 0x06, 0x0F, 0x00}, // 'F'
+    {0x3C, 0x66, 0x03, 0x03, 0x73, 0x66, 0x7C, 0x00}, // 'G'
+    {0x33, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x33, 0x00}, // 'H'
+    {0x1E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // 'I'
+    {0x78, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E, 0x00}, // 'J'
+    {0x67, 0x66, 0x36, 0x1E, 0x36, 0x66, 0x67, 0x00}, // 'K'
+    {0x0F, 0x06, 0x06, 0x06, 0x46, 0x66, 0x7F, 0x00}, // 'L'
+    {0x63, 0x77, 0x7F, 0x7F, 0x6B, 0x63, 0x63, 0x00}, // 'M'
+    {0x63, 0x67, 0x6F, 0x7B, 0x73, 0x63, 0x63, 0x00}, // 'N'
+    {0x1C, 0x36, 0x63, 0x63, 0x63, 0x36, 0x1C, 0x00}, // 'O'
+    {0x3F, 0x66, 0x66, 0x3E, 0x06, 0x06, 0x0F, 0x00}, // 'P'
+    {0x1E, 0x33, 0x33, 0x33, 0x3B, 0x1E, 0x38, 0x00}, // 'Q'
+    {0x3F, 0x66, 0x66, 0x3E, 0x36, 0x66, 0x67, 0x00}, // 'R'
+    {0x1E, 0x33, 0x07, 0x0E, 0x38, 0x33, 0x1E, 0x00}, // 'S'
+    {0x3F, 0x2D, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // 'T'
+    {0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x3F, 0x00}, // 'U'
+    {0x33, 0x33, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00}, // 'V'
+    {0x63, 0x63, 0x63, 0x6B, 0x7F, 0x77, 0x63, 0x00}, // 'W'
+    {0x63, 0x63, 0x36, 0x1C, 0x1C, 0x36, 0x63, 0x00}, // 'X'
+    {0x33, 0x33, 0x33, 0x1E, 0x0C, 0x0C, 0x1E, 0x00}, // 'Y'
+    {0x7F, 0x63, 0x31, 0x18, 0x4C, 0x66, 0x7F, 0x00}, // 'Z'
+    {0x1E, 0x06, 0x06, 0x06, 0x06, 0x06, 0x1E, 0x00}, // '['
+    {0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x40, 0x00}, // '\'
+    {0x1E, 0x18, 0x18, 0x18, 0x18, 0x18, 0x1E, 0x00}, // ']'
+    {0x08, 0x1C, 0x36, 0x63, 0x00, 0x00, 0x00, 0x00}, // '^'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF}, // '_'
+    {0x0C, 0x0C, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00}, // '`'
+    {0x00, 0x00, 0x1E, 0x30, 0x3E, 0x33, 0x6E, 0x00}, // 'a'
+    {0x07, 0x06, 0x06, 0x3E, 0x66, 0x66, 0x3B, 0x00}, // 'b'
+    {0x00, 0x00, 0x1E, 0x33, 0x03, 0x33, 0x1E, 0x00}, // 'c'
+    {0x38, 0x30, 0x30, 0x3E, 0x33, 0x33, 0x6E, 0x00}, // 'd'
+    {0x00, 0x00, 0x1E, 0x33, 0x3F, 0x03, 0x1E, 0x00}, // 'e'
+    {0x1C, 0x36, 0x06, 0x0F, 0x06, 0x06, 0x0F, 0x00}, // 'f'
+    {0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x1F}, // 'g'
+    {0x07, 0x06, 0x36, 0x6E, 0x66, 0x66, 0x67, 0x00}, // 'h'
+    {0x0C, 0x00, 0x0E, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // 'i'
+    {0x30, 0x00, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E}, // 'j'
+    {0x07, 0x06, 0x66, 0x36, 0x1E, 0x36, 0x67, 0x00}, // 'k'
+    {0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // 'l'
+    {0x00, 0x00, 0x33, 0x7F, 0x7F, 0x6B, 0x63, 0x00}, // 'm'
+    {0x00, 0x00, 0x1F, 0x33, 0x33, 0x33, 0x33, 0x00}, // 'n'
+    {0x00, 0x00, 0x1E, 0x33, 0x33, 0x33, 0x1E, 0x00}, // 'o'
+    {0x00, 0x00, 0x3B, 0x66, 0x66, 0x3E, 0x06, 0x0F}, // 'p'
+    {0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x78}, // 'q'
+    {0x00, 0x00, 0x3B, 0x6E, 0x66, 0x06, 0x0F, 0x00}, // 'r'
+    {0x00, 0x00, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x00}, // 's'
+    {0x08, 0x0C, 0x3E, 0x0C, 0x0C, 0x2C, 0x18, 0x00}, // 't'
+    {0x00, 0x00, 0x33, 0x33, 0x33, 0x33, 0x6E, 0x00}, // 'u'
+    {0x00, 0x00, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00}, // 'v'
+    {0x00, 0x00, 0x63, 0x6B, 0x7F, 0x7F, 0x36, 0x00}, // 'w'
+    {0x00, 0x00, 0x63, 0x36, 0x1C, 0x36, 0x63, 0x00}, // 'x'
+    {0x00, 0x00, 0x33, 0x33, 0x33, 0x3E, 0x30, 0x1F}, // 'y'
+    {0x00, 0x00, 0x3F, 0x19, 0x0C, 0x26, 0x3F, 0x00}, // 'z'
+    {0x38, 0x0C, 0x0C, 0x07, 0x0C, 0x0C, 0x38, 0x00}, // '{'
+    {0x18, 0x18, 0x18, 0x00, 0x18, 0x18, 0x18, 0x00}, // '|'
+    {0x07, 0x0C, 0x0C, 0x38, 0x0C, 0x0C, 0x07, 0x00}, // '}'
+    {0x6E, 0x3B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '~'
+};
+
+const uint8_t GLYPH_COUNT = 95;
+const uint8_t GLYPH_UNKNOWN = '?' - ' ';
+
+// BT.601 limited range black and white; the chroma of any grey is 128.
+const uint8_t RGB_BOX = 0, RGB_TEXT = 255;
+const uint8_t LUMA_BOX = 16, LUMA_TEXT = 235;
+const uint8_t CHROMA_GREY = 128;
+
+bool font_pixel(uint8_t glyph, uint32_t x, uint32_t y)
+{
+    return (FONT_8X8[glyph][y] >> x) & 1;
+}
+}
+
+InceptionV3Overlay::InceptionV3Overlay(const std::vector<std::string> &labels, const InceptionV3OverlayStyle &style)
+    : m_style(style), m_cell(8 * style.scale), m_padding(2 * style.scale)
+{
+    if (style.scale == 0 || style.scale > 16) {
+        throw std::invalid_argument("overlay scale must be within [1, 16]");
+    }
+
+    const uint32_t cell = m_cell;
+    m_rgb_glyphs.resize(GLYPH_COUNT * cell * cell * 3);
+    m_luma_glyphs.resize(GLYPH_COUNT * cell * cell);
+    m_chroma_glyphs.resize(GLYPH_COUNT * cell / 2 * cell);
+    for (uint8_t glyph = 0; glyph < GLYPH_COUNT; glyph++) {
+        for (uint32_t y = 0; y < cell; y++) {
+            for (uint32_t x = 0; x < cell; x++) {
+                const uint8_t mask = font_pixel(glyph, x / style.scale, y / style.scale) ? 0xff : 0x00;
+                const size_t pixel = (static_cast<size_t>(glyph) * cell + y) * cell + x;
+                m_luma_glyphs[pixel] = mask;
+                m_rgb_glyphs[pixel * 3] = m_rgb_glyphs[pixel * 3 + 1] = m_rgb_glyphs[pixel * 3 + 2] = mask;
+            }
+        }
+        // A chroma sample goes neutral when any of the four luma pixels it covers is text.
+        for (uint32_t y = 0; y < cell / 2; y++) {
+            for (uint32_t x = 0; x < cell / 2; x++) {
+                const uint8_t *luma = &m_luma_glyphs[(static_cast<size_t>(glyph) * cell + 2 * y) * cell + 2 * x];
+                const uint8_t mask = luma[0] | luma[1] | luma[cell] | luma[cell + 1];
+                uint8_t *chroma = &m_chroma_glyphs[(static_cast<size_t>(glyph) * cell / 2 + y) * cell + 2 * x];
+                chroma[0] = chroma[1] = mask;
+            }
+        }
+    }
+
+    for (const auto &label : labels) {
+        layout(label, m_label_runs[label]);
+    }
+}
+
+void InceptionV3Overlay::layout(const std::string &text, std::vector<uint8_t> &glyphs) const
+{
+    glyphs.clear();
+    glyphs.reserve(text.size());
+    for (unsigned char c : text) {
+        glyphs.push_back(c >= ' ' && c <= '~' ? static_cast<uint8_t>(c - ' ') : GLYPH_UNKNOWN);
+    }
+}
+
+InceptionV3FramePlanes inception_v3_packed_planes(InceptionV3PixelFormat format, uint32_t width, uint32_t height,
+                                                  size_t stride)
+{
+    if (stride == 0) {
+        stride = format == INCEPTION_V3_FORMAT_RGB ? static_cast<size_t>(width) * 3 : width;
+    }
+    InceptionV3FramePlanes planes;
+    planes.offset[0] = 0;
+    planes.offset[1] = stride * height;
+    planes.stride[0] = stride;
+    planes.stride[1] = stride;
+    return planes;
+}
+
+void InceptionV3Overlay::draw(uint8_t *frame, InceptionV3PixelFormat format, uint32_t width, uint32_t height,
+                              const InceptionV3FramePlanes &planes, const std::string &label, float confidence) const
+{
+    std::vector<uint8_t> glyphs;
+    auto run = m_label_runs.find(label);
+    if (run != m_label_runs.end()) {
+        glyphs.reserve(run->second.size() + 5);
+        glyphs = run->second;
+    } else {
+        layout(label, glyphs);     // e.g. a label changed by a config reload
+    }
+
+    const int percent = static_cast<int>(std::lround(std::min(std::max(confidence, 0.0f), 1.0f) * 100.0f));
+    glyphs.push_back(0);
+    if (percent >= 100) {
+        glyphs.push_back('1' - ' ');
+    }
+    if (percent >= 10) {
+        glyphs.push_back(static_cast<uint8_t>('0' + percent / 10 % 10 - ' '));
+    }
+    glyphs.push_back(static_cast<uint8_t>('0' + percent % 10 - ' '));
+    glyphs.push_back('%' - ' ');
+
+    draw_glyphs(frame, format, width, height, planes, glyphs.data(), glyphs.size());
+}
+
+void InceptionV3Overlay::draw_text(uint8_t *frame, InceptionV3PixelFormat format, uint32_t width, uint32_t height,
+                                   size_t stride, const std::string &text) const
+{
+    std::vector<uint8_t> glyphs;
+    layout(text, glyphs);
+    draw_glyphs(frame, format, width, height, inception_v3_packed_planes(format, width, height, stride), glyphs.data(),
+                glyphs.size());
+}
+
+void InceptionV3Overlay::draw_glyphs(uint8_t *frame, InceptionV3PixelFormat format, uint32_t width,
+                                     uint32_t height, const InceptionV3FramePlanes &planes, const uint8_t *glyphs,
+                                     size_t count) const
+{
+    const uint32_t cell = m_cell;
+    const uint32_t padding = m_padding;
+    // Even origin, so the box covers whole NV12 chroma samples.
+    const uint32_t x0 = m_style.x & ~1u;
+    const uint32_t y0 = m_style.y & ~1u;
+    if (count == 0 || x0 + 2 * padding + cell > width || y0 + 2 * padding + cell > height) {
+        return;
+    }
+
+    // Text that does not fit is cut at the frame edge on a glyph boundary.
+    count = std::min<size_t>(count, (width - x0 - 2 * padding) / cell);
+    const uint32_t box_width = static_cast<uint32_t>(count) * cell + 2 * padding;
+    const uint32_t box_height = cell + 2 * padding;
+    const uint32_t alpha = m_style.box_alpha;
+
+    const InceptionV3Kernels &kernels = inception_v3_kernels();
+    uint8_t *const image = frame + planes.offset[0];
+    const size_t stride = planes.stride[0];
+    if (format == INCEPTION_V3_FORMAT_RGB) {
+        for (uint32_t y = 0; y < box_height; y++) {
+            kernels.shade_row(image + (y0 + y) * stride + x0 * 3, box_width * 3, alpha, RGB_BOX);
+        }
+        for (uint32_t y = 0; y < cell; y++) {
+            uint8_t *row = image + (y0 + padding + y) * stride + (x0 + padding) * 3;
+            for (size_t i = 0; i < count; i++) {
+                const uint8_t *mask = &m_rgb_glyphs[(static_cast<size_t>(glyphs[i]) * cell + y) * cell * 3];
+                kernels.stamp_row(row + i * cell * 3, mask, cell * 3, RGB_TEXT);
+            }
+        }
+        return;
+    }
+
+    for (uint32_t y = 0; y < box_height; y++) {
+        kernels.shade_row(image + (y0 + y) * stride + x0, box_width, alpha, LUMA_BOX);
+    }
+    for (uint32_t y = 0; y < cell; y++) {
+        uint8_t *row = image + (y0 + padding + y) * stride + x0 + padding;
+        for (size_t i = 0; i < count; i++) {
+            const uint8_t *mask = &m_luma_glyphs[(static_cast<size_t>(glyphs[i]) * cell + y) * cell];
+            kernels.stamp_row(row + i * cell, mask, cell, LUMA_TEXT);
+        }
+    }
+
+    uint8_t *const chroma = frame + planes.offset[1];
+    const size_t chroma_stride = planes.stride[1];
+    for (uint32_t y = 0; y < box_height / 2; y++) {
+        kernels.shade_row(chroma + (y0 / 2 + y) * chroma_stride + x0, box_width, alpha, CHROMA_GREY);
+    }
+    for (uint32_t y = 0; y < cell / 2; y++) {
+        uint8_t *row = chroma + ((y0 + padding) / 2 + y) * chroma_stride + x0 + padding;
+        for (size_t i = 0; i < count; i++) {
+            const uint8_t *mask = &m_chroma_glyphs[(static_cast<size_t>(glyphs[i]) * cell / 2 + y) * cell];
+            kernels.stamp_row(row + i * cell, mask, cell, CHROMA_GREY);
+        }
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include "inception_v3_image.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct InceptionV3OverlayStyle
+{
+    uint32_t scale = 2;         // glyphs are 8 x 8 font pixels, drawn scale x scale each
+    uint32_t x = 8;             // top-left corner of the label box in the frame
+    uint32_t y = 8;
+    uint8_t box_alpha = 160;    // opacity of the dark box behind the text, out of 256
+};
+
+// Where each plane of a frame starts in its buffer and its row pitch in bytes, as
+// GstVideoMeta or GstVideoInfo report them. Plane 1 is NV12's interleaved chroma;
+// RGB uses plane 0 only.
+struct InceptionV3FramePlanes
+{
+    size_t offset[2];
+    size_t stride[2];
+};
+
+// Planes of a frame whose rows are stride bytes apart (0 = tightly packed), with
+// the NV12 chroma plane directly after the luma plane.
+InceptionV3FramePlanes inception_v3_packed_planes(InceptionV3PixelFormat format, uint32_t width, uint32_t height,
+                                                  size_t stride = 0);
+
+// Draws "<label> <confidence>%" into a frame in place, replacing hailooverlay and
+// the videoconvert that followed it on the display branch.
+//
+// The embedded 8x8 font is rasterized once into per-format glyph masks (packed
+// RGB, NV12 luma and NV12 interleaved chroma), and every label of the label store
+// is laid out into a glyph run up front. Drawing is then one alpha shade of the
+// box rows plus a masked select per glyph row, both byte loops over contiguous
+// memory built per instruction set (inception_v3_kernels.hpp). NV12 frames are drawn in NV12,
+// so no conversion is needed before or after.
+class InceptionV3Overlay
+{
+public:
+    explicit InceptionV3Overlay(const std::vector<std::string> &labels,
+                                const InceptionV3OverlayStyle &style = InceptionV3OverlayStyle());
+
+    void draw(uint8_t *frame, InceptionV3PixelFormat format, uint32_t width, uint32_t height,
+              const InceptionV3FramePlanes &planes, const std::string &label, float confidence) const;
+
+    // stride is the row pitch in bytes; for NV12 it applies to both planes and
+    // the chroma plane follows the luma plane directly.
+    void draw(uint8_t *frame, InceptionV3PixelFormat format, uint32_t width, uint32_t height, size_t stride,
+              const std::string &label, float confidence) const
+    {
+        draw(frame, format, width, height, inception_v3_packed_planes(format, width, height, stride), label,
+             confidence);
+    }
+
+    // Text without a confidence, e.g. a status line.
+    void draw_text(uint8_t *frame, InceptionV3PixelFormat format, uint32_t width, uint32_t height, size_t stride,
+                   const std::string &text) const;
+
+private:
+    void layout(const std::string &text, std::vector<uint8_t> &glyphs) const;
+    void draw_glyphs(uint8_t *frame, InceptionV3PixelFormat format, uint32_t width, uint32_t height,
+                     const InceptionV3FramePlanes &planes, const uint8_t *glyphs, size_t count) const;
+
+    InceptionV3OverlayStyle m_style;
+    uint32_t m_cell;            // glyph cell side in frame pixels
+    uint32_t m_padding;         // box margin around the text, even so NV12 chroma stays aligned
+    std::vector<uint8_t> m_rgb_glyphs;      // per glyph: cell rows of cell * 3 bytes, 0x00 or 0xff
+    std::vector<uint8_t> m_luma_glyphs;     // per glyph: cell rows of cell bytes
+    std::vector<uint8_t> m_chroma_glyphs;   // per glyph: cell / 2 rows of cell bytes (U and V pairs)
+    std::unordered_map<std::string, std::vector<uint8_t>> m_label_runs;
+};
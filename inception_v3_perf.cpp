@@ -0,0 +1,272 @@
+#include "inception_v3_perf.hpp"
+#include <atomic>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <linux/perf_event.h>
+#include <sstream>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace
+{
+const uint64_t COUNTER_CONFIGS[INCEPTION_V3_PERF_COUNTER_COUNT] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+struct StageTotals
+{
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> counters[INCEPTION_V3_PERF_COUNTER_COUNT] = {};
+    std::atomic<uint64_t> counter_enabled_ns{0};
+    std::atomic<uint64_t> counter_running_ns{0};
+    std::atomic<uint64_t> cpu_time_ns{0};
+    std::atomic<uint64_t> wall_time_ns{0};
+};
+
+std::atomic<bool> g_enabled{false};
+StageTotals g_totals[INCEPTION_V3_PERF_STAGE_COUNT];
+
+// Counters some measuring thread could not open (bit per InceptionV3PerfCounter),
+// and how many threads opened a group at all.
+std::atomic<uint32_t> g_missing_counters{0};
+std::atomic<uint32_t> g_counting_threads{0};
+
+uint64_t clock_ns(clockid_t clock)
+{
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// The calling thread's counter group, opened on its first measured scope and
+// closed at thread exit, so a long-lived stage thread opens it once. One read()
+// returns every counter of the group plus the time it was enabled and running.
+struct ThreadCounters
+{
+    bool opened = false;
+    int fds[INCEPTION_V3_PERF_COUNTER_COUNT] = {-1, -1, -1, -1};
+    int positions[INCEPTION_V3_PERF_COUNTER_COUNT] = {-1, -1, -1, -1};  // index in the group read
+    int leader = -1;
+    int members = 0;
+
+    void open()
+    {
+        opened = true;
+        uint32_t missing = 0;
+        for (int counter = 0; counter < INCEPTION_V3_PERF_COUNTER_COUNT; counter++) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = COUNTER_CONFIGS[counter];
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+
+            int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader, PERF_FLAG_FD_CLOEXEC));
+            if (fd < 0) {
+                missing |= 1u << counter;
+                continue;
+            }
+            if (leader < 0) {
+                leader = fd;
+            }
+            fds[counter] = fd;
+            positions[counter] = members++;
+        }
+        g_missing_counters.fetch_or(missing, std::memory_order_relaxed);
+        if (leader >= 0) {
+            g_counting_threads.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void read_values(uint64_t values[INCEPTION_V3_PERF_COUNTER_COUNT], uint64_t &enabled_ns, uint64_t &running_ns)
+    {
+        if (!opened) {
+            open();
+        }
+        // { nr, time_enabled, time_running, values[nr] }
+        uint64_t group[3 + INCEPTION_V3_PERF_COUNTER_COUNT] = {};
+        if (leader < 0 || read(leader, group, sizeof(group)) <= 0) {
+            std::memset(group, 0, sizeof(group));
+        }
+        enabled_ns = group[1];
+        running_ns = group[2];
+        for (int counter = 0; counter < INCEPTION_V3_PERF_COUNTER_COUNT; counter++) {
+            const int position = positions[counter];
+            values[counter] = position >= 0 && static_cast<uint64_t>(position) < group[0] ? group[3 + position] : 0;
+        }
+    }
+
+    ~ThreadCounters()
+    {
+        for (int fd : fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+};
+
+thread_local ThreadCounters t_counters;
+
+std::string per_frame(double value)
+{
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(1);
+    if (value >= 1e6) {
+        text << value / 1e6 << 'M';
+    } else if (value >= 1e3) {
+        text << value / 1e3 << 'k';
+    } else {
+        text << value;
+    }
+    return text.str();
+}
+} // namespace
+
+const char *inception_v3_perf_stage_name(InceptionV3PerfStage stage)
+{
+    switch (stage) {
+    case INCEPTION_V3_PERF_PREPROCESS:
+        return "preprocess";
+    case INCEPTION_V3_PERF_DEVICE_WRITE:
+        return "device_write";
+    case INCEPTION_V3_PERF_DEVICE_READ:
+        return "device_read";
+    case INCEPTION_V3_PERF_POSTPROCESS:
+        return "postprocess";
+    default:
+        return "unknown";
+    }
+}
+
+void inception_v3_perf_enable()
+{
+    for (auto &totals : g_totals) {
+        totals.calls = 0;
+        totals.frames = 0;
+        for (auto &counter : totals.counters) {
+            counter = 0;
+        }
+        totals.counter_enabled_ns = 0;
+        totals.counter_running_ns = 0;
+        totals.cpu_time_ns = 0;
+        totals.wall_time_ns = 0;
+    }
+    g_enabled.store(true, std::memory_order_release);
+}
+
+void inception_v3_perf_disable()
+{
+    g_enabled.store(false, std::memory_order_release);
+}
+
+bool inception_v3_perf_enabled()
+{
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+InceptionV3PerfTotals inception_v3_perf_totals(InceptionV3PerfStage stage)
+{
+    const StageTotals &source = g_totals[stage];
+    const bool counting = g_counting_threads.load(std::memory_order_relaxed) > 0;
+    const uint32_t missing = g_missing_counters.load(std::memory_order_relaxed);
+
+    InceptionV3PerfTotals totals;
+    totals.calls = source.calls.load(std::memory_order_relaxed);
+    totals.frames = source.frames.load(std::memory_order_relaxed);
+    for (int counter = 0; counter < INCEPTION_V3_PERF_COUNTER_COUNT; counter++) {
+        totals.counters[counter] = source.counters[counter].load(std::memory_order_relaxed);
+        totals.counter_available[counter] = counting && !(missing & (1u << counter));
+    }
+    totals.counter_enabled_ns = source.counter_enabled_ns.load(std::memory_order_relaxed);
+    totals.counter_running_ns = source.counter_running_ns.load(std::memory_order_relaxed);
+    totals.cpu_time_ns = source.cpu_time_ns.load(std::memory_order_relaxed);
+    totals.wall_time_ns = source.wall_time_ns.load(std::memory_order_relaxed);
+    return totals;
+}
+
+std::string inception_v3_perf_report()
+{
+    std::ostringstream report;
+    for (int stage = 0; stage < INCEPTION_V3_PERF_STAGE_COUNT; stage++) {
+        auto totals = inception_v3_perf_totals(static_cast<InceptionV3PerfStage>(stage));
+        report << inception_v3_perf_stage_name(static_cast<InceptionV3PerfStage>(stage)) << ": ";
+        if (totals.frames == 0) {
+            report << "no frames\n";
+            continue;
+        }
+        const double frames = static_cast<double>(totals.frames);
+        report << totals.frames << " frames, per frame " << std::fixed << std::setprecision(1)
+               << totals.cpu_time_ns / frames / 1e3 << " us cpu, " << totals.wall_time_ns / frames / 1e3 << " us wall";
+        static const char *names[INCEPTION_V3_PERF_COUNTER_COUNT] = {
+            "cycles", "instructions", "cache misses", "branch misses"};
+        for (int counter = 0; counter < INCEPTION_V3_PERF_COUNTER_COUNT; counter++) {
+            report << ", ";
+            if (totals.counter_available[counter]) {
+                report << per_frame(totals.counters[counter] / frames) << ' ' << names[counter];
+            } else {
+                report << names[counter] << " n/a";
+            }
+        }
+        if (totals.counter_available[INCEPTION_V3_PERF_CYCLES] &&
+            totals.counter_available[INCEPTION_V3_PERF_INSTRUCTIONS] && totals.counters[INCEPTION_V3_PERF_CYCLES]) {
+            report << ", IPC " << std::setprecision(2)
+                   << static_cast<double>(totals.counters[INCEPTION_V3_PERF_INSTRUCTIONS]) /
+                          totals.counters[INCEPTION_V3_PERF_CYCLES];
+        }
+        if (totals.counter_running_ns < totals.counter_enabled_ns) {
+            report << ", counters multiplexed (counting " << std::setprecision(0)
+                   << 100.0 * totals.counter_running_ns / totals.counter_enabled_ns << "% of the time, scaled)";
+        }
+        report << std::defaultfloat << '\n';
+    }
+    return report.str();
+}
+
+InceptionV3PerfScope::InceptionV3PerfScope(InceptionV3PerfStage stage, size_t frames)
+    : m_stage(stage), m_frames(frames), m_active(g_enabled.load(std::memory_order_relaxed))
+{
+    if (!m_active) {
+        return;
+    }
+    m_wall_time_ns = clock_ns(CLOCK_MONOTONIC);
+    m_cpu_time_ns = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+    t_counters.read_values(m_counters, m_counter_enabled_ns, m_counter_running_ns);
+}
+
+InceptionV3PerfScope::~InceptionV3PerfScope()
+{
+    if (!m_active) {
+        return;
+    }
+    uint64_t counters[INCEPTION_V3_PERF_COUNTER_COUNT];
+    uint64_t counter_enabled_ns;
+    uint64_t counter_running_ns;
+    t_counters.read_values(counters, counter_enabled_ns, counter_running_ns);
+    const uint64_t cpu_time_ns = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+    const uint64_t wall_time_ns = clock_ns(CLOCK_MONOTONIC);
+
+    StageTotals &totals = g_totals[m_stage];
+    totals.calls.fetch_add(1, std::memory_order_relaxed);
+    totals.frames.fetch_add(m_frames, std::memory_order_relaxed);
+    // A multiplexed group only counted for running out of enabled time; scale this
+    // scope's counts up to the whole scope, as perf stat does.
+    const uint64_t enabled = counter_enabled_ns - m_counter_enabled_ns;
+    const uint64_t running = counter_running_ns - m_counter_running_ns;
+    const double scale = running > 0 && running < enabled ? static_cast<double>(enabled) / running : 1.0;
+    for (int counter = 0; counter < INCEPTION_V3_PERF_COUNTER_COUNT; counter++) {
+        const uint64_t delta = counters[counter] - m_counters[counter];
+        totals.counters[counter].fetch_add(static_cast<uint64_t>(delta * scale), std::memory_order_relaxed);
+    }
+    totals.counter_enabled_ns.fetch_add(enabled, std::memory_order_relaxed);
+    totals.counter_running_ns.fetch_add(running, std::memory_order_relaxed);
+    totals.cpu_time_ns.fetch_add(cpu_time_ns - m_cpu_time_ns, std::memory_order_relaxed);
+    totals.wall_time_ns.fetch_add(wall_time_ns - m_wall_time_ns, std::memory_order_relaxed);
+}
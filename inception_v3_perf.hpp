@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Opt-in per-stage CPU cost accounting.
+//
+// Each instrumented stage is wrapped in an InceptionV3PerfScope. While
+// accounting is off a scope costs one relaxed atomic load. While it is on, the
+// scope reads the calling thread's hardware counter group (cycles, instructions,
+// cache misses, branch misses; opened with perf_event_open on the thread's first
+// scope, user space only so it works at the default perf_event_paranoid) and its
+// CLOCK_THREAD_CPUTIME_ID on entry and exit, and adds the difference to the stage
+// totals. Counters the PMU or kernel refuses read as unavailable, the CPU time is
+// always there. When more events are open than the PMU has counters, the kernel
+// time-shares them; each scope's counts are then scaled by the fraction of its
+// time the group was on the PMU, and the report flags the stage as multiplexed.
+
+enum InceptionV3PerfStage
+{
+    INCEPTION_V3_PERF_PREPROCESS,
+    INCEPTION_V3_PERF_DEVICE_WRITE,
+    INCEPTION_V3_PERF_DEVICE_READ,
+    INCEPTION_V3_PERF_POSTPROCESS,
+    INCEPTION_V3_PERF_STAGE_COUNT,
+};
+
+enum InceptionV3PerfCounter
+{
+    INCEPTION_V3_PERF_CYCLES,
+    INCEPTION_V3_PERF_INSTRUCTIONS,
+    INCEPTION_V3_PERF_CACHE_MISSES,
+    INCEPTION_V3_PERF_BRANCH_MISSES,
+    INCEPTION_V3_PERF_COUNTER_COUNT,
+};
+
+const char *inception_v3_perf_stage_name(InceptionV3PerfStage stage);
+
+struct InceptionV3PerfTotals
+{
+    uint64_t calls = 0;
+    uint64_t frames = 0;
+    uint64_t counters[INCEPTION_V3_PERF_COUNTER_COUNT] = {};
+    bool counter_available[INCEPTION_V3_PERF_COUNTER_COUNT] = {};
+    // Time the counter group was enabled and actually counting inside the scopes;
+    // running < enabled means the counts above are multiplexing estimates.
+    uint64_t counter_enabled_ns = 0;
+    uint64_t counter_running_ns = 0;
+    uint64_t cpu_time_ns = 0;   // thread CPU time, user + system
+    uint64_t wall_time_ns = 0;
+};
+
+// Zeroes the totals and turns accounting on or off for every thread.
+void inception_v3_perf_enable();
+void inception_v3_perf_disable();
+bool inception_v3_perf_enabled();
+
+InceptionV3PerfTotals inception_v3_perf_totals(InceptionV3PerfStage stage);
+
+// Per-frame cost of every stage, one line each.
+std::string inception_v3_perf_report();
+
+class InceptionV3PerfScope
+{
+public:
+    InceptionV3PerfScope(InceptionV3PerfStage stage, size_t frames);
+    ~InceptionV3PerfScope();
+
+    InceptionV3PerfScope(const InceptionV3PerfScope &) = delete;
+    InceptionV3PerfScope &operator=(const InceptionV3PerfScope &) = delete;
+
+private:
+    InceptionV3PerfStage m_stage;
+    size_t m_frames;
+    bool m_active;
+    uint64_t m_counters[INCEPTION_V3_PERF_COUNTER_COUNT];
+    uint64_t m_counter_enabled_ns;
+    uint64_t m_counter_running_ns;
+    uint64_t m_cpu_time_ns;
+    uint64_t m_wall_time_ns;
+};
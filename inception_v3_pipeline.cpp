@@ -0,0 +1,307 @@
+#include "inception_v3_pipeline.hpp"
+#include "inception_v3_perf.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+InceptionV3Pipeline::InceptionV3Pipeline(InceptionV3Runner &runner, const InceptionV3PipelineConfig &config,
+                                         ResultCallback callback)
+    : m_runner(runner), m_config(config), m_callback(std::move(callback)), m_stopping(false), m_captured(0),
+      m_dropped(0), m_completed(0), m_offloaded(0)
+{
+    m_config.preprocess_threads = std::max<size_t>(m_config.preprocess_threads, 1);
+    m_config.batch_size = std::max<size_t>(m_config.batch_size, 1);
+    m_config.queue_depth = std::max<size_t>(m_config.queue_depth, 1);
+
+    auto input_info = m_runner.backend().input_info();
+    m_network_width = input_info.shape.width;
+    m_network_height = input_info.shape.height;
+
+    if (m_config.overflow_backend) {
+        auto &overflow = *m_config.overflow_backend;
+        if (overflow.input_frame_size() != m_runner.input_frame_size() ||
+            overflow.output_frame_size() != m_runner.output_frame_size()) {
+            throw std::invalid_argument("overflow backend tensors do not match the device's");
+        }
+        if (m_config.overflow_threshold == 0) {
+            m_config.overflow_threshold = m_config.queue_depth;
+        }
+    }
+}
+
+void InceptionV3Pipeline::add_source(std::unique_ptr<InceptionV3FrameSource> source)
+{
+    m_sources.push_back(std::move(source));
+}
+
+InceptionV3PipelineStats InceptionV3Pipeline::stats() const
+{
+    InceptionV3PipelineStats stats;
+    stats.captured = m_captured;
+    stats.dropped = m_dropped;
+    stats.completed = m_completed;
+    stats.offloaded = m_offloaded;
+    return stats;
+}
+
+std::vector<std::string> InceptionV3Pipeline::placement_report() const
+{
+    std::lock_guard<std::mutex> lock(m_placement_mutex);
+    return m_placement_report;
+}
+
+void InceptionV3Pipeline::place_thread(InceptionV3Stage stage, size_t index, const char *thread_name)
+{
+    std::string name = thread_name ? thread_name : std::string("iv3-") + inception_v3_stage_name(stage);
+    if (!thread_name && (stage == INCEPTION_V3_STAGE_CAPTURE || stage == INCEPTION_V3_STAGE_PREPROCESS)) {
+        name += "-" + std::to_string(index);
+    }
+    auto report = apply_inception_v3_placement(m_config.placement.stages[stage], index, name);
+
+    std::lock_guard<std::mutex> lock(m_placement_mutex);
+    m_placement_report.push_back(report);
+}
+
+void InceptionV3Pipeline::stop()
+{
+    m_stopping = true;
+}
+
+void InceptionV3Pipeline::fail(std::exception_ptr error)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_error_mutex);
+        if (!m_error) {
+            m_error = error;
+        }
+    }
+    m_stopping = true;
+    for (auto &source : m_sources) {
+        source->close();
+    }
+    m_frame_pool->close();
+    m_job_pool->close();
+    m_capture_queue->close();
+    m_device_queue->close();
+    if (m_overflow_queue) {
+        m_overflow_queue->close();
+    }
+    m_postprocess_queue->close();
+}
+
+void InceptionV3Pipeline::run()
+{
+    const size_t depth = m_config.queue_depth;
+    const size_t frames = depth + m_sources.size() + m_config.preprocess_threads;
+    // The overflow path holds at most one queued and one running job.
+    const size_t overflow_jobs = m_config.overflow_backend ? 2 : 0;
+    const size_t jobs = 2 * depth + 2 * m_config.batch_size + m_config.preprocess_threads + overflow_jobs;
+
+    m_frame_pool.reset(new InceptionV3Queue<FramePtr>(frames));
+    m_job_pool.reset(new InceptionV3Queue<JobPtr>(jobs));
+    m_capture_queue.reset(new InceptionV3Queue<FramePtr>(depth));
+    m_device_queue.reset(new InceptionV3Queue<JobPtr>(std::max(depth, m_config.batch_size)));
+    m_postprocess_queue.reset(new InceptionV3Queue<JobPtr>(std::max(depth, m_config.batch_size)));
+    m_overflow_queue.reset(m_config.overflow_backend ? new InceptionV3Queue<JobPtr>(1) : nullptr);
+
+    for (size_t i = 0; i < frames; i++) {
+        m_frame_pool->push(FramePtr(new InceptionV3Frame()));
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_placement_mutex);
+        m_placement_report.clear();
+    }
+
+    for (size_t i = 0; i < jobs; i++) {
+        JobPtr job(new Job());
+        job->input.resize(m_runner.input_frame_size());
+        job->output.resize(m_runner.output_frame_size());
+        m_job_pool->push(std::move(job));
+    }
+
+    std::vector<std::thread> capture_threads;
+    for (size_t i = 0; i < m_sources.size(); i++) {
+        capture_threads.emplace_back(&InceptionV3Pipeline::capture_loop, this, std::ref(*m_sources[i]), i);
+    }
+    std::vector<std::thread> preprocess_threads;
+    for (size_t i = 0; i < m_config.preprocess_threads; i++) {
+        preprocess_threads.emplace_back(&InceptionV3Pipeline::preprocess_loop, this, i);
+    }
+    std::thread device_thread(&InceptionV3Pipeline::device_loop, this);
+    std::thread overflow_thread;
+    if (m_overflow_queue) {
+        overflow_thread = std::thread(&InceptionV3Pipeline::overflow_loop, this);
+    }
+    std::thread postprocess_thread(&InceptionV3Pipeline::postprocess_loop, this);
+
+    // Shut down front to back so every frame already captured is delivered.
+    for (auto &thread : capture_threads) {
+        thread.join();
+    }
+    m_capture_queue->close();
+    for (auto &thread : preprocess_threads) {
+        thread.join();
+    }
+    m_device_queue->close();
+    device_thread.join();
+    if (overflow_thread.joinable()) {
+        m_overflow_queue->close();
+        overflow_thread.join();
+    }
+    m_postprocess_queue->close();
+    postprocess_thread.join();
+
+    if (m_error) {
+        std::rethrow_exception(m_error);
+    }
+}
+
+void InceptionV3Pipeline::capture_loop(InceptionV3FrameSource &source, size_t index)
+{
+    try {
+        place_thread(INCEPTION_V3_STAGE_CAPTURE, index);
+        const bool live = source.live();
+        FramePtr frame;
+        while (!m_stopping && m_frame_pool->pop(frame)) {
+            if (!source.next(*frame)) {
+                m_frame_pool->push(std::move(frame));
+                break;
+            }
+            m_captured++;
+
+            if (live) {
+                if (!m_capture_queue->try_push(frame)) {
+                    m_dropped++;
+                    m_frame_pool->push(std::move(frame));
+                }
+            } else if (!m_capture_queue->push(std::move(frame))) {
+                break;
+            }
+        }
+    } catch (...) {
+        fail(std::current_exception());
+    }
+}
+
+void InceptionV3Pipeline::preprocess_loop(size_t index)
+{
+    try {
+        place_thread(INCEPTION_V3_STAGE_PREPROCESS, index);
+        FramePtr frame;
+        JobPtr job;
+        while (m_capture_queue->pop(frame)) {
+            if (!m_job_pool->pop(job)) {
+                break;
+            }
+
+            job->stream_id = frame->stream_id;
+            job->seq = frame->seq;
+            job->capture_time_ns = frame->capture_time_ns;
+            job->pts_ns = frame->pts_ns;
+            {
+                InceptionV3PerfScope cost(INCEPTION_V3_PERF_PREPROCESS, 1);
+                resize_frame_to_rgb(frame->data.data(), frame->format, frame->width, frame->height,
+                                    job->input.data(), m_network_width, m_network_height);
+            }
+
+            m_frame_pool->push(std::move(frame));
+
+            // Overflow policy: with the device backlog at the threshold, the frame
+            // goes to the overflow backend if that one is free to take it.
+            job->offloaded = false;
+            if (m_overflow_queue && m_device_queue->size() >= m_config.overflow_threshold) {
+                job->offloaded = true;
+                if (m_overflow_queue->try_push(job)) {
+                    continue;
+                }
+                job->offloaded = false;
+            }
+            if (!m_device_queue->push(std::move(job))) {
+                break;
+            }
+        }
+    } catch (...) {
+        fail(std::current_exception());
+    }
+}
+
+void InceptionV3Pipeline::device_loop()
+{
+    try {
+        place_thread(INCEPTION_V3_STAGE_DEVICE_IO, 0);
+        std::vector<JobPtr> batch;
+        std::vector<uint8_t *> inputs;
+        std::vector<uint8_t *> outputs;
+        while (m_device_queue->pop_many(batch, m_config.batch_size) > 0) {
+            inputs.clear();
+            outputs.clear();
+            for (auto &job : batch) {
+                inputs.push_back(job->input.data());
+                outputs.push_back(job->output.data());
+            }
+
+            m_runner.backend().infer(inputs, outputs);
+
+            for (auto &job : batch) {
+                if (!m_postprocess_queue->push(std::move(job))) {
+                    return;
+                }
+            }
+        }
+    } catch (...) {
+        fail(std::current_exception());
+    }
+}
+
+void InceptionV3Pipeline::overflow_loop()
+{
+    try {
+        // CPU inference is host compute like preprocess, so it follows that placement.
+        place_thread(INCEPTION_V3_STAGE_PREPROCESS, m_config.preprocess_threads, "iv3-overflow");
+        JobPtr job;
+        std::vector<uint8_t *> inputs(1);
+        std::vector<uint8_t *> outputs(1);
+        while (m_overflow_queue->pop(job)) {
+            inputs[0] = job->input.data();
+            outputs[0] = job->output.data();
+            m_config.overflow_backend->infer(inputs, outputs);
+
+            m_offloaded++;
+            if (!m_postprocess_queue->push(std::move(job))) {
+                return;
+            }
+        }
+    } catch (...) {
+        fail(std::current_exception());
+    }
+}
+
+void InceptionV3Pipeline::postprocess_loop()
+{
+    try {
+        place_thread(INCEPTION_V3_STAGE_POSTPROCESS, 0);
+        JobPtr job;
+        InceptionV3PipelineResult result;
+        while (m_postprocess_queue->pop(job)) {
+            // Recorded here rather than at the device so that frames the overflow
+            // backend took are in the recording too; the one thread is the single writer.
+            if (m_config.recorder) {
+                m_config.recorder->append(job->stream_id, job->seq, job->capture_time_ns, job->input.data());
+            }
+            result.stream_id = job->stream_id;
+            result.seq = job->seq;
+            result.capture_time_ns = job->capture_time_ns;
+            result.pts_ns = job->pts_ns;
+            result.offloaded = job->offloaded;
+            result.result = m_runner.postprocess(job->output.data());
+            result.done_time_ns = inception_v3_now_ns();
+
+            m_job_pool->push(std::move(job));
+            m_completed++;
+            if (m_callback) {
+                m_callback(result);
+            }
+        }
+    } catch (...) {
+        fail(std::current_exception());
+    }
+}
@@ -0,0 +1,135 @@
+#pragma once
+#include "inception_v3_affinity.hpp"
+#include "inception_v3_queue.hpp"
+#include "inception_v3_runner.hpp"
+#include "inception_v3_source.hpp"
+#include "inception_v3_tensor_file.hpp"
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct InceptionV3PipelineConfig
+{
+    size_t preprocess_threads = 2;
+    size_t batch_size = 1;      // frames handed to the backend per infer() call
+    size_t queue_depth = 4;     // capacity of each inter-stage queue
+    InceptionV3ThreadPlacement placement;
+    InceptionV3TensorRecorder *recorder = nullptr;  // when set, every tensor inferred (device or overflow) is recorded
+
+    // Overflow offload: when set, a preprocessed frame that finds at least
+    // overflow_threshold tensors already waiting for the device goes to this
+    // backend (e.g. InceptionV3CpuBackend) instead, as long as it is free. Its
+    // tensor sizes must match the runner's backend.
+    InceptionV3Backend *overflow_backend = nullptr;
+    size_t overflow_threshold = 0;  // 0 = queue_depth, i.e. only when the device queue is full
+};
+
+struct InceptionV3PipelineResult
+{
+    uint32_t stream_id = 0;
+    uint64_t seq = 0;
+    uint64_t capture_time_ns = 0;
+    uint64_t pts_ns = 0;        // the frame's InceptionV3Frame::pts_ns
+    uint64_t done_time_ns = 0;
+    bool offloaded = false;     // inferred on the overflow backend
+    InceptionV3Result result;
+};
+
+struct InceptionV3PipelineStats
+{
+    uint64_t captured = 0;
+    uint64_t dropped = 0;       // live-source frames discarded because the pipeline was full
+    uint64_t completed = 0;
+    uint64_t offloaded = 0;     // frames inferred on the overflow backend
+};
+
+// Native counterpart of the GStreamer graph:
+//
+//   source threads -> capture queue -> preprocess workers -> device queue ->
+//   device I/O thread (batches) -> postprocess queue -> postprocess thread -> callback
+//
+// With an overflow backend, a preprocess worker that finds the device queue at
+// the threshold hands its tensor to the overflow thread instead, which runs it on
+// that backend and feeds the same postprocess queue. Offload exists only here:
+// the daemon, the shm ring service and the GStreamer graph run every frame on
+// the device.
+//
+// Results are delivered in completion order, not capture order. An offloaded
+// frame usually finishes after device frames captured later, and with several
+// preprocess workers neighbouring frames can already swap. Consumers that need
+// a stream's results in order sort them by (stream_id, seq).
+//
+// Frame and tensor buffers come from fixed pools sized from the config, so the
+// steady state allocates nothing per frame.
+class InceptionV3Pipeline
+{
+public:
+    using ResultCallback = std::function<void(const InceptionV3PipelineResult &)>;
+
+    InceptionV3Pipeline(InceptionV3Runner &runner, const InceptionV3PipelineConfig &config, ResultCallback callback);
+
+    void add_source(std::unique_ptr<InceptionV3FrameSource> source);
+
+    // Runs until every source is exhausted (or stop() is called) and all frames
+    // in flight have been delivered. Rethrows the first stage failure.
+    void run();
+    void stop();
+
+    InceptionV3PipelineStats stats() const;
+
+    // Effective placement of every stage thread of the last run(), one line each.
+    std::vector<std::string> placement_report() const;
+
+private:
+    struct Job
+    {
+        uint32_t stream_id = 0;
+        uint64_t seq = 0;
+        uint64_t capture_time_ns = 0;
+        uint64_t pts_ns = 0;
+        bool offloaded = false;
+        std::vector<uint8_t> input;
+        std::vector<uint8_t> output;
+    };
+    using FramePtr = std::unique_ptr<InceptionV3Frame>;
+    using JobPtr = std::unique_ptr<Job>;
+
+    void place_thread(InceptionV3Stage stage, size_t index, const char *thread_name = nullptr);
+    void capture_loop(InceptionV3FrameSource &source, size_t index);
+    void preprocess_loop(size_t index);
+    void device_loop();
+    void overflow_loop();
+    void postprocess_loop();
+    void fail(std::exception_ptr error);
+
+    InceptionV3Runner &m_runner;
+    InceptionV3PipelineConfig m_config;
+    ResultCallback m_callback;
+    std::vector<std::unique_ptr<InceptionV3FrameSource>> m_sources;
+
+    uint32_t m_network_width;
+    uint32_t m_network_height;
+
+    std::unique_ptr<InceptionV3Queue<FramePtr>> m_frame_pool;
+    std::unique_ptr<InceptionV3Queue<JobPtr>> m_job_pool;
+    std::unique_ptr<InceptionV3Queue<FramePtr>> m_capture_queue;
+    std::unique_ptr<InceptionV3Queue<JobPtr>> m_device_queue;
+    std::unique_ptr<InceptionV3Queue<JobPtr>> m_overflow_queue;
+    std::unique_ptr<InceptionV3Queue<JobPtr>> m_postprocess_queue;
+
+    std::atomic<bool> m_stopping;
+    std::atomic<uint64_t> m_captured;
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<uint64_t> m_completed;
+    std::atomic<uint64_t> m_offloaded;
+
+    std::mutex m_error_mutex;
+    std::exception_ptr m_error;
+
+    mutable std::mutex m_placement_mutex;
+    std::vector<std::string> m_placement_report;
+};
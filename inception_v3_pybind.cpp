@@ -0,0 +1,232 @@
+#include "inception_v3_metadata_map.hpp"
+#include "inception_v3_overlay.hpp"
+#include "inception_v3_runner.hpp"
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace py = pybind11;
+
+namespace
+{
+// Python-facing classifier: one configured runner plus its params, fed straight
+// from caller memory. Frames are never copied on the way in, and the GIL is
+// released for the whole device round trip so other Python threads keep running.
+// The runner, its backend and their scratch buffers are shared, so concurrent
+// classify() calls on one object take turns on m_mutex; use one classifier per
+// thread (each with its own device) to classify in parallel.
+class PyInceptionV3Classifier
+{
+public:
+    PyInceptionV3Classifier(const std::string &hef_path, const std::string &labels_file,
+                            float confidence_threshold, size_t batch_size)
+        : m_params(init_inception_v3(labels_file, confidence_threshold), free_resources),
+          m_runner(hef_path, m_params.get()), m_batch_size(std::max<size_t>(batch_size, 1))
+    {}
+
+    size_t frame_size() const { return m_runner.input_frame_size(); }
+    const std::vector<std::string> &labels() const { return m_params->labels; }
+
+    // frames: any C-contiguous uint8 buffer holding N network-resolution frames
+    // (N x 299 x 299 x 3, or a single 299 x 299 x 3 frame); read-only ones are copied.
+    // Returns (class_ids int32[N, top_k], confidences float32[N, top_k]).
+    py::tuple classify(py::buffer frames, size_t top_k)
+    {
+        top_k = std::min<size_t>(std::max<size_t>(top_k, 1), INCEPTION_V3_TOP_K);
+
+        py::buffer_info info = frames.request();
+        if (info.itemsize != 1) {
+            throw std::invalid_argument("frames must be a uint8 buffer");
+        }
+        ssize_t expected_stride = 1;
+        for (ssize_t dim = info.ndim - 1; dim >= 0; dim--) {
+            if (info.shape[dim] > 1 && info.strides[dim] != expected_stride) {
+                throw std::invalid_argument("frames must be C-contiguous");
+            }
+            expected_stride *= info.shape[dim];
+        }
+
+        const size_t frame_bytes = m_runner.input_frame_size();
+        const size_t total_bytes = static_cast<size_t>(info.size);
+        if (total_bytes == 0 || total_bytes % frame_bytes != 0) {
+            throw std::invalid_argument("frames size is not a multiple of the network input size (" +
+                                        std::to_string(frame_bytes) + " bytes)");
+        }
+        const size_t count = total_bytes / frame_bytes;
+
+        py::array_t<int32_t> ids({count, top_k});
+        py::array_t<float> confidences({count, top_k});
+        int32_t *ids_out = ids.mutable_data();
+        float *confidences_out = confidences.mutable_data();
+
+        // Preprocess runs in place on the frames, so a read-only buffer (bytes, a
+        // read-only mapped GstBuffer) is copied into an owned one first; writable
+        // buffers are used as they are.
+        std::vector<uint8_t> owned;
+        auto *base = static_cast<uint8_t *>(info.ptr);
+        if (info.readonly) {
+            owned.assign(base, base + total_bytes);
+            base = owned.data();
+        }
+        {
+            // The GIL is dropped before taking the lock, so a thread waiting here
+            // never holds up the one that owns the runner.
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            std::vector<uint8_t *> batch;
+            for (size_t first = 0; first < count; first += m_batch_size) {
+                size_t last = std::min(count, first + m_batch_size);
+                batch.clear();
+                for (size_t i = first; i < last; i++) {
+                    batch.push_back(base + i * frame_bytes);
+                }
+
+                auto results = m_runner.classify_batch(batch);
+                for (size_t i = 0; i < results.size(); i++) {
+                    size_t row = (first + i) * top_k;
+                    for (size_t k = 0; k < top_k; k++) {
+                        bool present = k < results[i].top_k_count;
+                        ids_out[row + k] = present ? results[i].top_k_ids[k] : -1;
+                        confidences_out[row + k] = present ? results[i].top_k_confidences[k] : 0.0f;
+                    }
+                }
+            }
+        }
+
+        return py::make_tuple(ids, confidences);
+    }
+
+private:
+    std::unique_ptr<InceptionV3Params, void (*)(void *)> m_params;
+    InceptionV3Runner m_runner;
+    size_t m_batch_size;
+    std::mutex m_mutex;
+};
+
+// Label overlay for the display branch: draws straight into a mapped, writable
+// GstBuffer (RGB or NV12) from a pad probe, so the graph needs neither
+// hailooverlay nor a videoconvert after it.
+class PyInceptionV3Overlay
+{
+public:
+    PyInceptionV3Overlay(const std::string &labels_file, uint32_t scale, uint32_t x, uint32_t y, uint8_t box_alpha)
+        : m_overlay(load_labels(labels_file), make_style(scale, x, y, box_alpha))
+    {}
+
+    // frame: a writable uint8 buffer of one width x height frame in format, rows
+    // stride bytes apart (0 = tightly packed). offsets and strides, when given,
+    // are the per-plane values of the buffer's GstVideoMeta or GstVideoInfo and
+    // override stride, so padded planes and a chroma plane that does not follow
+    // the luma rows directly are drawn where they really are.
+    void draw(py::buffer frame, const std::string &format_name, uint32_t width, uint32_t height,
+              const std::string &label, float confidence, size_t stride, const std::vector<size_t> &offsets,
+              const std::vector<size_t> &strides)
+    {
+        InceptionV3PixelFormat format;
+        if (!parse_inception_v3_pixel_format(format_name, format)) {
+            throw std::invalid_argument("overlay supports RGB and NV12 frames, not " + format_name);
+        }
+        const size_t plane_count = format == INCEPTION_V3_FORMAT_RGB ? 1 : 2;
+        InceptionV3FramePlanes planes = inception_v3_packed_planes(format, width, height, stride);
+        if (!offsets.empty() || !strides.empty()) {
+            if (offsets.size() < plane_count || strides.size() < plane_count) {
+                throw std::invalid_argument(format_name + " needs the offset and stride of " +
+                                            std::to_string(plane_count) + " planes");
+            }
+            for (size_t plane = 0; plane < plane_count; plane++) {
+                planes.offset[plane] = offsets[plane];
+                planes.stride[plane] = strides[plane];
+            }
+        }
+
+        py::buffer_info info = frame.request(true);
+        const size_t rows[2] = {height, static_cast<size_t>(height) / 2};
+        for (size_t plane = 0; plane < plane_count; plane++) {
+            const size_t end = planes.offset[plane] + planes.stride[plane] * rows[plane];
+            if (info.itemsize != 1 || static_cast<size_t>(info.size) < end) {
+                throw std::invalid_argument("frame buffer is smaller than a " + format_name + " frame of that layout");
+            }
+        }
+
+        py::gil_scoped_release release;
+        m_overlay.draw(static_cast<uint8_t *>(info.ptr), format, width, height, planes, label, confidence);
+    }
+
+private:
+    static std::vector<std::string> load_labels(const std::string &labels_file)
+    {
+        std::unique_ptr<InceptionV3Params, void (*)(void *)> params(init_inception_v3(labels_file, 0.0f),
+                                                                    free_resources);
+        return params->labels;
+    }
+
+    static InceptionV3OverlayStyle make_style(uint32_t scale, uint32_t x, uint32_t y, uint8_t box_alpha)
+    {
+        InceptionV3OverlayStyle style;
+        style.scale = scale;
+        style.x = x;
+        style.y = y;
+        style.box_alpha = box_alpha;
+        return style;
+    }
+
+    InceptionV3Overlay m_overlay;
+};
+
+// (key, label, confidence, class_id) of a metadata map entry, or None.
+py::object metadata_tuple(bool found, const InceptionV3FrameMetadata &metadata)
+{
+    if (!found) {
+        return py::none();
+    }
+    return py::make_tuple(metadata.key, std::string(metadata.label), metadata.confidence, metadata.class_id);
+}
+}
+
+PYBIND11_MODULE(inception_v3, m)
+{
+    m.doc() = "Batched Inception-v3 classification on a Hailo device";
+
+    py::class_<PyInceptionV3Classifier>(m, "Classifier")
+        .def(py::init<const std::string &, const std::string &, float, size_t>(),
+             py::arg("hef_path"), py::arg("labels_file") = "./imagenet_classes.txt",
+             py::arg("confidence_threshold") = 0.5f, py::arg("batch_size") = 8)
+        .def_property_readonly("frame_size", &PyInceptionV3Classifier::frame_size)
+        .def_property_readonly("labels", &PyInceptionV3Classifier::labels)
+        .def("classify", &PyInceptionV3Classifier::classify, py::arg("frames"),
+             py::arg("top_k") = INCEPTION_V3_TOP_K,
+             "Classifies N network-resolution uint8 frames, without copying them unless the buffer is read-only.\n"
+             "Returns (class_ids int32[N, top_k], confidences float32[N, top_k]).");
+
+    py::class_<PyInceptionV3Overlay>(m, "Overlay")
+        .def(py::init<const std::string &, uint32_t, uint32_t, uint32_t, uint8_t>(),
+             py::arg("labels_file") = "./imagenet_classes.txt", py::arg("scale") = 2, py::arg("x") = 8,
+             py::arg("y") = 8, py::arg("box_alpha") = 160)
+        .def("draw", &PyInceptionV3Overlay::draw, py::arg("frame"), py::arg("format"), py::arg("width"),
+             py::arg("height"), py::arg("label"), py::arg("confidence"), py::arg("stride") = 0,
+             py::arg("offsets") = std::vector<size_t>(), py::arg("strides") = std::vector<size_t>(),
+             "Draws '<label> <confidence>%' into a writable RGB or NV12 frame in place; offsets and strides are "
+             "the per-plane layout from GstVideoMeta or GstVideoInfo.");
+
+    py::class_<InceptionV3MetadataMap>(m, "MetadataMap")
+        .def(py::init<size_t>(), py::arg("capacity") = 64)
+        .def("publish",
+             py::overload_cast<uint64_t, const std::string &, float, int32_t>(&InceptionV3MetadataMap::publish),
+             py::arg("key"), py::arg("label"), py::arg("confidence"), py::arg("class_id") = -1,
+             "Publishes the result of frame key (PTS or sequence number); keys must increase.")
+        .def("find", [](const InceptionV3MetadataMap &map, uint64_t key) {
+                 InceptionV3FrameMetadata metadata;
+                 return metadata_tuple(map.find(key, metadata), metadata);
+             }, py::arg("key"), "(key, label, confidence, class_id) of exactly this frame, or None.")
+        .def("lookup", [](const InceptionV3MetadataMap &map, uint64_t key, uint64_t max_lag) {
+                 InceptionV3FrameMetadata metadata;
+                 return metadata_tuple(map.lookup(key, max_lag, metadata), metadata);
+             }, py::arg("key"), py::arg("max_lag"),
+             "The frame's own result, else the latest one if at most max_lag behind key, else None.");
+}
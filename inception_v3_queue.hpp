@@ -0,0 +1,94 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// Bounded blocking queue between pipeline stages. close() wakes every waiter;
+// pop() keeps draining queued items after close and fails once the queue is empty.
+template <typename T>
+class InceptionV3Queue
+{
+public:
+    explicit InceptionV3Queue(size_t capacity) : m_capacity(capacity > 0 ? capacity : 1), m_closed(false) {}
+
+    bool push(T item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_full.wait(lock, [this]() { return m_items.size() < m_capacity || m_closed; });
+        if (m_closed) {
+            return false;
+        }
+        m_items.push_back(std::move(item));
+        lock.unlock();
+        m_not_empty.notify_one();
+        return true;
+    }
+
+    // Non-blocking push; hands the item back through `item` when the queue is full.
+    bool try_push(T &item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_items.size() >= m_capacity || m_closed) {
+            return false;
+        }
+        m_items.push_back(std::move(item));
+        lock.unlock();
+        m_not_empty.notify_one();
+        return true;
+    }
+
+    bool pop(T &item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_empty.wait(lock, [this]() { return !m_items.empty() || m_closed; });
+        if (m_items.empty()) {
+            return false;
+        }
+        item = std::move(m_items.front());
+        m_items.pop_front();
+        lock.unlock();
+        m_not_full.notify_one();
+        return true;
+    }
+
+    // Waits for at least one item, then takes whatever else is already queued, up to max_items.
+    size_t pop_many(std::vector<T> &items, size_t max_items)
+    {
+        items.clear();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_empty.wait(lock, [this]() { return !m_items.empty() || m_closed; });
+        while (!m_items.empty() && items.size() < max_items) {
+            items.push_back(std::move(m_items.front()));
+            m_items.pop_front();
+        }
+        lock.unlock();
+        m_not_full.notify_all();
+        return items.size();
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_not_empty.notify_all();
+        m_not_full.notify_all();
+    }
+
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_items.size();
+    }
+
+    size_t capacity() const { return m_capacity; }
+
+private:
+    size_t m_capacity;
+    bool m_closed;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_not_empty;
+    std::condition_variable m_not_full;
+    std::deque<T> m_items;
+};
@@ -0,0 +1,83 @@
+#include "inception_v3_rcu.hpp"
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+const uint64_t SLOT_UNUSED = UINT64_MAX;
+const uint64_t SLOT_QUIESCENT = 0;
+
+struct alignas(64) ReaderSlot
+{
+    std::atomic<uint64_t> epoch{SLOT_UNUSED};
+};
+
+// Every access is seq_cst: the reader's slot store must be ordered before its
+// pointer load, and the writer's pointer swap before its epoch bump and slot scan.
+std::atomic<uint64_t> g_epoch{1};
+ReaderSlot g_slots[INCEPTION_V3_RCU_MAX_READERS];
+
+// Claims a slot on a thread's first read section and frees it at thread exit.
+struct ThreadReader
+{
+    ReaderSlot *slot = nullptr;
+    unsigned nesting = 0;
+
+    ReaderSlot &claim()
+    {
+        if (slot) {
+            return *slot;
+        }
+        for (auto &candidate : g_slots) {
+            uint64_t expected = SLOT_UNUSED;
+            if (candidate.epoch.compare_exchange_strong(expected, SLOT_QUIESCENT)) {
+                slot = &candidate;
+                return *slot;
+            }
+        }
+        throw std::runtime_error("too many RCU reader threads");
+    }
+
+    ~ThreadReader()
+    {
+        if (slot) {
+            slot->epoch.store(SLOT_UNUSED);
+        }
+    }
+};
+
+thread_local ThreadReader t_reader;
+} // namespace
+
+void inception_v3_rcu_read_lock()
+{
+    ReaderSlot &slot = t_reader.claim();
+    if (t_reader.nesting++ == 0) {
+        slot.epoch.store(g_epoch.load());
+    }
+}
+
+void inception_v3_rcu_read_unlock()
+{
+    if (--t_reader.nesting == 0) {
+        t_reader.slot->epoch.store(SLOT_QUIESCENT);
+    }
+}
+
+void inception_v3_rcu_synchronize()
+{
+    // Readers that entered after the bump carry the new epoch and can only have
+    // seen the new pointer; anyone still showing an older epoch must finish first.
+    const uint64_t epoch = g_epoch.fetch_add(1) + 1;
+    for (auto &slot : g_slots) {
+        for (;;) {
+            uint64_t observed = slot.epoch.load();
+            if (observed == SLOT_UNUSED || observed == SLOT_QUIESCENT || observed >= epoch) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+}
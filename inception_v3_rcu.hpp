@@ -0,0 +1,57 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+// Minimal process-wide RCU for data read on every frame and replaced rarely
+// (postprocess params).
+//
+// Readers publish the grace-period epoch they started in, in a per-thread slot,
+// and clear it when done: two atomic stores, no locks, no syscalls. A writer
+// swaps the shared pointer, then inception_v3_rcu_synchronize() waits until every
+// reader that could still see the old object has left its read section, after
+// which the old object can be freed.
+
+static const size_t INCEPTION_V3_RCU_MAX_READERS = 128;
+
+void inception_v3_rcu_read_lock();
+void inception_v3_rcu_read_unlock();
+
+// Blocks the writer (never the readers) for one grace period. Must not be called
+// inside a read section.
+void inception_v3_rcu_synchronize();
+
+class InceptionV3RcuReadGuard
+{
+public:
+    InceptionV3RcuReadGuard() { inception_v3_rcu_read_lock(); }
+    ~InceptionV3RcuReadGuard() { inception_v3_rcu_read_unlock(); }
+
+    InceptionV3RcuReadGuard(const InceptionV3RcuReadGuard &) = delete;
+    InceptionV3RcuReadGuard &operator=(const InceptionV3RcuReadGuard &) = delete;
+};
+
+// Pointer replaced under RCU. Readers load() inside a read section; the writer
+// calls replace(), which returns once the previous object can no longer be seen
+// and deletes it.
+template <typename T>
+class InceptionV3RcuPointer
+{
+public:
+    explicit InceptionV3RcuPointer(T *initial = nullptr) : m_pointer(initial) {}
+    ~InceptionV3RcuPointer() { delete m_pointer.load(); }
+
+    InceptionV3RcuPointer(const InceptionV3RcuPointer &) = delete;
+    InceptionV3RcuPointer &operator=(const InceptionV3RcuPointer &) = delete;
+
+    T *load() const { return m_pointer.load(std::memory_order_seq_cst); }
+
+    void replace(T *next)
+    {
+        T *previous = m_pointer.exchange(next, std::memory_order_seq_cst);
+        inception_v3_rcu_synchronize();
+        delete previous;
+    }
+
+private:
+    std::atomic<T *> m_pointer;
+};
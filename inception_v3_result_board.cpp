@@ -0,0 +1,159 @@
+#include "inception_v3_result_board.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+std::runtime_error errno_error(const std::string &what)
+{
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+}
+
+InceptionV3ResultBoard::InceptionV3ResultBoard(const std::string &name, bool writer)
+    : m_name(name), m_writer(writer), m_fd(-1), m_layout(nullptr)
+{
+    if (writer) {
+        shm_unlink(name.c_str());
+        m_fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0644);
+        if (m_fd >= 0 && ftruncate(m_fd, sizeof(InceptionV3BoardLayout)) < 0) {
+            auto error = errno_error("ftruncate " + name);
+            ::close(m_fd);
+            throw error;
+        }
+    } else {
+        m_fd = shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    }
+    if (m_fd < 0) {
+        throw errno_error("shm_open " + name);
+    }
+
+    struct stat st;
+    if (fstat(m_fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(InceptionV3BoardLayout)) {
+        ::close(m_fd);
+        throw std::runtime_error("result board " + name + " is not initialized");
+    }
+
+    void *base = mmap(nullptr, sizeof(InceptionV3BoardLayout), writer ? PROT_READ | PROT_WRITE : PROT_READ,
+                      MAP_SHARED, m_fd, 0);
+    if (base == MAP_FAILED) {
+        auto error = errno_error("mmap " + name);
+        ::close(m_fd);
+        throw error;
+    }
+
+    if (writer) {
+        m_layout = new (base) InceptionV3BoardLayout();
+        m_layout->version = INCEPTION_V3_BOARD_VERSION;
+        m_layout->payload_size = sizeof(InceptionV3BoardPayload);
+        m_layout->sequence.store(0);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_layout->magic = INCEPTION_V3_BOARD_MAGIC;
+        return;
+    }
+
+    m_layout = static_cast<InceptionV3BoardLayout *>(base);
+    if (m_layout->magic != INCEPTION_V3_BOARD_MAGIC || m_layout->version != INCEPTION_V3_BOARD_VERSION ||
+        m_layout->payload_size != sizeof(InceptionV3BoardPayload)) {
+        munmap(base, sizeof(InceptionV3BoardLayout));
+        ::close(m_fd);
+        throw std::runtime_error("result board " + name + " has an unexpected layout");
+    }
+}
+
+InceptionV3ResultBoard::~InceptionV3ResultBoard()
+{
+    munmap(m_layout, sizeof(InceptionV3BoardLayout));
+    ::close(m_fd);
+    if (m_writer) {
+        shm_unlink(m_name.c_str());
+    }
+}
+
+void InceptionV3ResultBoard::publish(const InceptionV3BoardPayload &payload)
+{
+    // Single writer: nobody else changes the sequence, so no read-modify-write is needed.
+    uint32_t sequence = m_layout->sequence.load(std::memory_order_relaxed);
+    m_layout->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::memcpy(&m_layout->payload, &payload, sizeof(payload));
+
+    m_layout->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool InceptionV3ResultBoard::read(InceptionV3BoardPayload &payload) const
+{
+    while (true) {
+        uint32_t before = m_layout->sequence.load(std::memory_order_acquire);
+        if (before == 0) {
+            return false;
+        }
+        if (before & 1) {
+            continue;
+        }
+
+        std::memcpy(&payload, &m_layout->payload, sizeof(payload));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_layout->sequence.load(std::memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+}
+
+std::string InceptionV3ResultBoard::stream_board_name(const std::string &prefix, uint32_t stream_id)
+{
+    return prefix + ".board." + std::to_string(stream_id);
+}
+
+InceptionV3ResultBoards::InceptionV3ResultBoards(const std::string &prefix, size_t max_boards,
+                                                 std::chrono::seconds idle_timeout)
+    : m_prefix(prefix), m_max_boards(max_boards > 0 ? max_boards : 1), m_idle_timeout(idle_timeout),
+      m_next_sweep(std::chrono::steady_clock::now() + std::chrono::seconds(1))
+{}
+
+void InceptionV3ResultBoards::publish(uint32_t stream_id, const InceptionV3BoardPayload &payload)
+{
+    auto now = std::chrono::steady_clock::now();
+    if (now >= m_next_sweep) {
+        evict(now);
+        m_next_sweep = now + std::chrono::seconds(1);
+    }
+
+    auto entry = m_boards.find(stream_id);
+    if (entry == m_boards.end()) {
+        if (m_boards.size() >= m_max_boards) {
+            auto oldest = m_boards.begin();
+            for (auto it = m_boards.begin(); it != m_boards.end(); ++it) {
+                if (it->second.last_publish < oldest->second.last_publish) {
+                    oldest = it;
+                }
+            }
+            m_boards.erase(oldest);
+        }
+        Entry created;
+        created.board.reset(new InceptionV3ResultBoard(InceptionV3ResultBoard::stream_board_name(m_prefix, stream_id),
+                                                       true));
+        entry = m_boards.emplace(stream_id, std::move(created)).first;
+    }
+    entry->second.board->publish(payload);
+    entry->second.last_publish = now;
+}
+
+void InceptionV3ResultBoards::evict(std::chrono::steady_clock::time_point now)
+{
+    for (auto it = m_boards.begin(); it != m_boards.end();) {
+        if (now - it->second.last_publish >= m_idle_timeout) {
+            it = m_boards.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+// Latest classification of one stream, published in a POSIX shm object that any
+// number of local processes can map read-only.
+//
+// The board is guarded by a seqlock: the single writer makes the sequence odd,
+// rewrites the payload and makes it even again. Readers copy the payload and retry
+// if the sequence was odd or changed meanwhile, so they take no locks, make no
+// syscalls and never delay the writer.
+
+static const uint32_t INCEPTION_V3_BOARD_MAGIC = 0x49563342; // "IV3B"
+static const uint32_t INCEPTION_V3_BOARD_VERSION = 1;
+static const size_t INCEPTION_V3_BOARD_TOP_K = 5;
+static const size_t INCEPTION_V3_BOARD_LABEL_SIZE = 64;
+
+struct InceptionV3BoardPayload
+{
+    uint64_t frame_seq;
+    uint64_t capture_time_ns;   // CLOCK_MONOTONIC, when the frame entered the service
+    uint64_t publish_time_ns;   // CLOCK_MONOTONIC, when this result was published
+    uint32_t stream_id;
+    uint32_t top_k_count;
+    int32_t class_ids[INCEPTION_V3_BOARD_TOP_K];
+    float confidences[INCEPTION_V3_BOARD_TOP_K];
+    char top_label[INCEPTION_V3_BOARD_LABEL_SIZE];
+};
+
+struct alignas(64) InceptionV3BoardLayout
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t payload_size;
+    alignas(64) std::atomic<uint32_t> sequence;
+    InceptionV3BoardPayload payload;
+};
+
+class InceptionV3ResultBoard
+{
+public:
+    // writer == true creates (or recreates) the board; otherwise attaches read-only.
+    InceptionV3ResultBoard(const std::string &name, bool writer);
+    ~InceptionV3ResultBoard();
+
+    InceptionV3ResultBoard(const InceptionV3ResultBoard &) = delete;
+    InceptionV3ResultBoard &operator=(const InceptionV3ResultBoard &) = delete;
+
+    void publish(const InceptionV3BoardPayload &payload);
+
+    // Returns false if nothing has been published yet.
+    bool read(InceptionV3BoardPayload &payload) const;
+
+    static std::string stream_board_name(const std::string &prefix, uint32_t stream_id);
+
+private:
+    std::string m_name;
+    bool m_writer;
+    int m_fd;
+    InceptionV3BoardLayout *m_layout;
+};
+
+// Writer-side boards of one service, one per stream id, created when a stream
+// first publishes. A board nobody published to for idle_timeout is removed, and
+// at most max_boards exist: when they are all in use the least recently published
+// one makes room. Readers of a removed board keep its last payload; the board is
+// recreated when its stream publishes again.
+class InceptionV3ResultBoards
+{
+public:
+    explicit InceptionV3ResultBoards(const std::string &prefix, size_t max_boards = 256,
+                                     std::chrono::seconds idle_timeout = std::chrono::seconds(300));
+
+    void publish(uint32_t stream_id, const InceptionV3BoardPayload &payload);
+    size_t size() const { return m_boards.size(); }
+
+private:
+    struct Entry
+    {
+        std::unique_ptr<InceptionV3ResultBoard> board;
+        std::chrono::steady_clock::time_point last_publish;
+    };
+
+    void evict(std::chrono::steady_clock::time_point now);
+
+    std::string m_prefix;
+    size_t m_max_boards;
+    std::chrono::steady_clock::duration m_idle_timeout;
+    std::chrono::steady_clock::time_point m_next_sweep;
+    std::map<uint32_t, Entry> m_boards;
+};
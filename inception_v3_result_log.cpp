@@ -0,0 +1,199 @@
+#include "inception_v3_result_log.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+const char SEGMENT_PREFIX[] = "inception_v3_";
+const char SEGMENT_SUFFIX[] = ".log";
+
+std::runtime_error errno_error(const std::string &what)
+{
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+bool parse_segment_index(const std::string &name, uint32_t &index)
+{
+    const size_t prefix = sizeof(SEGMENT_PREFIX) - 1;
+    const size_t suffix = sizeof(SEGMENT_SUFFIX) - 1;
+    if (name.size() <= prefix + suffix || name.compare(0, prefix, SEGMENT_PREFIX) != 0 ||
+        name.compare(name.size() - suffix, suffix, SEGMENT_SUFFIX) != 0) {
+        return false;
+    }
+    std::string digits = name.substr(prefix, name.size() - prefix - suffix);
+    if (digits.empty() || !std::all_of(digits.begin(), digits.end(), ::isdigit)) {
+        return false;
+    }
+    index = static_cast<uint32_t>(std::stoul(digits));
+    return true;
+}
+
+std::string segment_path(const std::string &dir, uint32_t index)
+{
+    char name[64];
+    std::snprintf(name, sizeof(name), "%s%08u%s", SEGMENT_PREFIX, index, SEGMENT_SUFFIX);
+    return dir + "/" + name;
+}
+
+std::vector<uint32_t> segment_indices(const std::string &dir)
+{
+    std::vector<uint32_t> indices;
+    DIR *handle = opendir(dir.c_str());
+    if (handle == nullptr) {
+        return indices;
+    }
+    while (dirent *entry = readdir(handle)) {
+        uint32_t index;
+        if (parse_segment_index(entry->d_name, index)) {
+            indices.push_back(index);
+        }
+    }
+    closedir(handle);
+    std::sort(indices.begin(), indices.end());
+    return indices;
+}
+}
+
+InceptionV3ResultLog::InceptionV3ResultLog(const std::string &dir, uint64_t segment_records)
+    : m_dir(dir), m_segment_records(std::max<uint64_t>(segment_records, 1)), m_segment_index(0), m_fd(-1),
+      m_base(nullptr), m_size(0), m_header(nullptr), m_records(nullptr), m_count(0)
+{
+    if (mkdir(dir.c_str(), 0755) < 0 && errno != EEXIST) {
+        throw errno_error("mkdir " + dir);
+    }
+    auto indices = segment_indices(dir);
+    m_segment_index = indices.empty() ? 0 : indices.back() + 1;
+    open_segment();
+}
+
+InceptionV3ResultLog::~InceptionV3ResultLog()
+{
+    close_segment();
+}
+
+void InceptionV3ResultLog::open_segment()
+{
+    const std::string path = segment_path(m_dir, m_segment_index);
+    m_fd = open(path.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0644);
+    if (m_fd < 0) {
+        throw errno_error("open " + path);
+    }
+
+    m_size = sizeof(InceptionV3LogSegmentHeader) + m_segment_records * sizeof(InceptionV3LogRecord);
+    if (ftruncate(m_fd, static_cast<off_t>(m_size)) < 0) {
+        auto error = errno_error("ftruncate " + path);
+        ::close(m_fd);
+        throw error;
+    }
+
+    void *base = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (base == MAP_FAILED) {
+        auto error = errno_error("mmap " + path);
+        ::close(m_fd);
+        throw error;
+    }
+    m_base = static_cast<uint8_t *>(base);
+
+    m_header = new (m_base) InceptionV3LogSegmentHeader();
+    m_header->magic = INCEPTION_V3_LOG_MAGIC;
+    m_header->version = INCEPTION_V3_LOG_VERSION;
+    m_header->record_size = sizeof(InceptionV3LogRecord);
+    m_header->segment_index = m_segment_index;
+    m_header->capacity = m_segment_records;
+    m_header->record_count.store(0, std::memory_order_release);
+
+    m_records = reinterpret_cast<InceptionV3LogRecord *>(m_base + sizeof(InceptionV3LogSegmentHeader));
+    m_count = 0;
+}
+
+void InceptionV3ResultLog::close_segment()
+{
+    if (m_base == nullptr) {
+        return;
+    }
+
+    // Give back the unused tail of the last segment.
+    munmap(m_base, m_size);
+    if (ftruncate(m_fd, static_cast<off_t>(sizeof(InceptionV3LogSegmentHeader) + m_count * sizeof(InceptionV3LogRecord))) < 0) {
+        std::perror("ftruncate result log segment");
+    }
+    ::close(m_fd);
+    m_base = nullptr;
+    m_fd = -1;
+}
+
+void InceptionV3ResultLog::append(const InceptionV3LogRecord &record)
+{
+    if (m_count == m_segment_records) {
+        close_segment();
+        m_segment_index++;
+        open_segment();
+    }
+
+    std::memcpy(&m_records[m_count], &record, sizeof(record));
+    m_count++;
+    m_header->record_count.store(m_count, std::memory_order_release);
+}
+
+void InceptionV3ResultLog::flush()
+{
+    msync(m_base, m_size, MS_ASYNC);
+}
+
+std::vector<std::string> list_inception_v3_log_segments(const std::string &dir)
+{
+    std::vector<std::string> paths;
+    for (auto index : segment_indices(dir)) {
+        paths.push_back(segment_path(dir, index));
+    }
+    return paths;
+}
+
+void read_inception_v3_log(const std::string &dir, const std::function<void(const InceptionV3LogRecord &)> &visit)
+{
+    for (auto &path : list_inception_v3_log_segments(dir)) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw errno_error("open " + path);
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(InceptionV3LogSegmentHeader)) {
+            ::close(fd);
+            continue;
+        }
+
+        const size_t size = static_cast<size_t>(st.st_size);
+        void *base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            throw errno_error("mmap " + path);
+        }
+
+        auto *header = static_cast<const InceptionV3LogSegmentHeader *>(base);
+        if (header->magic != INCEPTION_V3_LOG_MAGIC || header->version != INCEPTION_V3_LOG_VERSION ||
+            header->record_size != sizeof(InceptionV3LogRecord)) {
+            munmap(base, size);
+            throw std::runtime_error(path + " is not an inception_v3 result log segment");
+        }
+
+        // Live segments may be appended to while we read; only committed records are visited.
+        uint64_t count = header->record_count.load(std::memory_order_acquire);
+        count = std::min<uint64_t>(count, (size - sizeof(InceptionV3LogSegmentHeader)) / sizeof(InceptionV3LogRecord));
+        auto *records = reinterpret_cast<const InceptionV3LogRecord *>(static_cast<const uint8_t *>(base) +
+                                                                       sizeof(InceptionV3LogSegmentHeader));
+        for (uint64_t i = 0; i < count; i++) {
+            visit(records[i]);
+        }
+        munmap(base, size);
+    }
+}
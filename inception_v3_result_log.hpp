@@ -0,0 +1,85 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Append-only binary log of classification results, split into fixed-size
+// segment files <dir>/inception_v3_<index>.log that are written through mmap.
+// Appending a record is a memcpy plus one release store of the segment's record
+// count, so recording every frame costs no syscall except on segment rotation.
+// A segment left behind by a crash is still readable up to its last committed record.
+
+static const uint32_t INCEPTION_V3_LOG_MAGIC = 0x49563347; // "IV3G"
+static const uint32_t INCEPTION_V3_LOG_VERSION = 1;
+static const size_t INCEPTION_V3_LOG_TOP_K = 5;
+
+struct InceptionV3LogRecord
+{
+    uint64_t timestamp_ns;      // CLOCK_REALTIME at capture
+    uint64_t frame_seq;
+    uint32_t stream_id;
+    uint32_t latency_us;        // capture to result
+    uint16_t top_k_count;
+    uint16_t flags;             // INCEPTION_V3_LOG_VALID when top-1 passed the threshold, INCEPTION_V3_LOG_EVENT
+    uint16_t class_ids[INCEPTION_V3_LOG_TOP_K];
+    uint16_t reserved;
+    float confidences[INCEPTION_V3_LOG_TOP_K];
+    uint32_t reserved2;
+};
+static_assert(sizeof(InceptionV3LogRecord) == 64, "log records are one cache line");
+
+static const uint16_t INCEPTION_V3_LOG_VALID = 1u << 0;
+// Record of a smoothed top-1 change rather than of one frame; VALID unset means
+// the stable class was cleared.
+static const uint16_t INCEPTION_V3_LOG_EVENT = 1u << 1;
+
+struct InceptionV3LogSegmentHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t segment_index;
+    uint64_t capacity;          // records
+    std::atomic<uint64_t> record_count;
+    uint8_t reserved[32];
+};
+static_assert(sizeof(InceptionV3LogSegmentHeader) == 64, "segment header is one cache line");
+
+// Single writer. Each instance starts a new segment after the newest one in dir.
+class InceptionV3ResultLog
+{
+public:
+    InceptionV3ResultLog(const std::string &dir, uint64_t segment_records = 1u << 20);
+    ~InceptionV3ResultLog();
+
+    InceptionV3ResultLog(const InceptionV3ResultLog &) = delete;
+    InceptionV3ResultLog &operator=(const InceptionV3ResultLog &) = delete;
+
+    void append(const InceptionV3LogRecord &record);
+
+    // Schedules write-back of the mapped pages (MS_ASYNC), without blocking.
+    void flush();
+
+private:
+    void open_segment();
+    void close_segment();
+
+    std::string m_dir;
+    uint64_t m_segment_records;
+    uint32_t m_segment_index;
+    int m_fd;
+    uint8_t *m_base;
+    size_t m_size;
+    InceptionV3LogSegmentHeader *m_header;
+    InceptionV3LogRecord *m_records;
+    uint64_t m_count;
+};
+
+// Segment files in dir, oldest first.
+std::vector<std::string> list_inception_v3_log_segments(const std::string &dir);
+
+// Calls visit for every committed record of every segment in dir, in order.
+void read_inception_v3_log(const std::string &dir, const std::function<void(const InceptionV3LogRecord &)> &visit);
@@ -0,0 +1,89 @@
+#include "inception_v3_runner.hpp"
+#include "inception_v3_perf.hpp"
+#include <algorithm>
+
+InceptionV3Runner::InceptionV3Runner(const std::string &hef_path, InceptionV3Params *params)
+    : InceptionV3Runner(std::unique_ptr<InceptionV3Backend>(new InceptionV3HailoBackend(hef_path)), params)
+{}
+
+InceptionV3Runner::InceptionV3Runner(std::unique_ptr<InceptionV3Backend> backend, InceptionV3Params *params)
+    : m_backend(std::move(backend)), m_params(params), m_params_watcher(nullptr)
+{
+    m_input_info = m_backend->input_info();
+    m_output_info = m_backend->output_info();
+}
+
+size_t InceptionV3Runner::input_frame_size() const
+{
+    return m_backend->input_frame_size();
+}
+
+size_t InceptionV3Runner::output_frame_size() const
+{
+    return m_backend->output_frame_size();
+}
+
+InceptionV3Result InceptionV3Runner::classify(uint8_t *frame)
+{
+    return classify_batch({frame})[0];
+}
+
+std::vector<InceptionV3Result> InceptionV3Runner::classify_batch(const std::vector<uint8_t *> &frames)
+{
+    std::vector<InceptionV3Result> results;
+    if (frames.empty()) {
+        return results;
+    }
+
+    while (m_output_buffers.size() < frames.size()) {
+        m_output_buffers.emplace_back(output_frame_size());
+    }
+
+    std::vector<uint8_t *> outputs;
+    outputs.reserve(frames.size());
+    {
+        InceptionV3PerfScope cost(INCEPTION_V3_PERF_PREPROCESS, frames.size());
+        for (size_t i = 0; i < frames.size(); i++) {
+            auto roi = std::make_shared<HailoROI>(HailoBBox(0.0f, 0.0f, 1.0f, 1.0f));
+            roi->add_tensor(std::make_shared<HailoTensor>(m_input_info, frames[i]));
+            preprocess_inception_v3(roi);
+            outputs.push_back(m_output_buffers[i].data());
+        }
+    }
+
+    m_backend->infer(frames, outputs);
+
+    results.reserve(frames.size());
+    for (auto *output : outputs) {
+        results.push_back(postprocess(output));
+    }
+    return results;
+}
+
+InceptionV3Result InceptionV3Runner::postprocess(uint8_t *output)
+{
+    InceptionV3PerfScope cost(INCEPTION_V3_PERF_POSTPROCESS, 1);
+    InceptionV3Result result;
+
+    auto roi = std::make_shared<HailoROI>(HailoBBox(0.0f, 0.0f, 1.0f, 1.0f));
+    roi->add_tensor(std::make_shared<HailoTensor>(m_output_info, output));
+    if (m_params_watcher) {
+        InceptionV3RcuReadGuard guard;
+        postprocess_inception_v3(roi, m_params_watcher->current());
+    } else {
+        postprocess_inception_v3(roi, m_params);
+    }
+    result.top_k_count = top_k_inception_v3(output, std::min<size_t>(output_frame_size(), 1000),
+                                            INCEPTION_V3_TOP_K, result.top_k_ids, result.top_k_confidences);
+
+    for (auto obj : roi->get_objects()) {
+        if (obj->get_type() == HAILO_CLASSIFICATION) {
+            auto classification = std::dynamic_pointer_cast<HailoClassification>(obj);
+            result.valid = true;
+            result.label = classification->get_label();
+            result.confidence = classification->get_confidence();
+        }
+    }
+
+    return result;
+}
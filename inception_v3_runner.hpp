@@ -0,0 +1,56 @@
+#pragma once
+#include "inception_v3_backend.hpp"
+#include "inception_v3_config.hpp"
+#include "inception_v3_hailortpp.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+struct InceptionV3Result
+{
+    bool valid = false;     // false when the top-1 is below the confidence threshold
+    std::string label;
+    float confidence = 0.0f;
+
+    // Raw top-K regardless of the threshold, best first.
+    size_t top_k_count = 0;
+    int top_k_ids[INCEPTION_V3_TOP_K] = {};
+    float top_k_confidences[INCEPTION_V3_TOP_K] = {};
+};
+
+// Owns a backend (normally the configured Hailo device) so that any number of
+// frames can be classified without paying for Device::create / VStreams::create again.
+class InceptionV3Runner
+{
+public:
+    InceptionV3Runner(const std::string &hef_path, InceptionV3Params *params);
+    InceptionV3Runner(std::unique_ptr<InceptionV3Backend> backend, InceptionV3Params *params);
+
+    size_t input_frame_size() const;
+    size_t output_frame_size() const;
+    InceptionV3Backend &backend() { return *m_backend; }
+
+    InceptionV3Result classify(uint8_t *frame);
+
+    // Frames are preprocessed in place, run through the backend as one batch and
+    // postprocessed.
+    std::vector<InceptionV3Result> classify_batch(const std::vector<uint8_t *> &frames);
+
+    // Raw fc1 scores of the index-th frame of the last classify_batch(), valid until the next call.
+    const uint8_t *last_output(size_t index) const { return m_output_buffers[index].data(); }
+
+    // Postprocess of one output tensor, for callers that drive the backend themselves.
+    InceptionV3Result postprocess(uint8_t *output);
+
+    // Takes params from watcher (under RCU) instead of the constructor's params,
+    // so config edits apply from the next frame. Set before classifying.
+    void set_params_watcher(InceptionV3ParamsWatcher *watcher) { m_params_watcher = watcher; }
+
+private:
+    std::unique_ptr<InceptionV3Backend> m_backend;
+    InceptionV3Params *m_params;
+    InceptionV3ParamsWatcher *m_params_watcher;
+    hailo_vstream_info_t m_input_info;
+    hailo_vstream_info_t m_output_info;
+    std::vector<std::vector<uint8_t>> m_output_buffers;
+};
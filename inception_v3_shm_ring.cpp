@@ -0,0 +1,405 @@
+#include "inception_v3_shm_ring.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace
+{
+std::runtime_error errno_error(const std::string &what)
+{
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+size_t page_align(size_t size)
+{
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return (size + page - 1) / page * page;
+}
+
+uint64_t now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// Shared (not FUTEX_PRIVATE) futexes, since waiters live in other processes.
+void futex_wait(std::atomic<uint32_t> &word, uint32_t expected, std::chrono::milliseconds timeout)
+{
+    timespec ts;
+    ts.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+    ts.tv_nsec = static_cast<long>(timeout.count() % 1000) * 1000000L;
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+}
+
+void futex_wake(std::atomic<uint32_t> &word)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+std::chrono::milliseconds remaining(std::chrono::steady_clock::time_point deadline)
+{
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+    return std::max(left, std::chrono::milliseconds(0));
+}
+}
+
+InceptionV3ShmRing::InceptionV3ShmRing(const std::string &name, uint32_t slot_count, uint32_t slot_size,
+                                       std::chrono::milliseconds abandon_after)
+    : m_name(name), m_owner(true), m_fd(-1), m_size(0), m_base(nullptr), m_header(nullptr), m_slots(nullptr),
+      m_abandon_ns(static_cast<uint64_t>(std::chrono::nanoseconds(abandon_after).count())),
+      m_next_sweep_ns(0)
+{
+    if (slot_count == 0 || slot_size == 0) {
+        throw std::invalid_argument("shm ring needs at least one non-empty slot");
+    }
+
+    const size_t data_offset = page_align(sizeof(InceptionV3ShmRingHeader) + slot_count * sizeof(InceptionV3ShmSlot));
+    const size_t stride = page_align(slot_size);
+
+    shm_unlink(name.c_str());
+    m_fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0660);
+    if (m_fd < 0) {
+        throw errno_error("shm_open " + name);
+    }
+    if (ftruncate(m_fd, static_cast<off_t>(data_offset + stride * slot_count)) < 0) {
+        auto error = errno_error("ftruncate " + name);
+        ::close(m_fd);
+        shm_unlink(name.c_str());
+        throw error;
+    }
+    map(data_offset + stride * slot_count);
+
+    m_header = new (m_base) InceptionV3ShmRingHeader();
+    m_header->version = INCEPTION_V3_SHM_VERSION;
+    m_header->slot_count = slot_count;
+    m_header->slot_size = slot_size;
+    m_header->data_offset = data_offset;
+    m_header->next_seq.store(0);
+    m_header->ready_futex.store(0);
+    m_header->free_futex.store(0);
+
+    m_slots = reinterpret_cast<InceptionV3ShmSlot *>(m_base + sizeof(InceptionV3ShmRingHeader));
+    for (uint32_t i = 0; i < slot_count; i++) {
+        new (&m_slots[i]) InceptionV3ShmSlot();
+        m_slots[i].state.store(INCEPTION_V3_SLOT_FREE);
+        m_slots[i].state_time_ns.store(0);
+    }
+
+    // Publish the magic last so producers never attach to a half-built ring.
+    std::atomic_thread_fence(std::memory_order_release);
+    m_header->magic = INCEPTION_V3_SHM_MAGIC;
+}
+
+InceptionV3ShmRing::InceptionV3ShmRing(const std::string &name)
+    : m_name(name), m_owner(false), m_fd(-1), m_size(0), m_base(nullptr), m_header(nullptr), m_slots(nullptr),
+      m_abandon_ns(0), m_next_sweep_ns(0)
+{
+    m_fd = shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+    if (m_fd < 0) {
+        throw errno_error("shm_open " + name);
+    }
+
+    struct stat st;
+    if (fstat(m_fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(InceptionV3ShmRingHeader)) {
+        ::close(m_fd);
+        throw std::runtime_error("shm ring " + name + " is not initialized");
+    }
+    map(static_cast<size_t>(st.st_size));
+
+    m_header = reinterpret_cast<InceptionV3ShmRingHeader *>(m_base);
+    if (m_header->magic != INCEPTION_V3_SHM_MAGIC || m_header->version != INCEPTION_V3_SHM_VERSION) {
+        munmap(m_base, m_size);
+        ::close(m_fd);
+        throw std::runtime_error("shm ring " + name + " has an unexpected layout");
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    m_slots = reinterpret_cast<InceptionV3ShmSlot *>(m_base + sizeof(InceptionV3ShmRingHeader));
+    m_epochs.assign(m_header->slot_count, 0);
+}
+
+InceptionV3ShmRing::~InceptionV3ShmRing()
+{
+    munmap(m_base, m_size);
+    ::close(m_fd);
+    if (m_owner) {
+        shm_unlink(m_name.c_str());
+    }
+}
+
+void InceptionV3ShmRing::map(size_t size)
+{
+    void *base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (base == MAP_FAILED) {
+        auto error = errno_error("mmap " + m_name);
+        ::close(m_fd);
+        throw error;
+    }
+    m_base = static_cast<uint8_t *>(base);
+    m_size = size;
+}
+
+uint8_t *InceptionV3ShmRing::slot_data(int slot) const
+{
+    return m_base + m_header->data_offset + static_cast<size_t>(slot) * page_align(m_header->slot_size);
+}
+
+int InceptionV3ShmRing::acquire(std::chrono::milliseconds timeout)
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    const uint32_t count = m_header->slot_count;
+
+    while (true) {
+        uint32_t free_seen = m_header->free_futex.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t expected = INCEPTION_V3_SLOT_FREE;
+            if (m_slots[i].state.compare_exchange_strong(expected, INCEPTION_V3_SLOT_WRITING,
+                                                         std::memory_order_acquire)) {
+                m_epochs[i] = ++m_slots[i].epoch;
+                m_slots[i].state_time_ns.store(now_ns(), std::memory_order_relaxed);
+                return static_cast<int>(i);
+            }
+        }
+
+        auto left = remaining(deadline);
+        if (left.count() == 0) {
+            return -1;
+        }
+        futex_wait(m_header->free_futex, free_seen, left);
+    }
+}
+
+void InceptionV3ShmRing::submit(int slot, uint32_t stream_id, uint32_t frame_size, uint32_t flags)
+{
+    auto &s = m_slots[slot];
+    if (s.state.load(std::memory_order_acquire) != INCEPTION_V3_SLOT_WRITING || s.epoch != m_epochs[slot]) {
+        throw std::runtime_error("shm slot " + std::to_string(slot) + " was reclaimed before it was submitted");
+    }
+    s.flags = flags;
+    s.stream_id = stream_id;
+    s.frame_size = std::min(frame_size, m_header->slot_size);
+    s.seq = m_header->next_seq.fetch_add(1, std::memory_order_relaxed);
+    s.submit_time_ns = now_ns();
+    uint32_t expected = INCEPTION_V3_SLOT_WRITING;
+    if (!s.state.compare_exchange_strong(expected, INCEPTION_V3_SLOT_READY, std::memory_order_release)) {
+        throw std::runtime_error("shm slot " + std::to_string(slot) + " was reclaimed before it was submitted");
+    }
+
+    m_header->ready_futex.fetch_add(1, std::memory_order_release);
+    futex_wake(m_header->ready_futex);
+}
+
+bool InceptionV3ShmRing::wait_result(int slot, std::chrono::milliseconds timeout,
+                                     InceptionV3ShmResultStatus &status, float &confidence, std::string &label)
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    auto &s = m_slots[slot];
+
+    // Past READY, INFLIGHT and DONE of this claim the slot was reclaimed (and
+    // maybe claimed again by another producer); it is not ours to release.
+    auto reclaimed = [&]() {
+        status = INCEPTION_V3_SHM_RESULT_ERROR;
+        confidence = 0.0f;
+        label = "slot reclaimed by the service after its result went uncollected";
+        return true;
+    };
+    while (true) {
+        uint32_t state = s.state.load(std::memory_order_acquire);
+        if (s.epoch != m_epochs[slot] || (state != INCEPTION_V3_SLOT_READY && state != INCEPTION_V3_SLOT_INFLIGHT &&
+                                          state != INCEPTION_V3_SLOT_DONE)) {
+            return reclaimed();
+        }
+        if (state == INCEPTION_V3_SLOT_DONE) {
+            break;
+        }
+        auto left = remaining(deadline);
+        if (left.count() == 0) {
+            return false;
+        }
+        futex_wait(s.state, state, left);
+    }
+
+    status = static_cast<InceptionV3ShmResultStatus>(s.result_status);
+    confidence = s.result_confidence;
+    label.assign(s.result_label, strnlen(s.result_label, sizeof(s.result_label)));
+    uint32_t expected = INCEPTION_V3_SLOT_DONE;
+    if (!s.state.compare_exchange_strong(expected, INCEPTION_V3_SLOT_RELEASING, std::memory_order_acquire)) {
+        return reclaimed();
+    }
+    release(slot);
+    return true;
+}
+
+size_t InceptionV3ShmRing::take_ready(std::vector<int> &slots, size_t max_slots, std::chrono::milliseconds timeout)
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    const uint32_t count = m_header->slot_count;
+    slots.clear();
+
+    const uint64_t now = now_ns();
+    if (now >= m_next_sweep_ns) {
+        reclaim_abandoned();
+        m_next_sweep_ns = now + 1000000000ull;
+    }
+
+    while (true) {
+        uint32_t ready_seen = m_header->ready_futex.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < count; i++) {
+            if (m_slots[i].state.load(std::memory_order_acquire) == INCEPTION_V3_SLOT_READY) {
+                slots.push_back(static_cast<int>(i));
+            }
+        }
+
+        if (!slots.empty()) {
+            std::sort(slots.begin(), slots.end(), [this](int a, int b) { return m_slots[a].seq < m_slots[b].seq; });
+            if (slots.size() > max_slots) {
+                slots.resize(max_slots);
+            }
+            // Only the service moves READY -> INFLIGHT, so a plain store is enough.
+            for (int slot : slots) {
+                m_slots[slot].state.store(INCEPTION_V3_SLOT_INFLIGHT, std::memory_order_relaxed);
+            }
+            return slots.size();
+        }
+
+        auto left = remaining(deadline);
+        if (left.count() == 0) {
+            return 0;
+        }
+        futex_wait(m_header->ready_futex, ready_seen, left);
+    }
+}
+
+void InceptionV3ShmRing::complete(int slot, bool valid, float confidence, const std::string &label)
+{
+    finish(slot, valid ? INCEPTION_V3_SHM_RESULT_VALID : INCEPTION_V3_SHM_RESULT_BELOW_THRESHOLD, confidence, label);
+}
+
+void InceptionV3ShmRing::fail(int slot, const std::string &message)
+{
+    finish(slot, INCEPTION_V3_SHM_RESULT_ERROR, 0.0f, message);
+}
+
+void InceptionV3ShmRing::finish(int slot, InceptionV3ShmResultStatus status, float confidence,
+                                const std::string &label)
+{
+    auto &s = m_slots[slot];
+    if (!(s.flags & INCEPTION_V3_SHM_WANT_RESULT)) {
+        release(slot);
+        return;
+    }
+
+    s.result_status = status;
+    s.result_confidence = confidence;
+    size_t length = std::min(label.size(), sizeof(s.result_label) - 1);
+    std::memcpy(s.result_label, label.data(), length);
+    s.result_label[length] = '\0';
+
+    s.state_time_ns.store(now_ns(), std::memory_order_relaxed);
+    s.state.store(INCEPTION_V3_SLOT_DONE, std::memory_order_release);
+    futex_wake(s.state);
+}
+
+void InceptionV3ShmRing::release(int slot)
+{
+    // Cleared before FREE is visible, so a new claim never shows the old stamp.
+    m_slots[slot].state_time_ns.store(0, std::memory_order_relaxed);
+    m_slots[slot].state.store(INCEPTION_V3_SLOT_FREE, std::memory_order_release);
+    m_header->free_futex.fetch_add(1, std::memory_order_release);
+    futex_wake(m_header->free_futex);
+}
+
+// A slot still WRITING or DONE after abandon_after belongs to a producer that
+// crashed or stopped waiting for its result. Moving it to RELEASING first means a
+// producer finishing at the same moment and the sweep cannot both release it.
+void InceptionV3ShmRing::reclaim_abandoned()
+{
+    const uint64_t now = now_ns();
+    for (uint32_t i = 0; i < m_header->slot_count; i++) {
+        auto &s = m_slots[i];
+        uint32_t state = s.state.load(std::memory_order_acquire);
+        if (state != INCEPTION_V3_SLOT_WRITING && state != INCEPTION_V3_SLOT_DONE) {
+            continue;
+        }
+        const uint64_t since = s.state_time_ns.load(std::memory_order_relaxed);
+        if (since == 0 || now - since < m_abandon_ns) {
+            continue;
+        }
+        if (s.state.compare_exchange_strong(state, INCEPTION_V3_SLOT_RELEASING, std::memory_order_acquire)) {
+            release(static_cast<int>(i));
+            futex_wake(s.state);
+        }
+    }
+}
+
+extern "C" {
+
+void *inception_v3_shm_open(const char *name)
+{
+    try {
+        return new InceptionV3ShmRing(name);
+    } catch (const std::exception &) {
+        return nullptr;
+    }
+}
+
+void inception_v3_shm_close(void *ring)
+{
+    delete static_cast<InceptionV3ShmRing *>(ring);
+}
+
+uint32_t inception_v3_shm_slot_size(void *ring)
+{
+    return static_cast<InceptionV3ShmRing *>(ring)->slot_size();
+}
+
+int inception_v3_shm_acquire(void *ring, int timeout_ms)
+{
+    return static_cast<InceptionV3ShmRing *>(ring)->acquire(std::chrono::milliseconds(timeout_ms));
+}
+
+uint8_t *inception_v3_shm_slot_data(void *ring, int slot)
+{
+    return static_cast<InceptionV3ShmRing *>(ring)->slot_data(slot);
+}
+
+int inception_v3_shm_submit(void *ring, int slot, uint32_t stream_id, uint32_t frame_size, uint32_t flags)
+{
+    try {
+        static_cast<InceptionV3ShmRing *>(ring)->submit(slot, stream_id, frame_size, flags);
+    } catch (const std::exception &) {
+        return -1;
+    }
+    return 0;
+}
+
+int inception_v3_shm_wait_result(void *ring, int slot, int timeout_ms, float *confidence,
+                                 char *label, size_t label_size)
+{
+    InceptionV3ShmResultStatus status = INCEPTION_V3_SHM_RESULT_BELOW_THRESHOLD;
+    std::string result_label;
+    if (!static_cast<InceptionV3ShmRing *>(ring)->wait_result(slot, std::chrono::milliseconds(timeout_ms),
+                                                              status, *confidence, result_label)) {
+        return -1;
+    }
+    if (label != nullptr && label_size > 0) {
+        size_t length = std::min(result_label.size(), label_size - 1);
+        std::memcpy(label, result_label.data(), length);
+        label[length] = '\0';
+    }
+    if (status == INCEPTION_V3_SHM_RESULT_ERROR) {
+        return -2;
+    }
+    return status == INCEPTION_V3_SHM_RESULT_VALID ? 1 : 0;
+}
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Shared-memory frame ring between local producer processes and the inference service.
+//
+// Layout of the POSIX shm object:
+//   InceptionV3ShmRingHeader | InceptionV3ShmSlot[slot_count] | page-aligned frame data[slot_count]
+//
+// A slot moves FREE -> WRITING (producer claimed it) -> READY (frame written) ->
+// INFLIGHT (service handed it to the input vstream) -> DONE (result written) -> FREE.
+// Slots submitted without INCEPTION_V3_SHM_WANT_RESULT go straight back to FREE.
+// A producer that crashes, or gives up on a result, would keep its slot forever,
+// so the service reclaims slots left WRITING or DONE for longer than abandon_after
+// (RELEASING marks a slot on its way back to FREE). Each claim bumps the slot's
+// epoch, so a producer that comes back to a reclaimed slot finds out instead of
+// touching someone else's frame.
+// A DONE slot carries a status: a class, nothing above threshold, or an error
+// (the frame was rejected or inference failed) with its message in result_label.
+// Waiting is done with futexes on words inside the mapping; frames are never
+// serialized or copied, and the service writes slot memory straight to the vstream.
+
+static const uint32_t INCEPTION_V3_SHM_MAGIC = 0x49563352; // "IV3R"
+static const uint32_t INCEPTION_V3_SHM_VERSION = 3;
+static const uint32_t INCEPTION_V3_SHM_WANT_RESULT = 1u << 0;
+static const size_t INCEPTION_V3_SHM_LABEL_SIZE = 64;
+
+enum InceptionV3ShmSlotState : uint32_t
+{
+    INCEPTION_V3_SLOT_FREE = 0,
+    INCEPTION_V3_SLOT_WRITING = 1,
+    INCEPTION_V3_SLOT_READY = 2,
+    INCEPTION_V3_SLOT_INFLIGHT = 3,
+    INCEPTION_V3_SLOT_DONE = 4,
+    INCEPTION_V3_SLOT_RELEASING = 5,
+};
+
+enum InceptionV3ShmResultStatus : uint32_t
+{
+    INCEPTION_V3_SHM_RESULT_BELOW_THRESHOLD = 0,
+    INCEPTION_V3_SHM_RESULT_VALID = 1,
+    INCEPTION_V3_SHM_RESULT_ERROR = 2,
+};
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+              "shared-memory futex words and slot stamps must be lock free");
+
+struct alignas(64) InceptionV3ShmRingHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t slot_size;
+    uint64_t data_offset;
+    std::atomic<uint64_t> next_seq;
+    alignas(64) std::atomic<uint32_t> ready_futex; // bumped on every submit
+    alignas(64) std::atomic<uint32_t> free_futex;  // bumped on every slot release
+};
+
+struct alignas(64) InceptionV3ShmSlot
+{
+    std::atomic<uint32_t> state;
+    uint32_t flags;
+    uint32_t stream_id;
+    uint32_t frame_size;
+    uint64_t seq;
+    uint64_t submit_time_ns;
+    uint32_t epoch;                         // bumped by every claim
+    std::atomic<uint64_t> state_time_ns;    // when the slot became WRITING or DONE; 0 once FREE
+
+    // Written by the service before the slot becomes DONE.
+    uint32_t result_status;     // InceptionV3ShmResultStatus
+    float result_confidence;
+    char result_label[INCEPTION_V3_SHM_LABEL_SIZE];
+};
+
+class InceptionV3ShmRing
+{
+public:
+    // Creates (or recreates) the ring; used by the inference service.
+    InceptionV3ShmRing(const std::string &name, uint32_t slot_count, uint32_t slot_size,
+                       std::chrono::milliseconds abandon_after = std::chrono::seconds(30));
+    // Attaches to an existing ring; used by producers.
+    explicit InceptionV3ShmRing(const std::string &name);
+    ~InceptionV3ShmRing();
+
+    InceptionV3ShmRing(const InceptionV3ShmRing &) = delete;
+    InceptionV3ShmRing &operator=(const InceptionV3ShmRing &) = delete;
+
+    uint32_t slot_count() const { return m_header->slot_count; }
+    uint32_t slot_size() const { return m_header->slot_size; }
+    uint8_t *slot_data(int slot) const;
+    InceptionV3ShmSlot &slot(int slot) const { return m_slots[slot]; }
+
+    // Producer side. acquire() returns a slot index, or -1 on timeout.
+    int acquire(std::chrono::milliseconds timeout);
+    // Throws std::runtime_error if the service reclaimed the slot meanwhile.
+    void submit(int slot, uint32_t stream_id, uint32_t frame_size, uint32_t flags);
+    // Waits for a slot submitted with INCEPTION_V3_SHM_WANT_RESULT, copies out its
+    // result and releases it. Returns false on timeout, leaving the slot owned.
+    // On INCEPTION_V3_SHM_RESULT_ERROR, label holds the error message; a slot the
+    // service reclaimed in the meantime is reported that way.
+    bool wait_result(int slot, std::chrono::milliseconds timeout, InceptionV3ShmResultStatus &status,
+                     float &confidence, std::string &label);
+
+    // Service side. Moves up to max_slots READY slots to INFLIGHT, oldest first,
+    // and about once a second reclaims abandoned slots.
+    size_t take_ready(std::vector<int> &slots, size_t max_slots, std::chrono::milliseconds timeout);
+    void complete(int slot, bool valid, float confidence, const std::string &label);
+    void fail(int slot, const std::string &message);
+
+private:
+    void map(size_t size);
+    void finish(int slot, InceptionV3ShmResultStatus status, float confidence, const std::string &label);
+    void release(int slot);
+    void reclaim_abandoned();
+
+    std::string m_name;
+    bool m_owner;
+    int m_fd;
+    size_t m_size;
+    uint8_t *m_base;
+    InceptionV3ShmRingHeader *m_header;
+    InceptionV3ShmSlot *m_slots;
+
+    std::vector<uint32_t> m_epochs;     // producer: epoch of each slot this process claimed
+    uint64_t m_abandon_ns;              // service: reclaim WRITING/DONE slots this old
+    uint64_t m_next_sweep_ns;
+};
+
+// C entry points so that Python producers (basic_pipelines/hailo_shm_ring.py) can
+// use the ring through ctypes.
+extern "C" {
+void *inception_v3_shm_open(const char *name);
+void inception_v3_shm_close(void *ring);
+uint32_t inception_v3_shm_slot_size(void *ring);
+int inception_v3_shm_acquire(void *ring, int timeout_ms);
+uint8_t *inception_v3_shm_slot_data(void *ring, int slot);
+// Returns 0, or -1 when the service reclaimed the slot before the submit.
+int inception_v3_shm_submit(void *ring, int slot, uint32_t stream_id, uint32_t frame_size, uint32_t flags);
+// Returns 1 with a result, 0 below threshold, -1 on timeout and -2 when the service
+// could not classify the frame, with the error message in label.
+int inception_v3_shm_wait_result(void *ring, int slot, int timeout_ms, float *confidence,
+                                 char *label, size_t label_size);
+}
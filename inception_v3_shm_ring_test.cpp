@@ -0,0 +1,69 @@
+#include "inception_v3_shm_ring.hpp"
+#include "inception_v3_test.hpp"
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Shared-memory ring slots a producer abandons, one mid-write (as after a
+// crash) and one whose result it never collects, must come back to the ring
+// after abandon_after, and the producer must learn that they are gone.
+
+namespace
+{
+void check_reclaim()
+{
+    const std::string name = "/inception_v3_shm_ring_test_" + std::to_string(getpid());
+    InceptionV3ShmRing service(name, 2, 64, std::chrono::milliseconds(200));
+    InceptionV3ShmRing producer(name);
+    std::vector<int> ready;
+
+    const int writing = producer.acquire(std::chrono::milliseconds(0));
+    const int done = producer.acquire(std::chrono::milliseconds(0));
+    inception_v3_check(writing >= 0 && done >= 0, "reclaim", "claims every slot", 0);
+    producer.submit(done, 7, 64, INCEPTION_V3_SHM_WANT_RESULT);
+    inception_v3_check(service.take_ready(ready, 8, std::chrono::milliseconds(100)) == 1 && ready[0] == done,
+                       "reclaim", "takes the submitted slot", 0);
+    service.complete(done, true, 0.9f, "tabby");
+
+    // Nothing is free until the slots have been abandoned for 200 ms.
+    inception_v3_check(producer.acquire(std::chrono::milliseconds(50)) == -1, "reclaim", "ring full while owned", 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    service.take_ready(ready, 8, std::chrono::milliseconds(0));
+
+    const int first = producer.acquire(std::chrono::milliseconds(0));
+    const int second = producer.acquire(std::chrono::milliseconds(0));
+    inception_v3_check(first >= 0 && second >= 0, "reclaim", "abandoned slots are free again", 0);
+
+    // The old claims are gone: its result reads as an error, and a late submit throws.
+    InceptionV3ShmResultStatus status = INCEPTION_V3_SHM_RESULT_VALID;
+    float confidence = 0.0f;
+    std::string label;
+    bool reported = producer.wait_result(done, std::chrono::milliseconds(0), status, confidence, label);
+    inception_v3_check(reported && status == INCEPTION_V3_SHM_RESULT_ERROR, "reclaim", "uncollected result", 0);
+
+    InceptionV3ShmRing late(name);
+    bool threw = false;
+    try {
+        late.submit(writing, 7, 64, 0);
+    } catch (const std::runtime_error &) {
+        threw = true;
+    }
+    inception_v3_check(threw, "reclaim", "submit into a reclaimed slot", 0);
+
+    // Slots in use within abandon_after are left alone.
+    producer.submit(first, 7, 64, INCEPTION_V3_SHM_WANT_RESULT);
+    service.take_ready(ready, 8, std::chrono::milliseconds(100));
+    service.complete(first, false, 0.1f, "");
+    inception_v3_check(producer.wait_result(first, std::chrono::milliseconds(100), status, confidence, label) &&
+                           status == INCEPTION_V3_SHM_RESULT_BELOW_THRESHOLD,
+                       "reclaim", "result collected in time", 0);
+}
+} // namespace
+
+int main()
+{
+    check_reclaim();
+    return inception_v3_test_result();
+}
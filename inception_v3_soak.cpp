@@ -0,0 +1,392 @@
+#include "inception_v3_pipeline.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <unistd.h>
+
+// Long-running soak of the native pipeline.
+//
+// Runs synthetic cameras (or a looping tensor replay) for --duration seconds and
+// every --interval seconds writes one CSV sample: RSS, heap allocation counts,
+// throughput and capture-to-result latency percentiles of that interval. After
+// --warmup the first samples set the baseline, and the soak fails (exit 2) as soon
+// as RSS or live allocations grow, or the trailing throughput drifts, beyond the
+// configured limits. Leaks, per-frame allocation churn and creeping queue growth
+// only show on runs this long.
+
+namespace
+{
+std::atomic<uint64_t> g_allocations(0);
+std::atomic<uint64_t> g_frees(0);
+}
+
+// Every ::operator new of the process (the pipeline and the backend included)
+// is counted; plain malloc from C libraries only shows in RSS.
+void *operator new(size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    return ::operator new(size);
+}
+
+void operator delete(void *pointer) noexcept
+{
+    if (pointer) {
+        g_frees.fetch_add(1, std::memory_order_relaxed);
+        std::free(pointer);
+    }
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    ::operator delete(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept
+{
+    ::operator delete(pointer);
+}
+
+void operator delete[](void *pointer, size_t) noexcept
+{
+    ::operator delete(pointer);
+}
+
+namespace
+{
+struct SoakOptions
+{
+    std::string hef_path;
+    std::chrono::microseconds sim_frame_latency{4000};
+    std::chrono::microseconds sim_batch_overhead{500};
+    uint32_t width = 1536;
+    uint32_t height = 864;
+    InceptionV3PixelFormat format = INCEPTION_V3_FORMAT_RGB;
+    double fps = 30.0;
+    size_t streams = 1;
+    std::string replay_path;
+    bool replay_paced = true;
+    InceptionV3PipelineConfig pipeline;
+    double duration_s = 3600.0;
+    double interval_s = 10.0;
+    double warmup_s = 60.0;
+    size_t baseline_samples = 3;    // also the trailing window the drift check averages
+    double max_rss_growth_mb = 16.0;
+    double max_live_allocation_growth = 10000.0;
+    double max_fps_drift = 0.05;
+    std::string csv_path;
+};
+
+void print_usage(const char *program)
+{
+    std::cerr << "Usage: " << program << " [--hef <hef_path> | --simulate <frame_us>[,<batch_overhead_us>]]" << std::endl
+              << "       [--width 1536] [--height 864] [--format RGB|NV12] [--fps 30 (0 = unpaced)] [--streams 1]" << std::endl
+              << "       [--replay tensors.iv3t [--replay-pace original|max]]" << std::endl
+              << "       [--threads 2] [--batch 1] [--queue 4] [--duration 3600] [--interval 10] [--warmup 60]" << std::endl
+              << "       [--max-rss-growth-mb 16] [--max-live-allocation-growth 10000] [--max-fps-drift 0.05]" << std::endl
+              << "       [--csv soak.csv]" << std::endl;
+}
+
+double percentile(std::vector<double> &values, double fraction)
+{
+    if (values.empty()) {
+        return 0.0;
+    }
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(fraction * (values.size() - 1) + 0.5));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+double rss_mb()
+{
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size_pages = 0;
+    uint64_t resident_pages = 0;
+    statm >> size_pages >> resident_pages;
+    return resident_pages * static_cast<double>(sysconf(_SC_PAGESIZE)) / (1024.0 * 1024.0);
+}
+
+struct Sample
+{
+    double elapsed_s = 0.0;
+    double rss_mb = 0.0;
+    uint64_t allocations = 0;
+    int64_t live_allocations = 0;
+    double allocations_per_frame = 0.0;
+    uint64_t completed = 0;
+    uint64_t dropped = 0;
+    double fps = 0.0;
+    double p50_ms = 0.0;
+    double p99_ms = 0.0;
+    double max_ms = 0.0;
+};
+
+// Baseline from the first samples after warmup, then limits on every later one.
+class DriftCheck
+{
+public:
+    explicit DriftCheck(const SoakOptions &options) : m_options(options) {}
+
+    // Returns an empty string while the run is healthy, otherwise the reason it failed.
+    std::string add(const Sample &sample)
+    {
+        if (sample.elapsed_s < m_options.warmup_s) {
+            return "";
+        }
+        m_recent.push_back(sample.fps);
+        if (m_recent.size() > m_options.baseline_samples) {
+            m_recent.erase(m_recent.begin());
+        }
+
+        if (m_baseline_count < m_options.baseline_samples) {
+            // The baseline memory figures are the largest seen while it forms.
+            m_rss_mb = std::max(m_rss_mb, sample.rss_mb);
+            m_live_allocations = std::max(m_live_allocations, sample.live_allocations);
+            m_fps += sample.fps / m_options.baseline_samples;
+            m_baseline_count++;
+            return "";
+        }
+
+        std::ostringstream reason;
+        if (sample.rss_mb - m_rss_mb > m_options.max_rss_growth_mb) {
+            reason << "RSS grew " << sample.rss_mb - m_rss_mb << " MB over the baseline " << m_rss_mb << " MB";
+        } else if (sample.live_allocations - m_live_allocations > m_options.max_live_allocation_growth) {
+            reason << "live allocations grew by " << sample.live_allocations - m_live_allocations << " over the baseline "
+                   << m_live_allocations;
+        } else if (m_fps > 0.0) {
+            double trailing = 0.0;
+            for (double fps : m_recent) {
+                trailing += fps / m_recent.size();
+            }
+            if (std::abs(trailing - m_fps) > m_options.max_fps_drift * m_fps) {
+                reason << "throughput drifted to " << trailing << " fps from the baseline " << m_fps << " fps";
+            }
+        }
+        return reason.str();
+    }
+
+private:
+    const SoakOptions &m_options;
+    size_t m_baseline_count = 0;
+    double m_rss_mb = 0.0;
+    int64_t m_live_allocations = 0;
+    double m_fps = 0.0;
+    std::vector<double> m_recent;
+};
+}
+
+int main(int argc, char *argv[])
+{
+    SoakOptions options;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            std::string value = argv[++i];
+            if (arg == "--hef") {
+                options.hef_path = value;
+            } else if (arg == "--simulate") {
+                size_t comma = value.find(',');
+                options.sim_frame_latency = std::chrono::microseconds(std::stoul(value.substr(0, comma)));
+                if (comma != std::string::npos) {
+                    options.sim_batch_overhead = std::chrono::microseconds(std::stoul(value.substr(comma + 1)));
+                }
+            } else if (arg == "--width") {
+                options.width = static_cast<uint32_t>(std::stoul(value));
+            } else if (arg == "--height") {
+                options.height = static_cast<uint32_t>(std::stoul(value));
+            } else if (arg == "--format") {
+                if (!parse_inception_v3_pixel_format(value, options.format)) {
+                    throw std::invalid_argument("unknown format " + value);
+                }
+            } else if (arg == "--fps") {
+                options.fps = std::stod(value);
+            } else if (arg == "--streams") {
+                options.streams = std::stoul(value);
+            } else if (arg == "--replay") {
+                options.replay_path = value;
+            } else if (arg == "--replay-pace") {
+                if (value != "original" && value != "max") {
+                    throw std::invalid_argument("--replay-pace must be original or max");
+                }
+                options.replay_paced = value == "original";
+            } else if (arg == "--threads") {
+                options.pipeline.preprocess_threads = std::stoul(value);
+            } else if (arg == "--batch") {
+                options.pipeline.batch_size = std::stoul(value);
+            } else if (arg == "--queue") {
+                options.pipeline.queue_depth = std::stoul(value);
+            } else if (arg == "--duration") {
+                options.duration_s = std::stod(value);
+            } else if (arg == "--interval") {
+                options.interval_s = std::stod(value);
+            } else if (arg == "--warmup") {
+                options.warmup_s = std::stod(value);
+            } else if (arg == "--max-rss-growth-mb") {
+                options.max_rss_growth_mb = std::stod(value);
+            } else if (arg == "--max-live-allocation-growth") {
+                options.max_live_allocation_growth = std::stod(value);
+            } else if (arg == "--max-fps-drift") {
+                options.max_fps_drift = std::stod(value);
+            } else if (arg == "--csv") {
+                options.csv_path = value;
+            } else {
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+
+        if (options.interval_s <= 0.0 || options.duration_s <= 0.0 || options.streams == 0) {
+            throw std::invalid_argument("--interval, --duration and --streams must be positive");
+        }
+
+        auto params = init_inception_v3("./imagenet_classes.txt", 0.5f);
+        std::unique_ptr<InceptionV3Backend> backend;
+        if (!options.hef_path.empty()) {
+            backend.reset(new InceptionV3HailoBackend(options.hef_path));
+        } else {
+            backend.reset(new InceptionV3SimulatedBackend(options.sim_frame_latency, options.sim_batch_overhead));
+        }
+        InceptionV3Runner runner(std::move(backend), params);
+
+        std::ofstream csv_file;
+        if (!options.csv_path.empty()) {
+            csv_file.open(options.csv_path);
+            if (!csv_file) {
+                throw std::runtime_error("cannot write " + options.csv_path);
+            }
+        }
+        std::ostream &csv = options.csv_path.empty() ? std::cout : csv_file;
+
+        // Latencies of the current interval; the sampler swaps in a second buffer
+        // of the same capacity, so steady state collection does not allocate.
+        std::mutex latency_mutex;
+        std::vector<double> latencies_ms;
+        std::vector<double> interval_ms;
+
+        InceptionV3Pipeline pipeline(runner, options.pipeline, [&](const InceptionV3PipelineResult &result) {
+            std::lock_guard<std::mutex> lock(latency_mutex);
+            latencies_ms.push_back((result.done_time_ns - result.capture_time_ns) / 1e6);
+        });
+
+        std::unique_ptr<InceptionV3TensorRecording> replay;
+        if (!options.replay_path.empty()) {
+            replay.reset(new InceptionV3TensorRecording(options.replay_path));
+            pipeline.add_source(std::unique_ptr<InceptionV3FrameSource>(
+                new InceptionV3ReplaySource(*replay, options.replay_paced, true)));
+        } else {
+            for (size_t s = 0; s < options.streams; s++) {
+                pipeline.add_source(std::unique_ptr<InceptionV3FrameSource>(new InceptionV3SyntheticSource(
+                    static_cast<uint32_t>(s), options.width, options.height, options.format, options.fps, 0)));
+            }
+        }
+
+        std::exception_ptr pipeline_error;
+        std::atomic<bool> pipeline_ended(false);
+        std::thread runner_thread([&]() {
+            try {
+                pipeline.run();
+            } catch (...) {
+                pipeline_error = std::current_exception();
+            }
+            pipeline_ended = true;
+        });
+
+        csv << "elapsed_s,rss_mb,allocations,live_allocations,allocations_per_frame,completed,dropped,"
+               "throughput_fps,latency_p50_ms,latency_p99_ms,latency_max_ms\n";
+
+        DriftCheck check(options);
+        std::string failure;
+        auto start = std::chrono::steady_clock::now();
+        auto last = start;
+        uint64_t last_completed = 0;
+        uint64_t last_allocations = g_allocations.load(std::memory_order_relaxed);
+        for (uint64_t tick = 1; failure.empty(); tick++) {
+            auto due = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                   std::chrono::duration<double>(tick * options.interval_s));
+            std::this_thread::sleep_until(due);
+            auto now = std::chrono::steady_clock::now();
+
+            {
+                std::lock_guard<std::mutex> lock(latency_mutex);
+                interval_ms.clear();
+                interval_ms.reserve(latencies_ms.capacity());
+                latencies_ms.swap(interval_ms);
+            }
+
+            Sample sample;
+            auto stats = pipeline.stats();
+            const uint64_t allocations = g_allocations.load(std::memory_order_relaxed);
+            const double seconds = std::chrono::duration<double>(now - last).count();
+            sample.elapsed_s = std::chrono::duration<double>(now - start).count();
+            sample.rss_mb = rss_mb();
+            sample.allocations = allocations;
+            sample.live_allocations = static_cast<int64_t>(allocations - g_frees.load(std::memory_order_relaxed));
+            sample.completed = stats.completed;
+            sample.dropped = stats.dropped;
+            sample.fps = (stats.completed - last_completed) / seconds;
+            sample.allocations_per_frame = stats.completed > last_completed
+                                               ? static_cast<double>(allocations - last_allocations) /
+                                                     (stats.completed - last_completed)
+                                               : 0.0;
+            sample.p50_ms = percentile(interval_ms, 0.50);
+            sample.p99_ms = percentile(interval_ms, 0.99);
+            sample.max_ms = interval_ms.empty() ? 0.0 : *std::max_element(interval_ms.begin(), interval_ms.end());
+            last = now;
+            last_completed = stats.completed;
+            last_allocations = allocations;
+
+            csv << std::fixed << std::setprecision(1) << sample.elapsed_s << ',' << sample.rss_mb << ','
+                << sample.allocations << ',' << sample.live_allocations << ',' << std::setprecision(2)
+                << sample.allocations_per_frame << ',' << sample.completed << ',' << sample.dropped << ','
+                << sample.fps << ',' << std::setprecision(3) << sample.p50_ms << ',' << sample.p99_ms << ','
+                << sample.max_ms << '\n'
+                << std::defaultfloat;
+            csv.flush();
+
+            failure = check.add(sample);
+            if (pipeline_ended) {
+                failure = "pipeline stopped before the end of the soak";
+            } else if (sample.elapsed_s >= options.duration_s) {
+                break;
+            }
+        }
+
+        pipeline.stop();
+        runner_thread.join();
+        free_resources(params);
+        if (pipeline_error) {
+            std::rethrow_exception(pipeline_error);
+        }
+
+        if (!failure.empty()) {
+            std::cerr << "Soak FAILED: " << failure << std::endl;
+            return 2;
+        }
+        std::cerr << "Soak passed: " << options.duration_s << " s, " << pipeline.stats().completed << " frames" << std::endl;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
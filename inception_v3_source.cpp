@@ -0,0 +1,84 @@
+#include "inception_v3_source.hpp"
+#include <cstring>
+#include <thread>
+#include <time.h>
+
+namespace
+{
+const uint32_t SCROLL_PIXELS = 256;
+
+// Bytes per scroll step; NV12 moves by two so U/V pairs stay aligned.
+size_t scroll_unit(InceptionV3PixelFormat format)
+{
+    return format == INCEPTION_V3_FORMAT_RGB ? 3 : 2;
+}
+
+// NV12 is laid out as height luma rows followed by height / 2 interleaved chroma rows.
+size_t frame_rows(InceptionV3PixelFormat format, uint32_t height)
+{
+    return format == INCEPTION_V3_FORMAT_NV12 ? height * 3 / 2 : height;
+}
+}
+
+uint64_t inception_v3_now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+InceptionV3SyntheticSource::InceptionV3SyntheticSource(uint32_t stream_id, uint32_t width, uint32_t height,
+                                                       InceptionV3PixelFormat format, double fps,
+                                                       uint64_t frame_count)
+    : m_stream_id(stream_id), m_width(width), m_height(height), m_format(format), m_fps(fps),
+      m_frame_count(frame_count), m_seq(0), m_start(std::chrono::steady_clock::now())
+{
+    // Rows of the pattern are wider than the frame, and each frame copies them at a
+    // different horizontal offset. Producing a frame then costs what a camera
+    // driver's copy would, not a per-pixel synthesis loop.
+    const size_t rows = frame_rows(format, height);
+    const size_t row_bytes = inception_v3_frame_bytes(format, width, height) / rows;
+    const size_t margin = SCROLL_PIXELS * scroll_unit(format);
+
+    m_pattern_stride = row_bytes + margin;
+    m_pattern.resize(m_pattern_stride * rows);
+    for (size_t row = 0; row < rows; row++) {
+        uint8_t *out = &m_pattern[row * m_pattern_stride];
+        bool chroma = format == INCEPTION_V3_FORMAT_NV12 && row >= height;
+        for (size_t i = 0; i < m_pattern_stride; i++) {
+            out[i] = chroma ? static_cast<uint8_t>(128 + ((i / 64 + row) & 0x1f))
+                            : static_cast<uint8_t>((i / 3 + row * 2 + (i % 3) * 85) & 0xff);
+        }
+    }
+}
+
+bool InceptionV3SyntheticSource::next(InceptionV3Frame &frame)
+{
+    if (m_frame_count != 0 && m_seq >= m_frame_count) {
+        return false;
+    }
+
+    if (m_fps > 0.0) {
+        auto due = m_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                 std::chrono::duration<double>(m_seq / m_fps));
+        std::this_thread::sleep_until(due);
+    }
+
+    const size_t frame_bytes = inception_v3_frame_bytes(m_format, m_width, m_height);
+    const size_t rows = frame_rows(m_format, m_height);
+    const size_t row_bytes = frame_bytes / rows;
+    const size_t offset = (m_seq % SCROLL_PIXELS) * scroll_unit(m_format);
+
+    frame.data.resize(frame_bytes);
+    for (size_t row = 0; row < rows; row++) {
+        std::memcpy(&frame.data[row * row_bytes], &m_pattern[row * m_pattern_stride + offset], row_bytes);
+    }
+
+    frame.stream_id = m_stream_id;
+    frame.seq = m_seq++;
+    frame.capture_time_ns = inception_v3_now_ns();
+    frame.width = m_width;
+    frame.height = m_height;
+    frame.format = m_format;
+    return true;
+}
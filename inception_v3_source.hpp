@@ -0,0 +1,61 @@
+#pragma once
+#include "inception_v3_image.hpp"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+uint64_t inception_v3_now_ns(); // CLOCK_MONOTONIC
+
+struct InceptionV3Frame
+{
+    uint32_t stream_id = 0;
+    uint64_t seq = 0;
+    uint64_t capture_time_ns = 0;
+    uint64_t pts_ns = 0;        // media timestamp from the start of a file source, 0 for cameras
+    uint32_t width = 0;
+    uint32_t height = 0;
+    InceptionV3PixelFormat format = INCEPTION_V3_FORMAT_RGB;
+    std::vector<uint8_t> data; // reused between frames, callers should not shrink it
+};
+
+class InceptionV3FrameSource
+{
+public:
+    virtual ~InceptionV3FrameSource() = default;
+
+    // Blocks until the next frame is available. Returns false at end of stream.
+    virtual bool next(InceptionV3Frame &frame) = 0;
+
+    // Called from another thread when the pipeline fails, so that a next() blocked
+    // waiting for input returns false. Sources whose next() never waits for long
+    // can ignore it.
+    virtual void close() {}
+
+    // Live sources (cameras) cannot be paused, so the pipeline drops their frames
+    // instead of blocking when it falls behind.
+    virtual bool live() const { return false; }
+};
+
+// Camera stand-in: a scrolling gradient at a fixed resolution, format and rate.
+// fps == 0 produces frames as fast as the pipeline takes them; frame_count == 0 never ends.
+class InceptionV3SyntheticSource : public InceptionV3FrameSource
+{
+public:
+    InceptionV3SyntheticSource(uint32_t stream_id, uint32_t width, uint32_t height, InceptionV3PixelFormat format,
+                               double fps, uint64_t frame_count);
+
+    bool next(InceptionV3Frame &frame) override;
+    bool live() const override { return m_fps > 0.0; }
+
+private:
+    uint32_t m_stream_id;
+    uint32_t m_width;
+    uint32_t m_height;
+    InceptionV3PixelFormat m_format;
+    double m_fps;
+    uint64_t m_frame_count;
+    uint64_t m_seq;
+    std::chrono::steady_clock::time_point m_start;
+    std::vector<uint8_t> m_pattern; // frame_bytes wide rows plus scroll margin
+    size_t m_pattern_stride;
+};
@@ -0,0 +1,181 @@
+#include "inception_v3_temporal.hpp"
+#include "inception_v3_kernels.hpp"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+InceptionV3SmoothingConfig InceptionV3SmoothingConfig::parse(const std::string &spec)
+{
+    InceptionV3SmoothingConfig config;
+    std::stringstream stream(spec);
+    std::string entry;
+    while (std::getline(stream, entry, ';')) {
+        if (entry.empty()) {
+            continue;
+        }
+        auto equals = entry.find('=');
+        if (equals == std::string::npos) {
+            throw std::invalid_argument("smoothing entry without '=': " + entry);
+        }
+
+        std::string key = entry.substr(0, equals);
+        std::string value = entry.substr(equals + 1);
+        if (key == "ema") {
+            config.mode = INCEPTION_V3_SMOOTH_EMA;
+            config.alpha = std::stof(value);
+        } else if (key == "window") {
+            config.mode = INCEPTION_V3_SMOOTH_WINDOW;
+            config.window = std::stoul(value);
+        } else if (key == "enter") {
+            config.enter = std::stof(value);
+        } else if (key == "exit") {
+            config.exit = std::stof(value);
+        } else {
+            throw std::invalid_argument("unknown smoothing option " + key);
+        }
+    }
+
+    if (!(config.alpha > 0.0f && config.alpha <= 1.0f)) {
+        throw std::invalid_argument("ema weight must be within (0, 1]");
+    }
+    if (config.window == 0 || config.window > 256) {
+        throw std::invalid_argument("smoothing window must be 1 to 256 frames");
+    }
+    if (!(config.exit <= config.enter)) {
+        throw std::invalid_argument("smoothing exit threshold must not exceed enter");
+    }
+    return config;
+}
+
+InceptionV3TemporalFilter::InceptionV3TemporalFilter(const InceptionV3SmoothingConfig &config, size_t classes,
+                                                     size_t max_streams, std::chrono::seconds idle_timeout)
+    : m_config(config), m_classes(std::min<size_t>(classes, 0xFFFF)),
+      m_alpha_q8(static_cast<uint32_t>(std::max(1.0f, std::round(config.alpha * 256.0f)))),
+      m_max_streams(max_streams > 0 ? max_streams : 1), m_idle_timeout(idle_timeout),
+      m_next_sweep(std::chrono::steady_clock::now() + std::chrono::seconds(1))
+{}
+
+void InceptionV3TemporalFilter::reset(uint32_t stream_id)
+{
+    m_streams.erase(stream_id);
+}
+
+int InceptionV3TemporalFilter::stable_class(uint32_t stream_id) const
+{
+    auto it = m_streams.find(stream_id);
+    return it == m_streams.end() ? -1 : it->second.stable_class;
+}
+
+InceptionV3TemporalFilter::StreamState &InceptionV3TemporalFilter::stream(uint32_t stream_id,
+                                                                          std::chrono::steady_clock::time_point now)
+{
+    if (now >= m_next_sweep) {
+        evict(now);
+        m_next_sweep = now + std::chrono::seconds(1);
+    }
+
+    auto it = m_streams.find(stream_id);
+    if (it == m_streams.end()) {
+        if (m_streams.size() >= m_max_streams) {
+            auto oldest = m_streams.begin();
+            for (auto candidate = m_streams.begin(); candidate != m_streams.end(); ++candidate) {
+                if (candidate->second.last_update < oldest->second.last_update) {
+                    oldest = candidate;
+                }
+            }
+            m_streams.erase(oldest);
+        }
+        it = m_streams.emplace(stream_id, StreamState()).first;
+        it->second.smoothed.assign(m_classes, 0);
+        if (m_config.mode == INCEPTION_V3_SMOOTH_WINDOW) {
+            it->second.history.assign(m_config.window * m_classes, 0);
+        }
+    }
+    it->second.last_update = now;
+    return it->second;
+}
+
+void InceptionV3TemporalFilter::evict(std::chrono::steady_clock::time_point now)
+{
+    for (auto it = m_streams.begin(); it != m_streams.end();) {
+        if (now - it->second.last_update >= m_idle_timeout) {
+            it = m_streams.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+// Updates the smoothed scores and returns their argmax (lowest id on ties).
+int InceptionV3TemporalFilter::accumulate(StreamState &state, const uint8_t *scores)
+{
+    const uint32_t classes = static_cast<uint32_t>(m_classes);
+    const InceptionV3Kernels &kernels = inception_v3_kernels();
+    int top;
+
+    if (m_config.mode == INCEPTION_V3_SMOOTH_EMA) {
+        // First frame seeds the average, later ones move it by alpha (Q8.8 fixed point).
+        const int32_t alpha = state.frames == 0 ? 256 : static_cast<int32_t>(m_alpha_q8);
+        top = kernels.ema_update_u8(state.smoothed.data(), scores, classes, alpha);
+    } else {
+        // Running sums over the last window frames; the oldest frame is subtracted
+        // once the ring is full.
+        uint8_t *oldest = &state.history[(state.frames % m_config.window) * m_classes];
+        const uint32_t keep = state.frames >= m_config.window ? 0xFFu : 0u;
+        top = kernels.window_update_u8(state.smoothed.data(), oldest, scores, classes, keep);
+    }
+
+    state.frames++;
+    return top;
+}
+
+float InceptionV3TemporalFilter::confidence(const StreamState &state, int class_id) const
+{
+    if (m_config.mode == INCEPTION_V3_SMOOTH_EMA) {
+        return state.smoothed[class_id] / (255.0f * 256.0f);
+    }
+    size_t frames = std::min<size_t>(state.frames, m_config.window);
+    return state.smoothed[class_id] / (255.0f * frames);
+}
+
+bool InceptionV3TemporalFilter::update(uint32_t stream_id, uint64_t seq, const uint8_t *scores,
+                                       InceptionV3TemporalEvent &event)
+{
+    auto &state = stream(stream_id, std::chrono::steady_clock::now());
+
+    int top = accumulate(state, scores);
+    float top_confidence = confidence(state, top);
+
+    event.stream_id = stream_id;
+    event.seq = seq;
+    event.previous_class_id = state.stable_class;
+
+    if (state.stable_class >= 0) {
+        float stable_confidence = confidence(state, state.stable_class);
+        // A challenger must clear enter and beat the stable class by the band width,
+        // so two close classes do not flap.
+        if (top != state.stable_class && top_confidence >= m_config.enter &&
+            top_confidence >= stable_confidence + (m_config.enter - m_config.exit)) {
+            event.kind = INCEPTION_V3_EVENT_CHANGED;
+            event.class_id = top;
+            event.confidence = top_confidence;
+        } else if (stable_confidence < m_config.exit) {
+            event.kind = INCEPTION_V3_EVENT_CLEARED;
+            event.class_id = state.stable_class;
+            event.confidence = stable_confidence;
+            top = -1;
+        } else {
+            return false;
+        }
+    } else if (top_confidence >= m_config.enter) {
+        event.kind = INCEPTION_V3_EVENT_CHANGED;
+        event.class_id = top;
+        event.confidence = top_confidence;
+    } else {
+        return false;
+    }
+
+    state.stable_class = top;
+    return true;
+}
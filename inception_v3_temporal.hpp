@@ -0,0 +1,95 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum InceptionV3SmoothingMode
+{
+    INCEPTION_V3_SMOOTH_EMA,
+    INCEPTION_V3_SMOOTH_WINDOW,
+};
+
+// Parsed from a spec such as "ema=0.25;enter=0.6;exit=0.4" or "window=8;enter=0.6;exit=0.4".
+struct InceptionV3SmoothingConfig
+{
+    InceptionV3SmoothingMode mode = INCEPTION_V3_SMOOTH_EMA;
+    float alpha = 0.25f;        // EMA weight of the newest frame
+    size_t window = 8;          // frames averaged in window mode, at most 256
+    float enter = 0.6f;         // smoothed confidence at which a class becomes the stable top-1
+    float exit = 0.4f;          // confidence below which the stable class is dropped; another class
+                                // replaces it only when leading it by at least enter - exit
+
+    static InceptionV3SmoothingConfig parse(const std::string &spec);
+};
+
+enum InceptionV3TemporalEventKind
+{
+    INCEPTION_V3_EVENT_CHANGED,     // a new stable top-1 class (class_id)
+    INCEPTION_V3_EVENT_CLEARED,     // the stable class fell below exit, nothing is stable now
+};
+
+struct InceptionV3TemporalEvent
+{
+    InceptionV3TemporalEventKind kind = INCEPTION_V3_EVENT_CHANGED;
+    uint32_t stream_id = 0;
+    uint64_t seq = 0;
+    int class_id = -1;
+    int previous_class_id = -1;
+    float confidence = 0.0f;    // smoothed confidence of class_id (of the dropped class when CLEARED)
+};
+
+// Per-stream smoothing of the raw fc1 score vector with change-only output.
+//
+// Scores are kept in fixed point (Q8.8 EMA or uint16 window sums) and updated in
+// one branch-free pass that also tracks the argmax (a kernel built per
+// instruction set, see inception_v3_kernels.hpp). update() reports an event only
+// when the stable top-1 changes or crosses the enter/exit hysteresis band, so
+// steady scenes produce no output.
+//
+// Stream state is created on a stream's first frame and bounded like the result
+// boards: a stream without frames for idle_timeout is dropped, and at most
+// max_streams are kept, the least recently updated one making room. A dropped
+// stream starts over from nothing when it shows up again.
+class InceptionV3TemporalFilter
+{
+public:
+    explicit InceptionV3TemporalFilter(const InceptionV3SmoothingConfig &config, size_t classes = 1000,
+                                       size_t max_streams = 256,
+                                       std::chrono::seconds idle_timeout = std::chrono::seconds(300));
+
+    // Feeds one frame's scores (classes bytes). Returns true and fills event if
+    // the stable state of the stream changed.
+    bool update(uint32_t stream_id, uint64_t seq, const uint8_t *scores, InceptionV3TemporalEvent &event);
+
+    void reset(uint32_t stream_id);
+
+    // Stable class of the stream, -1 if none.
+    int stable_class(uint32_t stream_id) const;
+    size_t streams() const { return m_streams.size(); }
+
+private:
+    struct StreamState
+    {
+        std::vector<uint16_t> smoothed;     // EMA in Q8.8, or window sum
+        std::vector<uint8_t> history;       // window mode: window x classes ring of past frames
+        size_t frames = 0;
+        int stable_class = -1;
+        std::chrono::steady_clock::time_point last_update;
+    };
+
+    StreamState &stream(uint32_t stream_id, std::chrono::steady_clock::time_point now);
+    void evict(std::chrono::steady_clock::time_point now);
+    int accumulate(StreamState &state, const uint8_t *scores);
+    float confidence(const StreamState &state, int class_id) const;
+
+    InceptionV3SmoothingConfig m_config;
+    size_t m_classes;
+    uint32_t m_alpha_q8;
+    size_t m_max_streams;
+    std::chrono::steady_clock::duration m_idle_timeout;
+    std::chrono::steady_clock::time_point m_next_sweep;
+    std::unordered_map<uint32_t, StreamState> m_streams;
+};
@@ -0,0 +1,197 @@
+#include "inception_v3_tensor_file.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace
+{
+std::runtime_error errno_error(const std::string &what)
+{
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+size_t record_stride(size_t frame_size)
+{
+    return sizeof(InceptionV3TensorRecord) + (frame_size + 63) / 64 * 64;
+}
+}
+
+InceptionV3TensorRecorder::InceptionV3TensorRecorder(const std::string &path, const hailo_vstream_info_t &input_info,
+                                                     size_t frame_size, uint64_t capacity)
+    : m_fd(-1), m_size(0), m_base(nullptr), m_header(nullptr)
+{
+    if (capacity == 0) {
+        throw std::invalid_argument("tensor recording needs room for at least one frame");
+    }
+
+    m_fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (m_fd < 0) {
+        throw errno_error("open " + path);
+    }
+    m_size = sizeof(InceptionV3TensorFileHeader) + capacity * record_stride(frame_size);
+    if (ftruncate(m_fd, static_cast<off_t>(m_size)) < 0) {
+        auto error = errno_error("ftruncate " + path);
+        close(m_fd);
+        throw error;
+    }
+    void *mapping = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (mapping == MAP_FAILED) {
+        auto error = errno_error("mmap " + path);
+        close(m_fd);
+        throw error;
+    }
+
+    m_base = static_cast<uint8_t *>(mapping);
+    m_header = new (m_base) InceptionV3TensorFileHeader();
+    m_header->magic = INCEPTION_V3_TENSOR_MAGIC;
+    m_header->version = INCEPTION_V3_TENSOR_VERSION;
+    m_header->frame_size = static_cast<uint32_t>(frame_size);
+    m_header->record_stride = static_cast<uint32_t>(record_stride(frame_size));
+    m_header->width = input_info.shape.width;
+    m_header->height = input_info.shape.height;
+    m_header->features = input_info.shape.features;
+    m_header->capacity = capacity;
+    m_header->frame_count.store(0, std::memory_order_release);
+}
+
+InceptionV3TensorRecorder::~InceptionV3TensorRecorder()
+{
+    // Drop the unused preallocated tail.
+    const size_t used = sizeof(InceptionV3TensorFileHeader) + size() * m_header->record_stride;
+    munmap(m_base, m_size);
+    if (ftruncate(m_fd, static_cast<off_t>(used)) < 0) {
+        // The file is still valid, just longer than needed.
+    }
+    close(m_fd);
+}
+
+bool InceptionV3TensorRecorder::append(uint32_t stream_id, uint64_t seq, uint64_t capture_time_ns,
+                                       const uint8_t *tensor)
+{
+    const uint64_t index = size();
+    if (index >= m_header->capacity) {
+        return false;
+    }
+
+    uint8_t *slot = m_base + sizeof(InceptionV3TensorFileHeader) + index * m_header->record_stride;
+    InceptionV3TensorRecord record = {};
+    record.capture_time_ns = capture_time_ns;
+    record.seq = seq;
+    record.stream_id = stream_id;
+    std::memcpy(slot, &record, sizeof(record));
+    std::memcpy(slot + sizeof(record), tensor, m_header->frame_size);
+
+    // A reader mapping a file mid-recording sees only complete frames.
+    m_header->frame_count.store(index + 1, std::memory_order_release);
+    return true;
+}
+
+InceptionV3TensorRecording::InceptionV3TensorRecording(const std::string &path)
+    : m_size(0), m_base(nullptr), m_header(nullptr), m_count(0)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw errno_error("open " + path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) < 0) {
+        auto error = errno_error("stat " + path);
+        close(fd);
+        throw error;
+    }
+    m_size = static_cast<size_t>(info.st_size);
+    if (m_size < sizeof(InceptionV3TensorFileHeader)) {
+        close(fd);
+        throw std::runtime_error(path + " is not an inception_v3 tensor recording");
+    }
+    void *mapping = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        throw errno_error("mmap " + path);
+    }
+
+    m_base = static_cast<uint8_t *>(mapping);
+    m_header = reinterpret_cast<const InceptionV3TensorFileHeader *>(m_base);
+    if (m_header->magic != INCEPTION_V3_TENSOR_MAGIC || m_header->version != INCEPTION_V3_TENSOR_VERSION ||
+        m_header->record_stride != record_stride(m_header->frame_size)) {
+        munmap(m_base, m_size);
+        throw std::runtime_error(path + " is not an inception_v3 tensor recording");
+    }
+
+    // Trust the count only as far as the file really extends (e.g. a recorder that crashed).
+    const uint64_t available = (m_size - sizeof(InceptionV3TensorFileHeader)) / m_header->record_stride;
+    m_count = std::min<uint64_t>(m_header->frame_count.load(std::memory_order_acquire), available);
+}
+
+InceptionV3TensorRecording::~InceptionV3TensorRecording()
+{
+    munmap(m_base, m_size);
+}
+
+const InceptionV3TensorRecord &InceptionV3TensorRecording::record(uint64_t index) const
+{
+    return *reinterpret_cast<const InceptionV3TensorRecord *>(m_base + sizeof(InceptionV3TensorFileHeader) +
+                                                              index * m_header->record_stride);
+}
+
+uint8_t *InceptionV3TensorRecording::tensor(uint64_t index) const
+{
+    return m_base + sizeof(InceptionV3TensorFileHeader) + index * m_header->record_stride +
+           sizeof(InceptionV3TensorRecord);
+}
+
+InceptionV3ReplaySource::InceptionV3ReplaySource(const InceptionV3TensorRecording &recording, bool paced, bool loop)
+    : m_recording(recording), m_paced(paced), m_loop(loop), m_index(0), m_lap(0), m_started(false)
+{
+    const auto &header = recording.header();
+    if (header.features != 3 || header.frame_size != static_cast<size_t>(header.width) * header.height * 3) {
+        throw std::runtime_error("tensor recording is not an RGB frame of its recorded shape");
+    }
+}
+
+bool InceptionV3ReplaySource::next(InceptionV3Frame &frame)
+{
+    // Pipeline setup between construction and the first pull must not count
+    // against the recorded gaps, or the first frames go out in a burst.
+    if (!m_started) {
+        m_start = std::chrono::steady_clock::now();
+        m_started = true;
+    }
+    if (m_index >= m_recording.size()) {
+        if (!m_loop || m_recording.size() == 0) {
+            return false;
+        }
+        // The next lap starts one average frame interval after the last frame.
+        const uint64_t span = m_recording.record(m_recording.size() - 1).capture_time_ns -
+                              m_recording.record(0).capture_time_ns;
+        m_start += std::chrono::nanoseconds(span + span / std::max<uint64_t>(m_recording.size() - 1, 1));
+        m_index = 0;
+        m_lap++;
+    }
+
+    const auto &record = m_recording.record(m_index);
+    if (m_paced) {
+        const uint64_t first = m_recording.record(0).capture_time_ns;
+        const uint64_t offset = record.capture_time_ns > first ? record.capture_time_ns - first : 0;
+        std::this_thread::sleep_until(m_start + std::chrono::nanoseconds(offset));
+    }
+
+    const auto &header = m_recording.header();
+    const uint8_t *tensor = m_recording.tensor(m_index);
+    frame.data.assign(tensor, tensor + header.frame_size);
+    frame.stream_id = record.stream_id;
+    frame.seq = record.seq + m_lap * m_recording.size();
+    frame.capture_time_ns = inception_v3_now_ns();
+    frame.width = header.width;
+    frame.height = header.height;
+    frame.format = INCEPTION_V3_FORMAT_RGB;
+    m_index++;
+    return true;
+}
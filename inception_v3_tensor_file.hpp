@@ -0,0 +1,117 @@
+#pragma once
+#include "hailo/hailort.hpp"
+#include "inception_v3_source.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Recording of the exact inception-v3/input_layer1 tensors of a run, for replay
+// on the bench without camera or decode variance.
+//
+// Layout: InceptionV3TensorFileHeader, then one 64-byte InceptionV3TensorRecord
+// per frame, each followed by the tensor padded to 64 bytes. The file is
+// preallocated and written through mmap, and truncated to the recorded frames
+// when the recorder closes. A replay maps it, so each tensor reaches the
+// pipeline with one memcpy out of the page cache into the frame buffer, and no
+// read() or decode.
+
+static const uint32_t INCEPTION_V3_TENSOR_MAGIC = 0x49563354; // "IV3T"
+static const uint32_t INCEPTION_V3_TENSOR_VERSION = 1;
+
+struct InceptionV3TensorFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t frame_size;
+    uint32_t record_stride;     // record header + padded tensor
+    uint32_t width;
+    uint32_t height;
+    uint32_t features;
+    uint32_t reserved;
+    uint64_t capacity;          // frames
+    std::atomic<uint64_t> frame_count;
+    uint8_t reserved2[16];
+};
+static_assert(sizeof(InceptionV3TensorFileHeader) == 64, "tensor file header is one cache line");
+
+struct InceptionV3TensorRecord
+{
+    uint64_t capture_time_ns;   // CLOCK_MONOTONIC of the recording process
+    uint64_t seq;
+    uint32_t stream_id;
+    uint32_t reserved;
+    uint8_t reserved2[40];
+};
+static_assert(sizeof(InceptionV3TensorRecord) == 64, "tensor records are one cache line");
+
+// Single writer.
+class InceptionV3TensorRecorder
+{
+public:
+    InceptionV3TensorRecorder(const std::string &path, const hailo_vstream_info_t &input_info, size_t frame_size,
+                              uint64_t capacity);
+    ~InceptionV3TensorRecorder();
+
+    InceptionV3TensorRecorder(const InceptionV3TensorRecorder &) = delete;
+    InceptionV3TensorRecorder &operator=(const InceptionV3TensorRecorder &) = delete;
+
+    // Copies one tensor of frame_size bytes. Returns false once the file is full.
+    bool append(uint32_t stream_id, uint64_t seq, uint64_t capture_time_ns, const uint8_t *tensor);
+
+    uint64_t size() const { return m_header->frame_count.load(std::memory_order_relaxed); }
+
+private:
+    int m_fd;
+    size_t m_size;
+    uint8_t *m_base;
+    InceptionV3TensorFileHeader *m_header;
+};
+
+// Read side. The mapping is private and writable, so a frame can go through the
+// in-place preprocess without touching the file.
+class InceptionV3TensorRecording
+{
+public:
+    explicit InceptionV3TensorRecording(const std::string &path);
+    ~InceptionV3TensorRecording();
+
+    InceptionV3TensorRecording(const InceptionV3TensorRecording &) = delete;
+    InceptionV3TensorRecording &operator=(const InceptionV3TensorRecording &) = delete;
+
+    uint64_t size() const { return m_count; }
+    const InceptionV3TensorFileHeader &header() const { return *m_header; }
+    const InceptionV3TensorRecord &record(uint64_t index) const;
+    uint8_t *tensor(uint64_t index) const;
+
+private:
+    size_t m_size;
+    uint8_t *m_base;
+    const InceptionV3TensorFileHeader *m_header;
+    uint64_t m_count;
+};
+
+// Feeds a recording back into InceptionV3Pipeline, keeping each frame's stream id
+// and seq. Paced replay sleeps to reproduce the recorded inter-frame gaps and is
+// live (the pipeline drops frames it cannot keep up with, as in the recorded
+// run); its clock starts at the first next(), not at construction. Otherwise
+// frames go out as fast as the pipeline takes them. A looping replay starts over
+// at the end, with seqs continuing to increase.
+class InceptionV3ReplaySource : public InceptionV3FrameSource
+{
+public:
+    InceptionV3ReplaySource(const InceptionV3TensorRecording &recording, bool paced, bool loop = false);
+
+    bool next(InceptionV3Frame &frame) override;
+    bool live() const override { return m_paced; }
+
+private:
+    const InceptionV3TensorRecording &m_recording;
+    bool m_paced;
+    bool m_loop;
+    uint64_t m_index;
+    uint64_t m_lap;
+    bool m_started;
+    std::chrono::steady_clock::time_point m_start;
+};
@@ -0,0 +1,46 @@
+#pragma once
+#include "inception_v3_kernels.hpp"
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <string>
+
+// Shared by the *_test.cpp self-checks run through ctest: failed checks are
+// reported on stderr and counted, and main() returns inception_v3_test_result().
+
+inline int &inception_v3_test_failures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+inline void inception_v3_check(bool ok, const std::string &context, const char *what, size_t case_index)
+{
+    if (!ok) {
+        std::cerr << context << ' ' << what << " fails in case " << case_index << std::endl;
+        inception_v3_test_failures()++;
+    }
+}
+
+inline int inception_v3_test_result()
+{
+    return inception_v3_test_failures() == 0 ? 0 : 1;
+}
+
+// Calls body(isa, rng) once per instruction set this CPU runs, with that ISA's
+// kernels active and the rng seeded the same each time, so every ISA sees the
+// same inputs. Prints one line per ISA.
+template <typename Body>
+void inception_v3_for_each_isa(Body body, bool include_scalar = true)
+{
+    for (const auto &isa : inception_v3_isas()) {
+        if (!include_scalar && isa == "scalar") {
+            continue;
+        }
+        inception_v3_use_isa(isa);
+        std::mt19937 rng(2024);
+        const int failures = inception_v3_test_failures();
+        body(isa, rng);
+        std::cout << isa << ": " << (inception_v3_test_failures() == failures ? "ok" : "FAILED") << std::endl;
+    }
+}
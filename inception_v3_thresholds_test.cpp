@@ -0,0 +1,96 @@
+#include "inception_v3_hailortpp.hpp"
+#include "inception_v3_test.hpp"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// Per-class thresholds, allow-lists and top-k against plain float references,
+// under every ISA this CPU supports. The allow-list sizes cover both the sparse
+// bit scan and the dense kernel in best_eligible_class_inception_v3().
+
+namespace
+{
+// The unfiltered postprocess rule applied class by class.
+int reference_best(const std::vector<uint8_t> &scores, const std::vector<float> &thresholds,
+                   const std::vector<bool> &allowed, float default_threshold)
+{
+    int best = -1;
+    for (size_t i = 0; i < scores.size(); i++) {
+        const float threshold = thresholds[i] >= 0.0f ? thresholds[i] : default_threshold;
+        if (!allowed[i] || scores[i] / 255.0f < threshold) {
+            continue;
+        }
+        if (best < 0 || scores[i] > scores[best]) {
+            best = static_cast<int>(i);
+        }
+    }
+    return best;
+}
+
+// Stable sort by score: best first, lower id first on ties.
+std::vector<int> reference_top_k(const std::vector<uint8_t> &scores, size_t k)
+{
+    std::vector<int> ids(scores.size());
+    for (size_t i = 0; i < ids.size(); i++) {
+        ids[i] = static_cast<int>(i);
+    }
+    std::stable_sort(ids.begin(), ids.end(), [&](int a, int b) { return scores[a] > scores[b]; });
+    ids.resize(std::min(k, ids.size()));
+    return ids;
+}
+
+void compare(const std::string &isa, std::mt19937 &rng)
+{
+    const size_t class_counts[] = {1, 10, 63, 64, 65, 1000, 1001};
+
+    for (size_t c = 0; c < 1000; c++) {
+        const size_t class_count = class_counts[c % 7];
+        InceptionV3Params params("", 0.3f + (c % 5) * 0.1f);
+
+        // Every third case starts from an empty allow-list and opens a few
+        // classes (sparse scan); the rest allow everything but a few (dense).
+        std::vector<bool> allowed(class_count, c % 3 != 0);
+        std::vector<float> thresholds(class_count, -1.0f);
+        if (c % 3 == 0) {
+            const size_t opened = c % 2 ? 20 : 300;
+            for (size_t i = 0; i < opened; i++) {
+                allowed[rng() % class_count] = true;
+            }
+        }
+        for (size_t i = 0; i < 30; i++) {
+            thresholds[rng() % class_count] = (rng() % 101) / 100.0f;
+        }
+        for (size_t i = 0; i < 10; i++) {
+            allowed[rng() % class_count] = false;
+        }
+        compile_inception_v3_filters(params, class_count, thresholds, allowed);
+
+        const uint32_t range = c % 4 == 0 ? 8 : 256;
+        std::vector<uint8_t> scores(class_count);
+        for (auto &score : scores) {
+            score = static_cast<uint8_t>(c % 4 == 0 ? 255 - rng() % range : rng() % range);
+        }
+
+        inception_v3_check(best_eligible_class_inception_v3(scores.data(), class_count, params) ==
+                               reference_best(scores, thresholds, allowed, params.confidence_threshold),
+                           isa, "best_eligible_class_inception_v3", c);
+
+        const size_t k = c % (INCEPTION_V3_TOP_K + 2);
+        int ids[INCEPTION_V3_TOP_K + 1] = {};
+        float confidences[INCEPTION_V3_TOP_K + 1] = {};
+        const size_t filled = top_k_inception_v3(scores.data(), class_count, k, ids, confidences);
+        const std::vector<int> expected = reference_top_k(scores, k);
+        bool same = filled == expected.size();
+        for (size_t i = 0; same && i < filled; i++) {
+            same = ids[i] == expected[i] && confidences[i] == scores[expected[i]] / 255.0f;
+        }
+        inception_v3_check(same, isa, "top_k_inception_v3", c);
+    }
+}
+} // namespace
+
+int main()
+{
+    inception_v3_for_each_isa(compare);
+    return inception_v3_test_result();
+}
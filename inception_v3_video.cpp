@@ -0,0 +1,136 @@
+#include "inception_v3_cpu_backend.hpp"
+#include "inception_v3_pipeline.hpp"
+#include "inception_v3_video_source.hpp"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+
+// Classifies recorded video files through the native pipeline, decoding only
+// the frames --sample asks for (see InceptionV3VideoFileSource). Each file is a
+// stream with its own decode thread, so several files decode in parallel and
+// share the device's batches. Results are CSV on stdout, one row per classified
+// frame in completion order, keyed by the file and the frame's media time:
+//   file,time_s,valid,class_id,label,confidence
+
+namespace
+{
+void print_usage(const char *program)
+{
+    std::cerr << "Usage: " << program << " (--hef <hef_path> | --simulate | --cpu <weights.iv3w>[,threads])" << std::endl
+              << "       [--sample all|keyframes|every=<N>] [--batch 8] [--threads 2] [--decode-threads 0]" << std::endl
+              << "       <video>..." << std::endl;
+}
+
+void parse_weights(const std::string &text, std::string &path, size_t &threads)
+{
+    size_t comma = text.rfind(',');
+    if (comma != std::string::npos && comma + 1 < text.size() &&
+        text.find_first_not_of("0123456789", comma + 1) == std::string::npos) {
+        path = text.substr(0, comma);
+        threads = std::stoul(text.substr(comma + 1));
+    } else {
+        path = text;
+        threads = 0;
+    }
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::string hef_path;
+    std::string cpu_weights;
+    size_t cpu_threads = 0;
+    bool simulate = false;
+    InceptionV3VideoSampling sampling;
+    int decode_threads = 0;
+    InceptionV3PipelineConfig config;
+    config.batch_size = 8;
+    std::vector<std::string> videos;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            bool has_value = i + 1 < argc;
+            if (arg == "--hef" && has_value) {
+                hef_path = argv[++i];
+            } else if (arg == "--cpu" && has_value) {
+                parse_weights(argv[++i], cpu_weights, cpu_threads);
+            } else if (arg == "--simulate") {
+                simulate = true;
+            } else if (arg == "--sample" && has_value) {
+                sampling = InceptionV3VideoSampling::parse(argv[++i]);
+            } else if (arg == "--batch" && has_value) {
+                config.batch_size = std::max<size_t>(std::stoul(argv[++i]), 1);
+            } else if (arg == "--threads" && has_value) {
+                config.preprocess_threads = std::max<size_t>(std::stoul(argv[++i]), 1);
+            } else if (arg == "--decode-threads" && has_value) {
+                decode_threads = std::stoi(argv[++i]);
+            } else if (arg.compare(0, 2, "--") == 0) {
+                print_usage(argv[0]);
+                return 1;
+            } else {
+                videos.push_back(arg);
+            }
+        }
+
+        if (videos.empty() || (hef_path.empty() && cpu_weights.empty() && !simulate)) {
+            print_usage(argv[0]);
+            return 1;
+        }
+
+        auto params = init_inception_v3("./imagenet_classes.txt", 0.5f);
+        std::unique_ptr<InceptionV3Backend> backend;
+        if (simulate) {
+            backend.reset(new InceptionV3SimulatedBackend());
+        } else if (!cpu_weights.empty()) {
+            backend.reset(new InceptionV3CpuBackend(cpu_weights, cpu_threads));
+        } else {
+            backend.reset(new InceptionV3HailoBackend(hef_path));
+        }
+        InceptionV3Runner runner(std::move(backend), params);
+
+        std::mutex output_mutex;
+        std::cout << "file,time_s,valid,class_id,label,confidence\n" << std::fixed;
+        InceptionV3Pipeline pipeline(runner, config, [&](const InceptionV3PipelineResult &result) {
+            const auto &top = result.result;
+            std::lock_guard<std::mutex> lock(output_mutex);
+            std::cout << videos[result.stream_id] << ',' << std::setprecision(3) << result.pts_ns / 1e9 << ','
+                      << (top.valid ? 1 : 0) << ',' << (top.top_k_count > 0 ? top.top_k_ids[0] : -1) << ",\""
+                      << top.label << "\"," << std::setprecision(4)
+                      << (top.top_k_count > 0 ? top.top_k_confidences[0] : 0.0f) << '\n';
+        });
+
+        std::vector<InceptionV3VideoFileSource *> sources;
+        for (size_t i = 0; i < videos.size(); i++) {
+            sources.push_back(new InceptionV3VideoFileSource(videos[i], static_cast<uint32_t>(i), sampling,
+                                                             decode_threads));
+            pipeline.add_source(std::unique_ptr<InceptionV3FrameSource>(sources.back()));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        pipeline.run();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout.flush();
+
+        uint64_t emitted = 0;
+        for (size_t i = 0; i < sources.size(); i++) {
+            auto stats = sources[i]->stats();
+            emitted += stats.emitted;
+            std::cerr << videos[i] << ": " << sources[i]->width() << "x" << sources[i]->height() << " @ "
+                      << std::setprecision(2) << sources[i]->frame_rate() << " fps, " << stats.packets
+                      << " packets, " << stats.decoded << " decoded, " << stats.emitted << " classified, "
+                      << stats.seeks << " seeks" << std::endl;
+        }
+        std::cerr << emitted << " frames in " << std::setprecision(1) << seconds << " s ("
+                  << (seconds > 0.0 ? emitted / seconds : 0.0) << " frames/s)" << std::endl;
+
+        free_resources(params);
+
+    } catch (const std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
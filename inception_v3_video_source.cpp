@@ -0,0 +1,299 @@
+#include "inception_v3_video_source.hpp"
+#include <algorithm>
+#include <cmath>
+#include <new>
+#include <stdexcept>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+
+namespace
+{
+const AVRational NANOSECONDS = {1, 1000000000};
+
+std::runtime_error av_error(const std::string &what, int code)
+{
+    char message[AV_ERROR_MAX_STRING_SIZE] = {};
+    av_strerror(code, message, sizeof(message));
+    return std::runtime_error(what + ": " + message);
+}
+
+int64_t stream_start(const AVStream *stream)
+{
+    return stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+}
+}
+
+InceptionV3VideoSampling InceptionV3VideoSampling::parse(const std::string &spec)
+{
+    InceptionV3VideoSampling sampling;
+    if (spec == "all") {
+        return sampling;
+    }
+    if (spec == "keyframes") {
+        sampling.mode = KEYFRAMES;
+        return sampling;
+    }
+    if (spec.compare(0, 6, "every=") == 0) {
+        unsigned long stride = std::stoul(spec.substr(6));
+        if (stride == 0) {
+            throw std::invalid_argument("video stride must be at least 1");
+        }
+        sampling.mode = stride == 1 ? ALL : STRIDE;
+        sampling.stride = static_cast<uint32_t>(stride);
+        return sampling;
+    }
+    throw std::invalid_argument("unknown video sampling " + spec + " (all, keyframes or every=<N>)");
+}
+
+InceptionV3VideoFileSource::InceptionV3VideoFileSource(const std::string &path, uint32_t stream_id,
+                                                       const InceptionV3VideoSampling &sampling, int decode_threads)
+    : m_path(path), m_stream_id(stream_id), m_sampling(sampling), m_format(nullptr), m_codec(nullptr),
+      m_frame(nullptr), m_packet(nullptr), m_sws(nullptr), m_stream_index(-1), m_frame_rate(0.0),
+      m_interval_ns(0), m_next_sample_ns(0), m_last_key_pts(AV_NOPTS_VALUE), m_gop_ns(0), m_seekable(false),
+      m_draining(false)
+{
+    int ret = avformat_open_input(&m_format, path.c_str(), nullptr, nullptr);
+    if (ret < 0) {
+        throw av_error("open " + path, ret);
+    }
+
+    try {
+        ret = avformat_find_stream_info(m_format, nullptr);
+        if (ret < 0) {
+            throw av_error("probe " + path, ret);
+        }
+        m_stream_index = av_find_best_stream(m_format, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+        if (m_stream_index < 0) {
+            throw std::runtime_error(path + " has no video stream");
+        }
+        AVStream *stream = m_format->streams[m_stream_index];
+        const AVCodec *decoder = avcodec_find_decoder(stream->codecpar->codec_id);
+        if (decoder == nullptr) {
+            throw std::runtime_error(path + ": no decoder for " + avcodec_get_name(stream->codecpar->codec_id));
+        }
+
+        AVRational rate = stream->avg_frame_rate.num > 0 ? stream->avg_frame_rate : stream->r_frame_rate;
+        m_frame_rate = rate.num > 0 && rate.den > 0 ? av_q2d(rate) : 0.0;
+        m_seekable = m_format->pb != nullptr && (m_format->pb->seekable & AVIO_SEEKABLE_NORMAL);
+
+        m_codec = avcodec_alloc_context3(decoder);
+        if (m_codec == nullptr) {
+            throw std::bad_alloc();
+        }
+        ret = avcodec_parameters_to_context(m_codec, stream->codecpar);
+        if (ret < 0) {
+            throw av_error("codec parameters of " + path, ret);
+        }
+        m_codec->thread_count = decode_threads;
+        m_codec->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
+        if (m_sampling.mode == InceptionV3VideoSampling::KEYFRAMES) {
+            m_codec->skip_frame = AVDISCARD_NONKEY;
+        } else if (m_sampling.mode == InceptionV3VideoSampling::STRIDE && m_frame_rate > 0.0) {
+            // Samples are picked by media time, so frames the decoder discards
+            // cannot shift which ones are taken. Without a frame rate, samples are
+            // counted in decoded frames and nothing may be discarded.
+            m_interval_ns = static_cast<uint64_t>(std::llround(m_sampling.stride * 1e9 / m_frame_rate));
+            m_codec->skip_frame = AVDISCARD_NONREF;
+        }
+
+        ret = avcodec_open2(m_codec, decoder, nullptr);
+        if (ret < 0) {
+            throw av_error("open decoder for " + path, ret);
+        }
+        m_frame = av_frame_alloc();
+        m_packet = av_packet_alloc();
+        if (m_frame == nullptr || m_packet == nullptr) {
+            throw std::bad_alloc();
+        }
+    } catch (...) {
+        close();
+        throw;
+    }
+}
+
+InceptionV3VideoFileSource::~InceptionV3VideoFileSource()
+{
+    close();
+}
+
+void InceptionV3VideoFileSource::close()
+{
+    sws_freeContext(m_sws);
+    m_sws = nullptr;
+    av_packet_free(&m_packet);
+    av_frame_free(&m_frame);
+    avcodec_free_context(&m_codec);
+    avformat_close_input(&m_format);
+}
+
+uint32_t InceptionV3VideoFileSource::width() const
+{
+    return static_cast<uint32_t>(m_codec->width);
+}
+
+uint32_t InceptionV3VideoFileSource::height() const
+{
+    return static_cast<uint32_t>(m_codec->height);
+}
+
+bool InceptionV3VideoFileSource::next(InceptionV3Frame &frame)
+{
+    for (;;) {
+        int ret = avcodec_receive_frame(m_codec, m_frame);
+        if (ret == 0) {
+            m_stats.decoded++;
+            const uint64_t pts_ns = frame_pts_ns();
+            const bool take = wanted(pts_ns);
+            if (take) {
+                emit(frame, pts_ns);
+            }
+            av_frame_unref(m_frame);
+            if (take) {
+                skip_to_next_sample(pts_ns);
+                return true;
+            }
+            continue;
+        }
+        if (ret == AVERROR_EOF) {
+            return false;
+        }
+        if (ret != AVERROR(EAGAIN)) {
+            throw av_error("decode " + m_path, ret);
+        }
+        if (m_draining) {
+            return false;
+        }
+        read_packet();
+    }
+}
+
+// Feeds the decoder one video packet, or the end-of-stream flush.
+void InceptionV3VideoFileSource::read_packet()
+{
+    const AVStream *stream = m_format->streams[m_stream_index];
+    for (;;) {
+        int ret = av_read_frame(m_format, m_packet);
+        if (ret == AVERROR_EOF) {
+            avcodec_send_packet(m_codec, nullptr);
+            m_draining = true;
+            return;
+        }
+        if (ret < 0) {
+            throw av_error("read " + m_path, ret);
+        }
+        if (m_packet->stream_index != m_stream_index) {
+            av_packet_unref(m_packet);
+            continue;
+        }
+
+        m_stats.packets++;
+        const bool key = (m_packet->flags & AV_PKT_FLAG_KEY) != 0;
+        if (key) {
+            int64_t pts = m_packet->pts != AV_NOPTS_VALUE ? m_packet->pts : m_packet->dts;
+            if (pts != AV_NOPTS_VALUE && m_last_key_pts != AV_NOPTS_VALUE && pts > m_last_key_pts) {
+                m_gop_ns = std::max<uint64_t>(m_gop_ns, av_rescale_q(pts - m_last_key_pts, stream->time_base,
+                                                                     NANOSECONDS));
+            }
+            m_last_key_pts = pts;
+        }
+        if (m_sampling.mode == InceptionV3VideoSampling::KEYFRAMES && !key) {
+            av_packet_unref(m_packet);
+            continue;
+        }
+
+        ret = avcodec_send_packet(m_codec, m_packet);
+        av_packet_unref(m_packet);
+        // A damaged packet costs its frame(s), not the rest of the file.
+        if (ret < 0 && ret != AVERROR_INVALIDDATA) {
+            throw av_error("decode " + m_path, ret);
+        }
+        return;
+    }
+}
+
+uint64_t InceptionV3VideoFileSource::frame_pts_ns() const
+{
+    const AVStream *stream = m_format->streams[m_stream_index];
+    const int64_t pts = m_frame->best_effort_timestamp;
+    if (pts == AV_NOPTS_VALUE) {
+        return m_frame_rate > 0.0 ? static_cast<uint64_t>((m_stats.decoded - 1) * 1e9 / m_frame_rate) : 0;
+    }
+    const int64_t start = stream_start(stream);
+    return pts > start ? static_cast<uint64_t>(av_rescale_q(pts - start, stream->time_base, NANOSECONDS)) : 0;
+}
+
+bool InceptionV3VideoFileSource::wanted(uint64_t pts_ns)
+{
+    if (m_sampling.mode != InceptionV3VideoSampling::STRIDE) {
+        return true;
+    }
+    if (m_interval_ns == 0) {
+        return (m_stats.decoded - 1) % m_sampling.stride == 0;
+    }
+
+    // Half a frame of slack, so timestamp jitter does not push a sample onto the following frame.
+    const uint64_t slack = static_cast<uint64_t>(5e8 / m_frame_rate);
+    if (pts_ns + slack < m_next_sample_ns) {
+        return false;
+    }
+    m_next_sample_ns = ((pts_ns + slack) / m_interval_ns + 1) * m_interval_ns;
+    return true;
+}
+
+// Stride longer than a GOP: jump to the keyframe before the next sample instead
+// of decoding the GOPs in between. A seek that lands short only costs decode
+// time, since frames before the sample are still not taken.
+void InceptionV3VideoFileSource::skip_to_next_sample(uint64_t pts_ns)
+{
+    if (m_interval_ns == 0 || !m_seekable || m_gop_ns == 0 || m_next_sample_ns <= pts_ns + m_gop_ns) {
+        return;
+    }
+
+    const AVStream *stream = m_format->streams[m_stream_index];
+    const int64_t target = av_rescale_q(static_cast<int64_t>(m_next_sample_ns), NANOSECONDS, stream->time_base) +
+                           stream_start(stream);
+    if (av_seek_frame(m_format, m_stream_index, target, AVSEEK_FLAG_BACKWARD) < 0) {
+        m_seekable = false;
+        return;
+    }
+    avcodec_flush_buffers(m_codec);
+    m_last_key_pts = AV_NOPTS_VALUE;
+    m_stats.seeks++;
+}
+
+void InceptionV3VideoFileSource::emit(InceptionV3Frame &frame, uint64_t pts_ns)
+{
+    const int width = m_frame->width;
+    const int height = m_frame->height;
+    const bool nv12 = width % 2 == 0 && height % 2 == 0;
+    const InceptionV3PixelFormat format = nv12 ? INCEPTION_V3_FORMAT_NV12 : INCEPTION_V3_FORMAT_RGB;
+
+    // Same size, so swscale takes its unscaled path (a plane copy and chroma
+    // interleave for the usual yuv420p).
+    m_sws = sws_getCachedContext(m_sws, width, height, static_cast<AVPixelFormat>(m_frame->format), width, height,
+                                 nv12 ? AV_PIX_FMT_NV12 : AV_PIX_FMT_RGB24, SWS_POINT, nullptr, nullptr, nullptr);
+    if (m_sws == nullptr) {
+        const char *name = av_get_pix_fmt_name(static_cast<AVPixelFormat>(m_frame->format));
+        throw std::runtime_error(m_path + ": cannot convert " + (name ? name : "unknown") + " frames");
+    }
+
+    frame.data.resize(inception_v3_frame_bytes(format, width, height));
+    uint8_t *planes[4] = {frame.data.data(), nv12 ? frame.data.data() + static_cast<size_t>(width) * height : nullptr,
+                          nullptr, nullptr};
+    int strides[4] = {nv12 ? width : width * 3, nv12 ? width : 0, 0, 0};
+    sws_scale(m_sws, m_frame->data, m_frame->linesize, 0, height, planes, strides);
+
+    frame.stream_id = m_stream_id;
+    frame.seq = m_stats.emitted++;
+    frame.capture_time_ns = inception_v3_now_ns();
+    frame.pts_ns = pts_ns;
+    frame.width = static_cast<uint32_t>(width);
+    frame.height = static_cast<uint32_t>(height);
+    frame.format = format;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include "inception_v3_source.hpp"
+#include <cstdint>
+#include <string>
+
+struct AVFormatContext;
+struct AVCodecContext;
+struct AVFrame;
+struct AVPacket;
+struct SwsContext;
+
+// Which frames of a video file are classified.
+struct InceptionV3VideoSampling
+{
+    enum Mode
+    {
+        ALL,
+        KEYFRAMES,  // I-frames only; other packets never reach the decoder
+        STRIDE,     // one frame per `stride` frame intervals of media time
+    };
+    Mode mode = ALL;
+    uint32_t stride = 1;
+
+    // "all", "keyframes" or "every=<N>".
+    static InceptionV3VideoSampling parse(const std::string &spec);
+};
+
+struct InceptionV3VideoStats
+{
+    uint64_t packets = 0;       // video packets demuxed
+    uint64_t decoded = 0;       // frames the decoder reconstructed
+    uint64_t emitted = 0;       // frames handed to the pipeline
+    uint64_t seeks = 0;         // GOPs jumped over in stride mode
+};
+
+// Offline video file (anything libavformat opens) as a frame source, decoding as
+// little as the sampling mode allows:
+//   keyframes  drops non-key packets before the decoder and sets AVDISCARD_NONKEY.
+//   every=N    sets AVDISCARD_NONREF, so non-reference frames (B-frames in most
+//              encodes) are parsed but never reconstructed, and takes the first
+//              decoded frame at or after each sample time. When samples are
+//              further apart than a GOP it seeks to the keyframe before the next
+//              sample instead of decoding the GOPs in between. I/P-only streams
+//              still decode every frame within the GOPs that hold a sample.
+// Frames go out at the decoded resolution as NV12 (RGB for odd sizes), so the
+// pipeline's preprocess workers do the fused colour conversion and resize, with
+// pts_ns set to the frame's media time from the start of the stream. Not live:
+// the pipeline holds the decoder back rather than dropping frames.
+class InceptionV3VideoFileSource : public InceptionV3FrameSource
+{
+public:
+    InceptionV3VideoFileSource(const std::string &path, uint32_t stream_id, const InceptionV3VideoSampling &sampling,
+                               int decode_threads = 0);
+    ~InceptionV3VideoFileSource();
+
+    InceptionV3VideoFileSource(const InceptionV3VideoFileSource &) = delete;
+    InceptionV3VideoFileSource &operator=(const InceptionV3VideoFileSource &) = delete;
+
+    bool next(InceptionV3Frame &frame) override;
+
+    uint32_t width() const;
+    uint32_t height() const;
+    double frame_rate() const { return m_frame_rate; }
+    InceptionV3VideoStats stats() const { return m_stats; }
+
+private:
+    void close();
+    void read_packet();
+    bool wanted(uint64_t pts_ns);
+    void skip_to_next_sample(uint64_t pts_ns);
+    uint64_t frame_pts_ns() const;
+    void emit(InceptionV3Frame &frame, uint64_t pts_ns);
+
+    std::string m_path;
+    uint32_t m_stream_id;
+    InceptionV3VideoSampling m_sampling;
+    AVFormatContext *m_format;
+    AVCodecContext *m_codec;
+    AVFrame *m_frame;
+    AVPacket *m_packet;
+    SwsContext *m_sws;
+    int m_stream_index;
+    double m_frame_rate;        // 0 when the container does not say
+    uint64_t m_interval_ns;     // stride mode: media time between samples
+    uint64_t m_next_sample_ns;
+    int64_t m_last_key_pts;     // stream time base, for the GOP length
+    uint64_t m_gop_ns;
+    bool m_seekable;
+    bool m_draining;
+    InceptionV3VideoStats m_stats;
+};
@@ -1,64 +1,423 @@
 #include "hailo/hailort.hpp"
 #include "hailo_common.hpp"
 #include "inception_v3_hailortpp.hpp"
+#include "inception_v3_runner.hpp"
+#include "inception_v3_daemon.hpp"
+#include "inception_v3_shm_ring.hpp"
+#include "inception_v3_result_board.hpp"
+#include "inception_v3_source.hpp"
+#include "inception_v3_jpeg.hpp"
+#include "inception_v3_result_log.hpp"
+#include "inception_v3_config.hpp"
+#include "inception_v3_temporal.hpp"
+#include "inception_v3_tensor_file.hpp"
+#include "inception_v3_perf.hpp"
+#include "inception_v3_cascade.hpp"
+#include <atomic>
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <pthread.h>
+#include <thread>
+#include <time.h>
 
-int main(int argc, char *argv[])
+static void print_usage(const char *program)
 {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <hef_path>" << std::endl;
-        return 1;
+    std::cerr << "Usage: " << program << " <hef_path> [image.jpg...]" << std::endl
+              << "       " << program << " --daemon <socket_path> <hef_path> [max_batch]" << std::endl
+              << "       " << program << " --client <socket_path> <input_tensor_file>..." << std::endl
+              << "       " << program << " --shm-ring <ring_name> <hef_path> [slots] [max_batch] [log_dir]" << std::endl
+              << "Services reload threshold and labels on change when INCEPTION_V3_CONFIG names a config file" << std::endl
+              << "written by makeconfig.py. With INCEPTION_V3_SMOOTHING=\"ema=0.25;enter=0.6;exit=0.4\"" << std::endl
+              << "(or window=<frames>) the shm-ring log only records changes of the smoothed top-1." << std::endl
+              << "INCEPTION_V3_RECORD=<file>[:<max_frames>] records the shm-ring input tensors for" << std::endl
+              << "inception_v3_bench --replay. INCEPTION_V3_PERF=1 prints the per-frame CPU cost of" << std::endl
+              << "every stage (CPU time and hardware counters) when a service shuts down." << std::endl
+              << "INCEPTION_V3_CASCADE=<small.iv3w[,threads] | simulate> runs that cheap" << std::endl
+              << "classifier on every frame and the HEF only on frames it is unsure of; tune it with" << std::endl
+              << "INCEPTION_V3_CASCADE_CONFIG=\"threshold=0.6;classes=0-397\" (classes always escalated)." << std::endl;
+}
+
+static void print_result(const InceptionV3Result &result)
+{
+    if (result.valid) {
+        std::cout << "Label: " << result.label
+                  << ", Confidence: " << result.confidence << '\n';
     }
+}
 
-    std::string hef_path = argv[1];
+static std::vector<uint8_t> read_file(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
 
-    try {
-        auto params = init_inception_v3("./imagenet_classes.txt", 0.5f);
+// The HEF's backend, behind a cheap first stage when INCEPTION_V3_CASCADE is set.
+static std::unique_ptr<InceptionV3Backend> make_backend(const std::string &hef_path)
+{
+    std::unique_ptr<InceptionV3Backend> backend(new InceptionV3HailoBackend(hef_path));
+    const char *first_stage = std::getenv("INCEPTION_V3_CASCADE");
+    if (!first_stage || !*first_stage) {
+        return backend;
+    }
+    const char *spec = std::getenv("INCEPTION_V3_CASCADE_CONFIG");
+    auto config = InceptionV3CascadeConfig::parse(spec ? spec : "");
+    std::cerr << "Cascade: " << first_stage << " first, " << hef_path << " below " << config.escalate_below
+              << " confidence" << std::endl;
+    return std::unique_ptr<InceptionV3Backend>(new InceptionV3CascadeBackend(
+        make_inception_v3_cascade_stage(first_stage), std::move(backend), config));
+}
+
+// Long-running modes pick up config edits without a restart when INCEPTION_V3_CONFIG is set.
+static std::unique_ptr<InceptionV3ParamsWatcher> watch_config(InceptionV3Runner &runner)
+{
+    const char *config_path = std::getenv("INCEPTION_V3_CONFIG");
+    if (!config_path || !*config_path) {
+        return nullptr;
+    }
+    std::unique_ptr<InceptionV3ParamsWatcher> watcher(new InceptionV3ParamsWatcher(config_path));
+    runner.set_params_watcher(watcher.get());
+    std::cerr << "Watching " << config_path << " for threshold and label changes" << std::endl;
+    return watcher;
+}
+
+// Records the tensors sent to the device when INCEPTION_V3_RECORD is set (default 3000 frames).
+static std::unique_ptr<InceptionV3TensorRecorder> record_inputs(InceptionV3Runner &runner)
+{
+    const char *spec = std::getenv("INCEPTION_V3_RECORD");
+    if (!spec || !*spec) {
+        return nullptr;
+    }
+    std::string path = spec;
+    uint64_t capacity = 3000;
+    size_t colon = path.rfind(':');
+    if (colon != std::string::npos && colon + 1 < path.size() &&
+        path.find_first_not_of("0123456789", colon + 1) == std::string::npos) {
+        capacity = std::stoull(path.substr(colon + 1));
+        path.resize(colon);
+    }
+    std::unique_ptr<InceptionV3TensorRecorder> recorder(new InceptionV3TensorRecorder(
+        path, runner.backend().input_info(), runner.input_frame_size(), capacity));
+    std::cerr << "Recording up to " << capacity << " input tensors to " << path << std::endl;
+    return recorder;
+}
+
+// Per-stage cost accounting for the lifetime of a service when INCEPTION_V3_PERF is set.
+static bool account_stage_costs()
+{
+    const char *perf = std::getenv("INCEPTION_V3_PERF");
+    if (!perf || !*perf || std::strcmp(perf, "0") == 0) {
+        return false;
+    }
+    inception_v3_perf_enable();
+    return true;
+}
+
+static void report_stage_costs(bool accounting)
+{
+    if (accounting) {
+        inception_v3_perf_disable();
+        std::cerr << inception_v3_perf_report();
+    }
+}
+
+// Blocks termination signals in every thread so they can be taken synchronously
+// with sigwait, keeping shutdown out of signal-handler context.
+static sigset_t block_termination_signals()
+{
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    return signals;
+}
+
+// Joins a thread parked in sigwait(). The thread is woken with SIGTERM first, so
+// an exception while serving unwinds through here instead of std::terminate.
+struct SignalThreadJoin
+{
+    std::thread &thread;
+    ~SignalThreadJoin()
+    {
+        pthread_kill(thread.native_handle(), SIGTERM);
+        thread.join();
+    }
+};
+
+static int run_daemon(const std::string &socket_path, const std::string &hef_path, size_t max_batch)
+{
+    sigset_t signals = block_termination_signals();
+
+    auto params = init_inception_v3("./imagenet_classes.txt", 0.5f);
+    InceptionV3Runner runner(make_backend(hef_path), params);
+    auto config_watcher = watch_config(runner);
+    InceptionV3Daemon daemon(runner, socket_path, max_batch);
+    bool accounting = account_stage_costs();
+
+    std::thread signal_thread([&]() {
+        int signal_number = 0;
+        sigwait(&signals, &signal_number);
+        daemon.stop();
+    });
+    {
+        SignalThreadJoin signal_thread_join{signal_thread};
+        std::cerr << "Serving " << hef_path << " on " << socket_path << std::endl;
+        daemon.run();
+    }
+    report_stage_costs(accounting);
+
+    free_resources(params);
+    return 0;
+}
+
+static void publish_result(InceptionV3ResultBoards &boards, const InceptionV3ShmSlot &slot,
+                           const InceptionV3Result &result)
+{
+    InceptionV3BoardPayload payload = {};
+    payload.frame_seq = slot.seq;
+    payload.capture_time_ns = slot.submit_time_ns;
+    payload.stream_id = slot.stream_id;
+    payload.top_k_count = static_cast<uint32_t>(std::min(result.top_k_count, INCEPTION_V3_BOARD_TOP_K));
+    for (size_t k = 0; k < payload.top_k_count; k++) {
+        payload.class_ids[k] = result.top_k_ids[k];
+        payload.confidences[k] = result.top_k_confidences[k];
+    }
+    if (result.valid) {
+        std::strncpy(payload.top_label, result.label.c_str(), sizeof(payload.top_label) - 1);
+    }
+    payload.publish_time_ns = inception_v3_now_ns();
+    boards.publish(slot.stream_id, payload);
+}
+
+static InceptionV3LogRecord make_log_record(const InceptionV3ShmSlot &slot, const InceptionV3Result &result)
+{
+    // Slots carry CLOCK_MONOTONIC; the log wants wall-clock capture time.
+    timespec realtime;
+    clock_gettime(CLOCK_REALTIME, &realtime);
+    uint64_t now_ns = inception_v3_now_ns();
+    uint64_t age_ns = now_ns - slot.submit_time_ns;
+
+    InceptionV3LogRecord record = {};
+    record.timestamp_ns = static_cast<uint64_t>(realtime.tv_sec) * 1000000000ull + realtime.tv_nsec - age_ns;
+    record.frame_seq = slot.seq;
+    record.stream_id = slot.stream_id;
+    record.latency_us = static_cast<uint32_t>(age_ns / 1000);
+    record.top_k_count = static_cast<uint16_t>(std::min(result.top_k_count, INCEPTION_V3_LOG_TOP_K));
+    record.flags = result.valid ? INCEPTION_V3_LOG_VALID : 0;
+    for (size_t k = 0; k < record.top_k_count; k++) {
+        record.class_ids[k] = static_cast<uint16_t>(result.top_k_ids[k]);
+        record.confidences[k] = result.top_k_confidences[k];
+    }
+    return record;
+}
+
+static InceptionV3LogRecord make_event_record(const InceptionV3ShmSlot &slot, const InceptionV3TemporalEvent &event)
+{
+    InceptionV3Result smoothed;
+    smoothed.valid = event.kind == INCEPTION_V3_EVENT_CHANGED;
+    smoothed.top_k_count = 1;
+    smoothed.top_k_ids[0] = event.class_id;
+    smoothed.top_k_confidences[0] = event.confidence;
+
+    InceptionV3LogRecord record = make_log_record(slot, smoothed);
+    record.flags |= INCEPTION_V3_LOG_EVENT;
+    return record;
+}
+
+static int run_shm_service(const std::string &ring_name, const std::string &hef_path, uint32_t slots,
+                           size_t max_batch, const std::string &log_dir)
+{
+    sigset_t signals = block_termination_signals();
+
+    auto params = init_inception_v3("./imagenet_classes.txt", 0.5f);
+    InceptionV3Runner runner(make_backend(hef_path), params);
+    auto config_watcher = watch_config(runner);
+    auto recorder = record_inputs(runner);
+    bool accounting = account_stage_costs();
+    const uint32_t frame_size = static_cast<uint32_t>(runner.input_frame_size());
+    InceptionV3ShmRing ring(ring_name, slots, frame_size);
+
+    std::atomic<bool> running(true);
+    std::thread signal_thread([&]() {
+        int signal_number = 0;
+        sigwait(&signals, &signal_number);
+        running = false;
+    });
+    SignalThreadJoin signal_thread_join{signal_thread};
+
+    std::cerr << "Serving " << hef_path << " on shm ring " << ring_name << " (" << slots << " x "
+              << frame_size << " bytes)" << std::endl;
+
+    std::unique_ptr<InceptionV3ResultLog> log;
+    if (!log_dir.empty()) {
+        log.reset(new InceptionV3ResultLog(log_dir));
+    }
+
+    // Change-only logging of the smoothed top-1 instead of one record per frame.
+    // Its per-stream state is capped and dropped when idle like the boards below.
+    std::unique_ptr<InceptionV3TemporalFilter> smoothing;
+    const char *smoothing_spec = std::getenv("INCEPTION_V3_SMOOTHING");
+    if (smoothing_spec && *smoothing_spec) {
+        smoothing.reset(new InceptionV3TemporalFilter(InceptionV3SmoothingConfig::parse(smoothing_spec),
+                                                      std::min<size_t>(runner.output_frame_size(), 1000)));
+    }
+    InceptionV3TemporalEvent event;
+
+    // One result board per stream id, created when the stream first shows up and
+    // removed once it goes idle, so clients cycling stream ids cannot grow it forever.
+    InceptionV3ResultBoards boards(ring_name);
+
+    std::vector<int> ready;
+    std::vector<int> batch_slots;
+    std::vector<uint8_t *> frames;
+    while (running) {
+        if (ring.take_ready(ready, max_batch, std::chrono::milliseconds(200)) == 0) {
+            if (log) {
+                log->flush();
+            }
+            continue;
+        }
+
+        // Slot memory goes to the input vstream as is; frames of the wrong size are
+        // failed instead of being sent to the device.
+        batch_slots.clear();
+        frames.clear();
+        for (int slot : ready) {
+            if (ring.slot(slot).frame_size != frame_size) {
+                ring.fail(slot, "frame is " + std::to_string(ring.slot(slot).frame_size) + " bytes, expected " +
+                                    std::to_string(frame_size));
+                continue;
+            }
+            batch_slots.push_back(slot);
+            frames.push_back(ring.slot_data(slot));
+            if (recorder) {
+                const auto &header = ring.slot(slot);
+                recorder->append(header.stream_id, header.seq, header.submit_time_ns, ring.slot_data(slot));
+            }
+        }
+
+        // Every slot taken is completed, even when inference fails, so that no
+        // producer is left waiting on a slot the service will never answer.
+        size_t completed = 0;
+        try {
+            auto results = runner.classify_batch(frames);
+            for (; completed < batch_slots.size(); completed++) {
+                const auto &slot = ring.slot(batch_slots[completed]);
+                const auto &result = results[completed];
+                publish_result(boards, slot, result);
+                if (smoothing) {
+                    if (smoothing->update(slot.stream_id, slot.seq, runner.last_output(completed), event) && log) {
+                        log->append(make_event_record(slot, event));
+                    }
+                } else if (log) {
+                    log->append(make_log_record(slot, result));
+                }
+                ring.complete(batch_slots[completed], result.valid, result.confidence, result.label);
+            }
+        } catch (const std::exception &e) {
+            std::cerr << "Batch of " << batch_slots.size() << " frames failed: " << e.what() << std::endl;
+            for (; completed < batch_slots.size(); completed++) {
+                ring.fail(batch_slots[completed], e.what());
+            }
+        }
+    }
+    report_stage_costs(accounting);
+
+    free_resources(params);
+    return 0;
+}
 
-        // Initialize Hailo device
-        auto device = hailort::Device::create();
-        
-        // Create VStreams
-        auto vstreams = hailort::VStreams::create(*device, hef_path);
+static int run_client(const std::string &socket_path, int count, char *paths[])
+{
+    InceptionV3DaemonClient client(socket_path);
+    for (int i = 0; i < count; i++) {
+        auto frame = read_file(paths[i]);
+        std::cout << paths[i] << ": ";
+        auto result = client.classify(frame.data(), frame.size());
+        if (!result.valid) {
+            std::cout << "below threshold\n";
+            continue;
+        }
+        print_result(result);
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
 
-        // Create input and output vstreams
-        auto input_vstream = vstreams->input_vstreams()[0];
-        auto output_vstream = vstreams->output_vstreams()[0];
+    std::string mode = argv[1];
 
-        // Allocate buffers for input and output
-        std::vector<uint8_t> input_data(input_vstream->get_frame_size());
-        std::vector<uint8_t> output_data(output_vstream->get_frame_size());
+    try {
+        if (mode == "--daemon") {
+            if (argc < 4) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            size_t max_batch = argc > 4 ? std::stoul(argv[4]) : 8;
+            return run_daemon(argv[2], argv[3], max_batch);
+        }
 
-        // TODO: Load your image data into input_data
+        if (mode == "--shm-ring") {
+            if (argc < 4) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            uint32_t slots = argc > 4 ? static_cast<uint32_t>(std::stoul(argv[4])) : 16;
+            size_t max_batch = argc > 5 ? std::stoul(argv[5]) : 8;
+            std::string log_dir = argc > 6 ? argv[6] : "";
+            return run_shm_service(argv[2], argv[3], slots, max_batch, log_dir);
+        }
 
-        // Create HailoROIPtr
-        auto roi = std::make_shared<HailoROI>(HailoBBox(0.0f, 0.0f, 1.0f, 1.0f));
+        if (mode == "--client") {
+            if (argc < 4) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            return run_client(argv[2], argc - 3, argv + 3);
+        }
 
-        // Add input tensor to ROI
-        auto input_tensor = std::make_shared<HailoTensor>(input_vstream->get_info(), input_data.data());
-        roi->add_tensor(input_tensor);
+        std::string hef_path = argv[1];
 
-        // Preprocess
-        preprocess_inception_v3(roi);
+        auto params = init_inception_v3("./imagenet_classes.txt", 0.5f);
 
-        // Run inference
-        input_vstream->write(input_data.data());
-        output_vstream->read(output_data.data());
+        // Initialize Hailo device and network
+        InceptionV3Runner runner(make_backend(hef_path), params);
+        auto input_info = runner.backend().input_info();
 
-        // Add output tensor to ROI
-        auto output_tensor = std::make_shared<HailoTensor>(output_vstream->get_info(), output_data.data());
-        roi->add_tensor(output_tensor);
+        // Allocate buffer for input
+        std::vector<uint8_t> input_data(runner.input_frame_size());
 
-        // Postprocess
-        postprocess_inception_v3(roi, params);
+        if (argc == 2) {
+            // No images given: run one blank frame through the network
+            print_result(runner.classify(input_data.data()));
+        }
 
-        // Print results
-        for (auto obj : roi->get_objects()) {
-            if (obj->get_type() == HAILO_CLASSIFICATION) {
-                auto classification = std::dynamic_pointer_cast<HailoClassification>(obj);
-                std::cout << "Label: " << classification->get_label() 
-                          << ", Confidence: " << classification->get_confidence() << std::endl;
+        // Decode and resize each image into the input tensor, then preprocess,
+        // run inference and postprocess
+        InceptionV3Frame decoded;
+        for (int i = 2; i < argc; i++) {
+            load_image_tensor(argv[i], input_info.shape.width, input_info.shape.height, input_data.data(), decoded);
+            std::cout << argv[i] << ": ";
+            auto result = runner.classify(input_data.data());
+            if (!result.valid) {
+                std::cout << "below threshold\n";
+                continue;
             }
+            print_result(result);
         }
 
         // Cleanup
@@ -70,4 +429,4 @@ int main(int argc, char *argv[])
     }
 
     return 0;
-}
\ No newline at end of file
+}